@@ -0,0 +1,206 @@
+/* Formatting benchmarks, comparing ostd::format with snprintf and
+ * std::ostringstream.
+ *
+ * Every case formats the same output with each method, as many times as
+ * fits into the given time (the first argument, in milliseconds), and
+ * reports the time per call and the output throughput. ostd::format and
+ * snprintf write into the same fixed stack buffer, so no allocation is
+ * measured; the string stream is reused between calls.
+ *
+ * This file is part of libostd. See COPYING.md for futher information.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <chrono>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <tuple>
+#include <vector>
+
+#include <ostd/format.hh>
+#include <ostd/io.hh>
+
+using namespace ostd;
+
+using bench_clock = std::chrono::steady_clock;
+
+/* keeps the results alive, so the calls are not optimized out */
+static std::size_t bench_sink = 0;
+
+static double bench_ms = 250.0;
+
+template<typename F>
+static void bench_run(char const *name, char const *method, F func) {
+    std::size_t nops = 0, nbytes = 0, batch = 64;
+    auto beg = bench_clock::now();
+    double el;
+    for (;;) {
+        for (std::size_t i = 0; i < batch; ++i) {
+            nbytes += func(nops + i);
+        }
+        nops += batch;
+        el = std::chrono::duration<double, std::milli>(
+            bench_clock::now() - beg
+        ).count();
+        if (el >= bench_ms) {
+            break;
+        }
+        batch *= 2;
+    }
+    bench_sink += nbytes;
+    double ns = (el * 1e6) / double(nops);
+    double mbs = (double(nbytes) / (1 << 20)) / (el / 1000.0);
+    writefln("%-12s %-14s %10.1f ns/op %10.1f MiB/s", name, method, ns, mbs);
+}
+
+static char bench_buf[4096];
+
+template<typename ...A>
+static std::size_t bench_ostd(string_range fmt, A const &...args) {
+    return format_to_n(bench_buf, sizeof(bench_buf), fmt, args...).size;
+}
+
+template<typename ...A>
+static std::size_t bench_printf(char const *fmt, A const &...args) {
+    return std::size_t(
+        std::snprintf(bench_buf, sizeof(bench_buf), fmt, args...)
+    );
+}
+
+static std::ostringstream bench_oss;
+
+template<typename F>
+static std::size_t bench_stream(F func) {
+    bench_oss.str(std::string{});
+    bench_oss.clear();
+    func(bench_oss);
+    return std::size_t(bench_oss.tellp());
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        bench_ms = std::atof(argv[1]);
+    }
+
+    std::vector<int> ints;
+    std::vector<double> floats;
+    for (int i = 0; i < 256; ++i) {
+        ints.push_back((i * 7919) ^ (i << 13));
+        floats.push_back((i * 7919) / 1000.0 - 100.0);
+    }
+    auto iv = [&ints](std::size_t i) { return ints[i & 255]; };
+    auto fv = [&floats](std::size_t i) { return floats[i & 255]; };
+
+    bench_run("int", "ostd::format", [&](std::size_t i) {
+        return bench_ostd("%d", iv(i));
+    });
+    bench_run("int", "snprintf", [&](std::size_t i) {
+        return bench_printf("%d", iv(i));
+    });
+    bench_run("int", "ostringstream", [&](std::size_t i) {
+        return bench_stream([&](auto &os) { os << iv(i); });
+    });
+
+    bench_run("float", "ostd::format", [&](std::size_t i) {
+        return bench_ostd("%f", fv(i));
+    });
+    bench_run("float", "snprintf", [&](std::size_t i) {
+        return bench_printf("%f", fv(i));
+    });
+    bench_run("float", "ostringstream", [&](std::size_t i) {
+        return bench_stream([&](auto &os) {
+            os << std::fixed << std::setprecision(6) << fv(i);
+        });
+    });
+
+    bench_run("string", "ostd::format", [&](std::size_t) {
+        return bench_ostd("name: %s, value: %s", "some key", "some value");
+    });
+    bench_run("string", "snprintf", [&](std::size_t) {
+        return bench_printf("name: %s, value: %s", "some key", "some value");
+    });
+    bench_run("string", "ostringstream", [&](std::size_t) {
+        return bench_stream([&](auto &os) {
+            os << "name: " << "some key" << ", value: " << "some value";
+        });
+    });
+
+    bench_run("padded", "ostd::format", [&](std::size_t i) {
+        return bench_ostd("|%-16s|%10d|%12.3f|", "field", iv(i), fv(i));
+    });
+    bench_run("padded", "snprintf", [&](std::size_t i) {
+        return bench_printf("|%-16s|%10d|%12.3f|", "field", iv(i), fv(i));
+    });
+    bench_run("padded", "ostringstream", [&](std::size_t i) {
+        return bench_stream([&](auto &os) {
+            os << '|' << std::left << std::setw(16) << "field" << '|'
+               << std::right << std::setw(10) << iv(i) << '|'
+               << std::fixed << std::setprecision(3) << std::setw(12)
+               << fv(i) << '|';
+        });
+    });
+    bench_run("padded", "OSTD_FMT", [&](std::size_t i) {
+        return format_to_n(
+            bench_buf, sizeof(bench_buf),
+            OSTD_FMT("|%-16s|%10d|%12.3f|"), "field", iv(i), fv(i)
+        ).size;
+    });
+
+    std::vector<std::vector<int>> nested{
+        {1, 2, 3, 4}, {5, 6, 7, 8}, {9, 10, 11, 12}, {13, 14, 15, 16}
+    };
+    bench_run("range", "ostd::format", [&](std::size_t) {
+        return bench_ostd("[%([%(%d, %)]%|, %)]", nested);
+    });
+    bench_run("range", "snprintf", [&](std::size_t) {
+        std::size_t n = 0;
+        auto put = [&n](char const *fmt, auto ...args) {
+            n += std::size_t(std::snprintf(
+                bench_buf + n, sizeof(bench_buf) - n, fmt, args...
+            ));
+        };
+        put("[");
+        for (std::size_t j = 0; j < nested.size(); ++j) {
+            put(j ? ", [" : "[");
+            for (std::size_t k = 0; k < nested[j].size(); ++k) {
+                put(k ? ", %d" : "%d", nested[j][k]);
+            }
+            put("]");
+        }
+        put("]");
+        return n;
+    });
+    bench_run("range", "ostringstream", [&](std::size_t) {
+        return bench_stream([&](auto &os) {
+            os << '[';
+            for (std::size_t j = 0; j < nested.size(); ++j) {
+                os << (j ? ", [" : "[");
+                for (std::size_t k = 0; k < nested[j].size(); ++k) {
+                    if (k) {
+                        os << ", ";
+                    }
+                    os << nested[j][k];
+                }
+                os << ']';
+            }
+            os << ']';
+        });
+    });
+
+    bench_run("tuple", "ostd::format", [&](std::size_t i) {
+        return bench_ostd("%s", std::make_tuple(iv(i), "text", 'c'));
+    });
+    bench_run("tuple", "snprintf", [&](std::size_t i) {
+        return bench_printf("<%d, %s, %c>", iv(i), "text", 'c');
+    });
+    bench_run("tuple", "ostringstream", [&](std::size_t i) {
+        return bench_stream([&](auto &os) {
+            os << '<' << iv(i) << ", " << "text" << ", " << 'c' << '>';
+        });
+    });
+
+    return (bench_sink == 0);
+}
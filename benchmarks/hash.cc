@@ -0,0 +1,121 @@
+/* Hashing benchmarks, comparing ostd::fast_hash with std::hash.
+ *
+ * The first group of cases hashes keys of a fixed size, as many times as
+ * fits into the given time (the first argument, in milliseconds), and
+ * reports the time per call and the throughput. The second group fills
+ * and queries std::unordered_set with short keys using each hasher, and
+ * the last one hashes a large buffer in pieces with ostd::hash_state.
+ *
+ * This file is part of libostd. See COPYING.md for futher information.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_set>
+#include <functional>
+#include <algorithm>
+
+#include <ostd/hash.hh>
+#include <ostd/format.hh>
+#include <ostd/io.hh>
+
+using namespace ostd;
+
+using bench_clock = std::chrono::steady_clock;
+
+/* keeps the results alive, so the calls are not optimized out */
+static std::size_t bench_sink = 0;
+
+static double bench_ms = 250.0;
+
+template<typename F>
+static void bench_run(char const *name, char const *method, F func) {
+    std::size_t nops = 0, nbytes = 0, batch = 64;
+    auto beg = bench_clock::now();
+    double el;
+    for (;;) {
+        for (std::size_t i = 0; i < batch; ++i) {
+            nbytes += func(nops + i);
+        }
+        nops += batch;
+        el = std::chrono::duration<double, std::milli>(
+            bench_clock::now() - beg
+        ).count();
+        if (el >= bench_ms) {
+            break;
+        }
+        batch *= 2;
+    }
+    double ns = (el * 1e6) / double(nops);
+    double mbs = (double(nbytes) / (1 << 20)) / (el / 1000.0);
+    writefln("%-12s %-14s %10.1f ns/op %10.1f MiB/s", name, method, ns, mbs);
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        bench_ms = std::atof(argv[1]);
+    }
+
+    std::vector<char> data(1 << 20);
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = char((i * 7919) ^ (i >> 5));
+    }
+
+    fast_hash fh;
+    std::hash<std::string_view> sh;
+    for (std::size_t len: {4, 8, 16, 32, 64, 256, 4096, 65536}) {
+        auto name = format(appender<std::string>(), "%d bytes", len).get();
+        /* vary the start, so the keys are not all the same */
+        std::size_t mask = (data.size() - len - 1) & ~std::size_t(63);
+        bench_run(name.data(), "ostd", [&](std::size_t i) {
+            std::string_view v{data.data() + ((i * 64) & mask), len};
+            bench_sink += fh(v);
+            return len;
+        });
+        bench_run(name.data(), "std", [&](std::size_t i) {
+            std::string_view v{data.data() + ((i * 64) & mask), len};
+            bench_sink += sh(v);
+            return len;
+        });
+    }
+
+    std::vector<std::string> keys;
+    for (std::size_t i = 0; i < 100000; ++i) {
+        keys.push_back(format(appender<std::string>(), "key_%d", i).get());
+    }
+    auto bench_set = [&keys](auto set) {
+        return [&keys, set](std::size_t i) mutable {
+            auto &k = keys[i % keys.size()];
+            if (i < keys.size()) {
+                set.insert(k);
+            } else {
+                bench_sink += set.count(k);
+            }
+            return k.size();
+        };
+    };
+    bench_run(
+        "set", "ostd", bench_set(std::unordered_set<std::string, fast_hash>{})
+    );
+    bench_run(
+        "set", "std", bench_set(std::unordered_set<std::string>{})
+    );
+
+    bench_run("stream", "hash_state", [&data](std::size_t) {
+        hash_state st;
+        for (std::size_t i = 0; i < data.size(); i += 1000) {
+            std::size_t n = std::min(data.size() - i, std::size_t(1000));
+            st.update(data.data() + i, n);
+        }
+        bench_sink += st.digest();
+        return data.size();
+    });
+
+    return (bench_sink == 0);
+}
@@ -137,6 +137,23 @@ int main() {
     format(s, "hello %s", "world");
     writeln(s.get());
 
+    /* format strings can also be parsed at compile time, which checks
+     * them against the arguments during compilation; using "%d" with
+     * a string argument here would fail to compile
+     */
+    writeln("\n-- compile-time format string --");
+    writefln(OSTD_FMT("%s has %d items"), "the vector", x.size());
+
+    /* formatting into a fixed buffer never writes past its end, but
+     * still reports how long the whole output would be
+     */
+    writeln("\n-- format into a fixed buffer --");
+    char fbuf[8];
+    auto fr = format_to_n(fbuf, sizeof(fbuf), "hello %s", "world");
+    writefln(
+        "%s (%d of %d)", string_range{fbuf, fr.out}, fr.out - fbuf, fr.size
+    );
+
     /* locale specific formatting */
     writeln("\n-- number format with C locale --");
     writefln(
@@ -207,6 +224,12 @@ Foo_i_esc
 -- format into a string --
 hello world
 
+-- compile-time format string --
+the vector has 4 items
+
+-- format into a fixed buffer --
+hello wo (8 of 11)
+
 -- number format with C locale --
 "123456789", "12345.678912", "123456789ABCDEF"
 
@@ -9,6 +9,7 @@
 #include <ostd/range.hh>
 #include <ostd/io.hh>
 #include <ostd/algorithm.hh>
+#include <ostd/parallel.hh>
 
 using namespace ostd;
 
@@ -93,4 +94,21 @@ int main() {
 
     std::vector<int> test{vr.iter_begin(), vr.iter_end()};
     writeln(test);
+
+    /* stages running on a thread pool - prints 0, 1, 4, 9 ... 81 each on
+     * new line, squared by two workers while the input is produced by a
+     * third one
+     */
+    writeln("parallel stages");
+
+    thread_pool tp;
+    tp.start(3);
+
+    auto pr = range(10)
+        | stage  (tp)
+        | par_map(tp, [](int v) { return v * v; }, 2);
+
+    for (int i: pr) {
+        writeln(i);
+    }
 }
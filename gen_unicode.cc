@@ -12,6 +12,9 @@
 #include <ctime>
 #include <vector>
 #include <array>
+#include <map>
+#include <tuple>
+#include <iterator>
 #include <stdexcept>
 #include <initializer_list>
 
@@ -61,17 +64,12 @@ struct parse_state {
 
     void parse_line(string_range line) {
         std::array<string_range, 15> bits;
-        for (std::size_t n = 0;;) {
-            auto sc = ostd::find(line, ';');
-            if (!sc) {
-                assert_line(n >= (bits.size() - 1));
-                bits[n] = line;
-                break;
-            }
-            bits[n++] = line.slice(0, std::size_t(sc.data() - line.data()));
-            sc.pop_front();
-            line = sc;
+        std::size_t nbits = 0;
+        for (auto bit: ostd::split(line, ';')) {
+            assert_line(nbits < bits.size());
+            bits[nbits++] = bit;
         }
+        assert_line(nbits >= (bits.size() - 1));
         assert_line(!bits[0].empty() && (bits[2].size() == 2));
         code_t n = hex_to_code(bits[0]);
         /* control chars */
@@ -117,145 +115,194 @@ struct parse_state {
         /* good enough for now, ignore the rest */
     }
 
+    /* the properties of a code point; the case mappings are deltas, so that
+     * the same record can be shared by whole runs of letters
+     */
+    struct record {
+        unsigned flags = 0;
+        std::int32_t tolower = 0;
+        std::int32_t toupper = 0;
+
+        bool operator<(record const &o) const {
+            return std::tie(flags, tolower, toupper) <
+                   std::tie(o.flags, o.tolower, o.toupper);
+        }
+    };
+
+    /* flag names in the generated table, by bit */
+    static constexpr char const *flag_names[] = {
+        "ALPHA", "CNTRL", "DIGIT", "LOWER", "SPACE", "TITLE", "UPPER"
+    };
+
+    /* 256 code points per block in the second stage, so the first block
+     * covers Latin-1 and can be indexed directly
+     */
+    static constexpr code_t block_bits = 8;
+    static constexpr code_t block_size = code_t(1) << block_bits;
+
     template<typename R>
-    void build(
-        R &writer, string_range name,
-        code_vec const &codes,
-        string_range cname = string_range{},
-        code_vec const &cases = code_vec{}
+    void build_list(
+        R &writer, string_range type, string_range name,
+        std::vector<std::size_t> const &vals
     ) {
-        code_vec singles;
-        code_vec singles_cases;
-        code_vec ranges_beg;
-        code_vec ranges_end;
-        code_vec ranges_cases;
-        code_vec laces_beg[2];
-        code_vec laces_end[2];
-
-        if (!cases.empty() && (cases.size() != codes.size())) {
-            throw std::runtime_error{"mismatched code lists"};
+        format(
+            writer, "static %s const %s[%d] = {", type, name, vals.size()
+        );
+        for (std::size_t i = 0; i < vals.size(); ++i) {
+            if (!(i % 16)) {
+                format(writer, "\n   ");
+            }
+            format(writer, " %d,", vals[i]);
         }
+        format(writer, "\n};\n\n");
+    }
 
-        auto match_pair = [&codes](std::size_t i, std::size_t off) {
-            return (
-                ((i + 1) < codes.size()) && (codes[i + 1] == (codes[i] + off))
-            );
-        };
-        auto match_range = [&cases, &match_pair](std::size_t i) {
-            return match_pair(i, 1) && (
-                cases.empty() || (cases[i + 1] == (cases[i] + 1))
-            );
-        };
-        auto match_lace = [
-            &codes, &cases, &match_pair
-        ](std::size_t i, std::size_t offs) {
-            int off = (!int(offs) * 2) - 1;
-            return match_pair(i, 2) && (cases.empty() || (
-                (cases[i + 1] == code_t(std::int32_t(codes[i + 1]) + off)) &&
-                (cases[i    ] == code_t(std::int32_t(codes[i    ]) + off))
-            ));
+    template<typename R>
+    void build(R &writer) {
+        std::vector<record> props(std::size_t(utf::max_unicode) + 1);
+
+        auto set_flag = [&props](code_vec const &codes, unsigned bit) {
+            for (code_t c: codes) {
+                props[c].flags |= (1U << bit);
+            }
         };
+        set_flag(alphas, 0);
+        set_flag(controls, 1);
+        set_flag(digits, 2);
+        set_flag(lowers, 3);
+        set_flag(spaces, 4);
+        set_flag(titles, 5);
+        set_flag(uppers, 6);
 
-        bool endseq = false;
-        std::size_t i = 0;
-        std::size_t ncodes = codes.size();
-        while (i < ncodes) {
-            if (match_range(i)) {
-                ranges_beg.push_back(codes[i]);
-                if (!cases.empty()) {
-                    ranges_cases.push_back(cases[i]);
-                }
-                /* go to the end of sequence */
-                for (++i; match_range(i); ++i) {
-                    continue;
-                }
-                /* end of range, try others */
-                ranges_end.push_back(codes[i]);
-                endseq = true;
-                continue;
+        auto set_case = [&props](
+            code_vec const &codes, code_vec const &cases,
+            std::int32_t record::*delta
+        ) {
+            if (cases.size() != codes.size()) {
+                throw std::runtime_error{"mismatched code lists"};
             }
-            if (size_t j = 0; match_lace(i, j) || match_lace(i, ++j)) {
-                laces_beg[j].push_back(codes[i]);
-                for (++i; match_lace(i, j); ++i) {
-                    continue;
-                }
-                laces_end[j].push_back(codes[i]);
-                endseq = true;
-                continue;
+            for (std::size_t i = 0; i < codes.size(); ++i) {
+                props[codes[i]].*delta =
+                    std::int32_t(cases[i]) - std::int32_t(codes[i]);
             }
-            if (!endseq) {
-                singles.push_back(codes[i]);
-                if (!cases.empty()) {
-                    singles_cases.push_back(cases[i]);
+        };
+        set_case(uppers, tolowers, &record::tolower);
+        set_case(lowers, touppers, &record::toupper);
+
+        /* deduplicate the records, the empty one goes first */
+        std::map<record, std::size_t> rec_map{{record{}, 0}};
+        std::vector<record> recs{record{}};
+        /* deduplicate the blocks of record indexes, in order of appearance
+         * so that the first block is the first one in the table
+         */
+        std::map<std::vector<std::size_t>, std::size_t> blk_map;
+        std::vector<std::size_t> blocks;
+        std::vector<std::size_t> stage1;
+        for (std::size_t b = 0; b < props.size(); b += block_size) {
+            std::vector<std::size_t> blk;
+            for (std::size_t i = b; i < (b + block_size); ++i) {
+                auto [it, added] = rec_map.emplace(props[i], recs.size());
+                if (added) {
+                    recs.push_back(props[i]);
                 }
+                blk.push_back(it->second);
             }
-            endseq = false;
-            ++i;
+            auto [it, added] = blk_map.emplace(blk, blk_map.size());
+            if (added) {
+                blocks.insert(blocks.end(), blk.begin(), blk.end());
+            }
+            stage1.push_back(it->second);
         }
 
-        auto build_list = [&writer, &name](
-            string_range aname, std::size_t ncol,
-            code_vec const &col1, code_vec const &col2, code_vec const &col3
-        ) {
-            if (col1.empty()) {
-                return;
-            }
-            format(
-                writer, "static char32_t const %s_%s[][%d] = {\n",
-                name, aname, ncol
-            );
-            for (std::size_t j = 0; j < col1.size(); ++j) {
-                switch (ncol) {
-                    case 1:
-                        format(writer, "    { 0x%06X },\n", col1[j]);
-                        break;
-                    case 2:
-                        format(
-                            writer, "    { 0x%06X, 0x%06X },\n",
-                            col1[j], col2[j]
-                        );
-                        break;
-                    case 3:
-                        format(
-                            writer, "    { 0x%06X, 0x%06X, 0x%06X },\n",
-                            col1[j], col2[j], col3[j]
-                        );
-                        break;
-                    default:
-                        throw std::runtime_error{"invalid column number"};
-                        break;
-                }
-            }
-            format(writer, "};\n\n");
+        auto index_type = [](std::size_t n) {
+            return (n <= 0x100) ? "std::uint8_t" : "std::uint16_t";
         };
 
-        if (cases.empty()) {
-            format(writer, "\n/* is%s */\n\n", name);
-        } else {
-            format(writer, "\n/* is%s, to%s */\n\n", name, cname);
+        format(writer,
+            "\n"
+            "/* The character types are looked up in two stages: the code\n"
+            " * point without its low %d bits indexes the first stage, which\n"
+            " * gives a block of the second stage, and the low bits index the\n"
+            " * block, which gives a record with the properties and the case\n"
+            " * mapping deltas. Identical blocks and records are shared. The\n"
+            " * first block covers Latin-1 and is indexed directly.\n"
+            " */\n\n",
+            block_bits
+        );
+
+        format(writer, "enum: std::uint8_t {\n");
+        for (std::size_t i = 0; i < std::size(flag_names); ++i) {
+            format(writer, "    UCTYPE_%s = 1 << %d,\n", flag_names[i], i);
         }
+        format(writer, "};\n\n");
 
-        build_list(
-            "ranges", !cases.empty() + 2, ranges_beg, ranges_end, ranges_cases
+        format(writer,
+            "struct uctype_rec {\n"
+            "    std::uint8_t flags;\n"
+            "    std::int32_t tolower;\n"
+            "    std::int32_t toupper;\n"
+            "};\n\n"
+        );
+
+        format(
+            writer, "static uctype_rec const uctype_records[%d] = {\n",
+            recs.size()
         );
-        build_list("laces1", 2, laces_beg[0], laces_end[0], laces_beg[0]);
-        build_list("laces2", 2, laces_beg[1], laces_end[1], laces_beg[1]);
+        for (auto const &rec: recs) {
+            format(writer, "    { ");
+            if (!rec.flags) {
+                format(writer, "0");
+            }
+            for (std::size_t i = 0, n = 0; i < std::size(flag_names); ++i) {
+                if (rec.flags & (1U << i)) {
+                    format(
+                        writer, "%sUCTYPE_%s", n++ ? " | " : "", flag_names[i]
+                    );
+                }
+            }
+            format(writer, ", %d, %d },\n", rec.tolower, rec.toupper);
+        }
+        format(writer, "};\n\n");
+
+        build_list(writer, index_type(recs.size()), "uctype_blocks", blocks);
         build_list(
-            "singles", !cases.empty() + 1, singles, singles_cases, singles
+            writer, index_type(blk_map.size()), "uctype_stage1", stage1
         );
 
-        /* is_CTYPE(c) */
-        build_func(
-            writer, name, name, "is", "bool",
-            ranges_beg, laces_beg[0], laces_beg[1], singles
+        format(writer,
+            "static inline uctype_rec const &uctype_get(char32_t c) "
+            "noexcept {\n"
+            "    if (c < 0x%X) {\n"
+            "        return uctype_records[uctype_blocks[c]];\n"
+            "    }\n"
+            "    if (c > utf::max_unicode) {\n"
+            "        return uctype_records[0];\n"
+            "    }\n"
+            "    return uctype_records[uctype_blocks[\n"
+            "        (std::size_t(uctype_stage1[c >> %d]) << %d) | (c & 0x%X)\n"
+            "    ]];\n"
+            "}\n",
+            block_size, block_bits, block_bits, block_size - 1
         );
 
-        /* to_CTYPE(c) */
-        if (!cases.empty()) {
-            writer.put('\n');
-            build_func(
-                writer, name, cname, "to", "char32_t",
-                ranges_beg, laces_beg[0], laces_beg[1], singles
+        for (std::size_t i = 0; i < std::size(flag_names); ++i) {
+            char lname[16] = {};
+            for (std::size_t j = 0; flag_names[i][j]; ++j) {
+                lname[j] = char(std::tolower(flag_names[i][j]));
+            }
+            format(writer,
+                "\nOSTD_EXPORT bool is%s(char32_t c) noexcept {\n"
+                "    return (uctype_get(c).flags & UCTYPE_%s);\n"
+                "}\n",
+                static_cast<char const *>(lname), flag_names[i]
+            );
+        }
+        for (string_range fname: { "tolower", "toupper" }) {
+            format(writer,
+                "\nOSTD_EXPORT char32_t %s(char32_t c) noexcept {\n"
+                "    return char32_t(c + char32_t(uctype_get(c).%s));\n"
+                "}\n",
+                fname, fname
             );
         }
     }
@@ -272,54 +319,6 @@ struct parse_state {
         );
     }
 
-    template<typename R>
-    void build_func(
-        R &writer,
-        string_range name,
-        string_range fname,
-        string_range prefix,
-        string_range ret_type,
-        code_vec const &ranges,
-        code_vec const &laces1,
-        code_vec const &laces2,
-        code_vec const &singles
-    ) {
-        format(
-            writer, "OSTD_EXPORT %s %s%s(char32_t c) noexcept {\n",
-            ret_type, prefix, fname
-        );
-        format(writer, "    return utf::uctype_func<\n");
-        auto it1 = { &ranges, &laces1, &laces2, &singles };
-        auto it2 = { "ranges", "laces1", "laces2", "singles" };
-        for (std::size_t i = 0; i < it1.size(); ++i) {
-            if (it1.begin()[i]->empty()) {
-                format(writer, "        0, 0");
-            } else {
-                format(
-                    writer, "        sizeof(%s_%s), sizeof(*%s_%s)",
-                    name, it2.begin()[i], name, it2.begin()[i]
-                );
-            }
-            if ((i + 1) != it1.size()) {
-                format(writer, ",\n");
-            } else {
-                format(writer, "\n");
-            }
-        }
-        format(writer, "    >::do_%s(\n        c, ", prefix);
-        for (std::size_t i = 0; i < it1.size(); ++i) {
-            if (i != 0) {
-                format(writer, ", ");
-            }
-            if (it1.begin()[i]->empty()) {
-                format(writer, "nullptr");
-            } else {
-                format(writer, "%s_%s", name, it2.begin()[i]);
-            }
-        }
-        format(writer, "\n    );\n}\n");
-    }
-
     template<typename R, typename IR>
     void build_all(R &writer, IR lines) {
             for (auto const &line: lines) {
@@ -327,14 +326,7 @@ struct parse_state {
             }
 
             build_header(writer);
-
-            build(writer, "alpha", alphas);
-            build(writer, "cntrl", controls);
-            build(writer, "digit", digits);
-            build(writer, "lower", lowers, "upper", touppers);
-            build(writer, "space", spaces);
-            build(writer, "title", titles);
-            build(writer, "upper", uppers, "lower", tolowers);
+            build(writer);
     }
 
     void build_all_from_file(string_range input, string_range output) {
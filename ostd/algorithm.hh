@@ -28,6 +28,7 @@
 
 #ifdef OSTD_BUILD_TESTS
 #include <vector>
+#include <stdexcept>
 #endif
 
 #include <ostd/range.hh>
@@ -139,6 +140,25 @@ OSTD_UNIT_TEST {
     fail_if_not(iter(v1) | is_partitioned([](int &i) { return i < 15; }));
     fail_if_not(is_partitioned(iter(v2), [](int &i) { return i < 15; }));
     fail_if_not(iter(v2) | is_partitioned([](int &i) { return i < 15; }));
+    /* contiguous sources and destinations are put in one go */
+    std::vector<int> src = { 1, 2, 3, 4, 5 };
+    auto app = appender<std::vector<int>>();
+    range_put_all(app, iter(src));
+    fail_if(app.get() != src);
+    std::vector<int> dst(7);
+    auto rest = iter(dst);
+    range_put_all(rest, iter(src));
+    fail_if(rest.size() != 2 || dst[0] != 1 || dst[4] != 5 || dst[5]);
+    /* what fits is written before throwing */
+    std::vector<int> small(3);
+    bool thrown = false;
+    try {
+        auto r = iter(small);
+        range_put_all(r, iter(src));
+    } catch (std::out_of_range const &) {
+        thrown = true;
+    }
+    fail_if(!thrown || small[2] != 3);
 }
 #endif
 
@@ -934,7 +954,8 @@ inline auto equal(InputRange &&range) {
  * The `irange` is at least ostd::input_range_tag. The `orange` is
  * an output range. The ostd::range_put_all() function is used to
  * perform the copy. it respects ADL and therefore any per-type
- * overloads of ostd::range_put_all.
+ * overloads of ostd::range_put_all. Contiguous ranges of values are
+ * copied with a single `put_n` call where `orange` supports it.
  *
  * @see ostd::copy_if(), ostd::copy_if_not()
  */
@@ -0,0 +1,270 @@
+/** @addtogroup Streams
+ * @{
+ */
+
+/** @file compressed_stream.hh
+ *
+ * @brief Stream adapters for compressed data.
+ *
+ * This file implements a stream that wraps any other ostd::stream and
+ * transparently compresses everything written into it or decompresses
+ * everything read from it. This makes it possible to use the usual stream
+ * utilities such as ostd::stream::iter_lines() directly over compressed
+ * data, without spawning external tools.
+ *
+ * ~~~{.cc}
+ * ostd::file_stream f{"build.log.gz"};
+ * ostd::compressed_stream zs{f, ostd::compression_format::GZIP};
+ * for (auto const &line: zs.iter_lines()) {
+ *     ostd::writeln(line);
+ * }
+ * ~~~
+ *
+ * The available formats depend on the libraries found when libostd was
+ * built; gzip, zlib and raw deflate need zlib, zstd needs libzstd. Use
+ * ostd::compressed_stream::is_supported() to check at runtime.
+ *
+ * @copyright See COPYING.md in the project tree for further information.
+ */
+
+#ifndef OSTD_COMPRESSED_STREAM_HH
+#define OSTD_COMPRESSED_STREAM_HH
+
+#include <ostd/unit_test.hh>
+
+#include <cstddef>
+
+#include <ostd/platform.hh>
+#include <ostd/stream.hh>
+
+#ifdef OSTD_BUILD_TESTS
+#include <string>
+#include <ostd/memory_stream.hh>
+#endif
+
+#define OSTD_TEST_MODULE libostd_compressed_stream
+
+namespace ostd {
+
+/** @addtogroup Streams
+ * @{
+ */
+
+/** @brief The compression format used by ostd::compressed_stream. */
+enum class compression_format {
+    GZIP = 0, ///< The gzip format (RFC 1952), as used by `gzip` and `zcat`.
+    ZLIB,     ///< The zlib format (RFC 1950).
+    DEFLATE,  ///< Raw deflate data (RFC 1951) without any header.
+    ZSTD      ///< The Zstandard format.
+};
+
+/** @brief A stream adapter compressing or decompressing another stream.
+ *
+ * The stream is opened either for reading, in which case compressed data
+ * is read from the wrapped stream and the decompressed data is returned
+ * from read_bytes(), or for writing, in which case everything written is
+ * compressed and written into the wrapped stream. Only ostd::stream_mode
+ * `READ` and `WRITE` are allowed.
+ *
+ * The adapter does not own the wrapped stream, so the wrapped stream has
+ * to stay alive for as long as the adapter is used. Closing the adapter
+ * does not close the wrapped stream.
+ *
+ * Both directions are buffered internally, so reading byte by byte (such
+ * as with ostd::stream::get_line()) does not cost a decompressor call per
+ * byte. When reading gzip data, concatenated members are decoded one after
+ * another like `zcat` does; the same applies to zstd frames.
+ *
+ * The stream is not seekable. The tell() method is supported though and
+ * returns the number of uncompressed bytes read or written so far.
+ */
+struct OSTD_EXPORT compressed_stream: stream {
+    /** @brief Creates an empty compressed stream.
+     *
+     * It has no associated stream; use open() to attach one.
+     */
+    compressed_stream() {}
+
+    /** @brief Creates a compressed stream over the given stream.
+     *
+     * Equivalent to default construction followed by open().
+     *
+     * @throws ostd::stream_error like open().
+     */
+    compressed_stream(
+        stream &base, compression_format fmt,
+        stream_mode mode = stream_mode::READ, int level = -1
+    ) {
+        open(base, fmt, mode, level);
+    }
+
+    compressed_stream(compressed_stream const &) = delete;
+    compressed_stream &operator=(compressed_stream const &) = delete;
+
+    /** @brief Calls close(), ignoring any errors.
+     *
+     * When writing, close the stream explicitly to be able to catch errors
+     * from writing the final compressed block.
+     */
+    ~compressed_stream();
+
+    /** @brief Attaches the adapter to a stream.
+     *
+     * The `level` is the compression level and only matters for writing.
+     * A negative value means the default level of the codec.
+     *
+     * @throws ostd::stream_error with ENOTSUP if the format is not
+     *         supported in this build, EINVAL on an invalid mode or if
+     *         already open, ENOMEM if the codec cannot be initialized.
+     */
+    void open(
+        stream &base, compression_format fmt,
+        stream_mode mode = stream_mode::READ, int level = -1
+    );
+
+    /** @brief Checks whether the adapter is attached to a stream. */
+    bool is_open() const { return p_state != nullptr; }
+
+    /** @brief Finishes the compressed stream and detaches it.
+     *
+     * When writing, the remaining data is compressed, the final block
+     * is written into the wrapped stream and the wrapped stream is flushed.
+     * Nothing is done when reading, other than freeing the codec state.
+     *
+     * @throws ostd::stream_error on write errors.
+     */
+    void close();
+
+    /** @brief Checks if the end of the decompressed data was reached.
+     *
+     * Like with files, this becomes true once a read hits the end.
+     */
+    bool end() const;
+
+    /** @brief Gets the number of uncompressed bytes read or written. */
+    offset_type tell() const;
+
+    /** @brief Flushes pending compressed data into the wrapped stream.
+     *
+     * Everything written so far becomes decodable from the wrapped stream.
+     * Flushing too often worsens the compression ratio. Has no effect when
+     * reading.
+     *
+     * @throws ostd::stream_error on write errors.
+     */
+    void flush();
+
+    /** @brief Reads and decompresses at most `count` bytes.
+     *
+     * @throws ostd::stream_error with EIO when the compressed data is
+     *         corrupt or truncated, or on read errors of the wrapped stream.
+     */
+    std::size_t read_bytes(void *buf, std::size_t count);
+
+    /** @brief Compresses and writes `count` bytes.
+     *
+     * @throws ostd::stream_error on write errors or when not writable.
+     */
+    void write_bytes(void const *buf, std::size_t count);
+
+    /** @brief Reads a single decompressed byte.
+     *
+     * @throws ostd::stream_error at the end of the stream.
+     */
+    int get_char();
+
+    /** @brief Checks whether a format is available in this build. */
+    static bool is_supported(compression_format fmt) noexcept;
+
+private:
+    void *p_state = nullptr;
+};
+
+#ifdef OSTD_BUILD_TESTS
+OSTD_UNIT_TEST {
+    using ostd::test::fail_if;
+    auto compress = [](compression_format fmt, std::string const &s) {
+        buffer_stream<> out;
+        compressed_stream zs{out, fmt, stream_mode::WRITE};
+        zs.write_bytes(s.data(), s.size());
+        zs.close();
+        return std::move(out).buffer();
+    };
+    auto decompress = [](compression_format fmt, std::string const &s) {
+        buffer_stream<> in{s};
+        compressed_stream zs{in, fmt};
+        std::string ret;
+        char buf[100];
+        for (std::size_t n; (n = zs.read_bytes(buf, sizeof(buf)));) {
+            ret.append(buf, n);
+        }
+        fail_if(!zs.end() || (zs.tell() != stream_off_t(ret.size())));
+        return ret;
+    };
+    auto truncated = [&decompress](compression_format fmt, std::string s) {
+        try {
+            decompress(fmt, s);
+        } catch (stream_error const &) {
+            return true;
+        }
+        return false;
+    };
+
+    /* large enough to need several rounds of the internal buffers */
+    std::string big;
+    for (int i = 0; i < 20000; ++i) {
+        big += "line ";
+        big += std::to_string(i * 7919);
+        big += '\n';
+    }
+
+    for (auto fmt: {
+        compression_format::GZIP, compression_format::ZLIB,
+        compression_format::DEFLATE, compression_format::ZSTD
+    }) {
+        if (!compressed_stream::is_supported(fmt)) {
+            continue;
+        }
+        fail_if(decompress(fmt, compress(fmt, "")) != "");
+        auto zbig = compress(fmt, big);
+        fail_if(zbig.size() >= big.size());
+        fail_if(decompress(fmt, zbig) != big);
+
+        /* lines are read across buffer boundaries */
+        buffer_stream<> in{zbig};
+        compressed_stream zs{in, fmt};
+        std::size_t nlines = 0;
+        for (auto const &l: zs.iter_lines()) {
+            fail_if(l.compare(0, 5, "line "));
+            ++nlines;
+        }
+        fail_if(nlines != 20000);
+
+        /* cut off at the end or in the middle */
+        fail_if(!truncated(fmt, zbig.substr(0, zbig.size() - 4)));
+        fail_if(!truncated(fmt, zbig.substr(0, zbig.size() / 2)));
+
+        /* gzip members and zstd frames can be concatenated */
+        if (
+            (fmt == compression_format::GZIP) ||
+            (fmt == compression_format::ZSTD)
+        ) {
+            auto multi = compress(fmt, "foo\nbar") + compress(fmt, "")
+                + compress(fmt, "\nbaz\n") + zbig;
+            fail_if(decompress(fmt, multi) != ("foo\nbar\nbaz\n" + big));
+            multi.resize(multi.size() - zbig.size() / 2);
+            fail_if(!truncated(fmt, multi));
+        }
+    }
+}
+#endif
+
+/** @} */
+
+} /* namespace ostd */
+
+#undef OSTD_TEST_MODULE
+
+#endif
+
+/** @} */
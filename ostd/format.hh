@@ -19,12 +19,17 @@
 #ifndef OSTD_FORMAT_HH
 #define OSTD_FORMAT_HH
 
+#include <ostd/unit_test.hh>
+
 #include <cstring>
 #include <cstddef>
 #include <climits>
 #include <cmath>
 #include <cctype>
 #include <climits>
+#include <tuple>
+#include <memory>
+#include <charconv>
 #include <utility>
 #include <stdexcept>
 #include <locale>
@@ -33,6 +38,12 @@
 #include <ostd/algorithm.hh>
 #include <ostd/string.hh>
 
+#ifdef OSTD_BUILD_TESTS
+#include <vector>
+#endif
+
+#define OSTD_TEST_MODULE libostd_format
+
 namespace ostd {
 
 /** @addtogroup Strings
@@ -166,6 +177,60 @@ namespace detail {
         0, 0, 0, 2, 8, 10, 16, 0
     };
 
+    static inline constexpr char const fmt_digits2[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+    /* writes the digits of a nonzero value backwards, ending at `end`,
+     * and returns the first digit; `specn` is the index into fmt_bases
+     * and `cmask` is 32 for lowercase hex digits
+     */
+    template<typename T>
+    inline char *fmt_write_digits(char *end, T val, int specn, char cmask) {
+        switch (specn) {
+            case 5:
+                /* decimal: two digits per division */
+                while (val >= 100) {
+                    auto i = std::size_t(val % 100) * 2;
+                    val /= 100;
+                    *--end = fmt_digits2[i + 1];
+                    *--end = fmt_digits2[i];
+                }
+                if (val >= 10) {
+                    auto i = std::size_t(val) * 2;
+                    *--end = fmt_digits2[i + 1];
+                    *--end = fmt_digits2[i];
+                } else {
+                    *--end = char('0' + val);
+                }
+                break;
+            case 6:
+                for (; val; val >>= 4) {
+                    *--end = char("0123456789ABCDEF"[val & 0xF] | cmask);
+                }
+                break;
+            case 4:
+                for (; val; val >>= 3) {
+                    *--end = char('0' + (val & 0x7));
+                }
+                break;
+            default:
+                for (; val; val >>= 1) {
+                    *--end = char('0' + (val & 0x1));
+                }
+                break;
+        }
+        return end;
+    }
+
     /* non-printable escapes up to 0x20 (space) */
     static inline constexpr char const *fmt_escapes[] = {
         "\\0"  , "\\x01", "\\x02", "\\x03", "\\x04", "\\x05",
@@ -188,6 +253,33 @@ namespace detail {
         return nullptr;
     }
 
+    /* writes up to n characters of val as UTF-8, with ASCII characters
+     * replaced by what esc returns for them unless that's null
+     */
+    template<typename R, typename C, typename F>
+    inline void write_escaped(
+        R &writer, basic_char_range<C const> val, std::size_t n, F esc
+    ) {
+        for (std::size_t i = 0; i < n; ++i) {
+            if (val.empty()) {
+                break;
+            }
+            C c = val.front();
+            if (c <= 0x7F) {
+                char const *e = esc(char(c));
+                if (e) {
+                    range_put_all(writer, string_range{e});
+                } else {
+                    writer.put(char(c));
+                }
+                val.pop_front();
+            } else if (!utf::encode<char>(writer, val)) {
+                utf::replace<char>(writer);
+                val.pop_front();
+            }
+        }
+    }
+
     /* retrieve width/precision */
     template<typename T, typename ...A>
     inline int get_arg_param(std::size_t idx, T const &val, A const &...args) {
@@ -327,9 +419,12 @@ namespace detail {
  * If it's longer, no truncation happens. A precision of 0 means that no
  * character is written for the value 0. For floats, it's the number of
  * digits to be written after decimal point or comma. When not specified,
- * it's 6. For strings, it's the maximum number of characters to be printed.
- * By default all characters are printed. When escaping strings, the quotes
- * are not counted into the precision and escape sequences count as a single
+ * it's 6, except for `s`, which then writes the shortest representation
+ * that reads back as the same value (with the C locale; other locales get
+ * the `g` format), and `a`, which then writes all digits. For strings,
+ * it's the maximum number of characters to be printed. By default all
+ * characters are printed. When escaping strings, the quotes are not
+ * counted into the precision and escape sequences count as a single
  * character.
  *
  * # Range formatting
@@ -471,6 +566,10 @@ namespace detail {
  * locale. This will affect formatting of decimal separators and thousands
  * grouping particularly.
  *
+ * With the C locale, numbers are formatted without looking up any locale
+ * facets, which makes that the fastest way to format them. Floats are then
+ * converted with `std::to_chars` when the standard library provides it.
+ *
  * # Errors
  *
  * If a specifier is not allowed for a value, ostd::format_error is thrown.
@@ -520,7 +619,7 @@ struct format_spec {
 
     /** @brief Parses the format string if constructed with one.
      *
-     * This reads the format string, writing each character of it into
+     * This reads the format string, writing the literal text into
      * `writer`, until it encounters a valid format specifier. It then
      * stops there and returns `true`. If no format specifier was read,
      * it returns `false`. When a format specifier is read, this structure
@@ -530,20 +629,27 @@ struct format_spec {
      */
     template<typename R>
     bool read_until_spec(R &writer) {
-        if (p_fmt.empty()) {
-            return false;
-        }
         while (!p_fmt.empty()) {
-            if (p_fmt.front() == '%') {
+            /* write out literal text in runs rather than per character */
+            auto *pct = static_cast<char const *>(
+                std::memchr(p_fmt.data(), '%', p_fmt.size())
+            );
+            if (!pct) {
+                range_put_all(writer, p_fmt);
+                p_fmt = p_fmt.slice(p_fmt.size());
+                return false;
+            }
+            std::size_t n = std::size_t(pct - p_fmt.data());
+            if (n) {
+                range_put_all(writer, p_fmt.slice(0, n));
+            }
+            p_fmt = p_fmt.slice(n + 1);
+            if (!p_fmt.empty() && (p_fmt.front() == '%')) {
+                writer.put('%');
                 p_fmt.pop_front();
-                if (p_fmt.front() == '%') {
-                    goto plain;
-                }
-                return read_spec();
+                continue;
             }
-    plain:
-            writer.put(p_fmt.front());
-            p_fmt.pop_front();
+            return read_spec();
         }
         return false;
     }
@@ -981,7 +1087,26 @@ private:
         if (left == bool(p_flags & FMT_FLAG_DASH)) {
             return;
         }
-        for (int w = p_width - int(n); --w >= 0; writer.put(c));
+        if (p_width > int(n)) {
+            write_fill(writer, std::size_t(p_width) - n, c);
+        }
+    }
+
+    /* padding goes in chunks into ranges that can take them */
+    template<typename R>
+    void write_fill(R &writer, std::size_t n, char c) const {
+        if constexpr(output_range_has_put_n<R, char>) {
+            char buf[32];
+            std::memset(buf, c, sizeof(buf));
+            for (; n > sizeof(buf); n -= sizeof(buf)) {
+                writer.put_n(buf, sizeof(buf));
+            }
+            writer.put_n(buf, n);
+        } else {
+            for (; n; --n) {
+                writer.put(c);
+            }
+        }
     }
 
     template<typename R>
@@ -1022,24 +1147,9 @@ private:
         write_spaces(writer, n, true);
         if (escape) {
             writer.put('"');
-            for (std::size_t i = 0; i < n; ++i) {
-                if (val.empty()) {
-                    break;
-                }
-                C c = val.front();
-                if (c <= 0x7F) {
-                    char const *esc = detail::escape_fmt_char(c, '"');
-                    if (esc) {
-                        range_put_all(writer, string_range{esc});
-                    } else {
-                        write_char_raw(writer, c);
-                    }
-                    val.pop_front();
-                } else if (!utf::encode<char>(writer, val)) {
-                    utf::replace<char>(writer);
-                    val.pop_front();
-                }
-            }
+            detail::write_escaped(writer, val, n, [](char c) {
+                return detail::escape_fmt_char(c, '"');
+            });
             writer.put('"');
         } else {
             if constexpr(std::is_same_v<utf::unicode_base_t<C>, char>) {
@@ -1090,9 +1200,11 @@ private:
     template<typename R, typename T>
     void write_int(R &writer, bool ptr, bool neg, T val) const {
         using UT = std::make_unsigned_t<T>;
-        /* binary representation is the longest */
+        /* binary representation is the longest; the digits are generated
+         * backwards from the end of the buffer, so [dig, end) is the number
+         */
         char buf[sizeof(T) * CHAR_BIT];
-        std::size_t ndig = 0;
+        char *end = buf + sizeof(buf), *dig = end;
 
         char isp = spec();
         if (isp == 's') {
@@ -1105,15 +1217,13 @@ private:
         /* 32 for lowercase variants, 0 for uppercase */
         char cmask = char((isp >= 'a') << 5);
 
-        UT base = UT(detail::fmt_bases[specn]);
         bool zeroval = !val;
         if (zeroval) {
-            ndig = 1;
-            buf[0] = '0';
+            *--dig = '0';
         } else {
             UT uval;
             if (neg) {
-                if (base != 10) {
+                if (specn != 5) {
                     uval = UT(val);
                     neg = false;
                 } else {
@@ -1122,11 +1232,9 @@ private:
             } else {
                 uval = UT(val);
             }
-            for (; uval; uval /= base) {
-                auto vb = char(uval % base);
-                buf[ndig++] = (vb + "70"[vb < 10]) | cmask;
-            }
+            dig = detail::fmt_write_digits(end, uval, specn, cmask);
         }
+        std::size_t ndig = std::size_t(end - dig);
 
         std::size_t tdig = ndig;
         if (has_precision()) {
@@ -1138,35 +1246,40 @@ private:
             }
         }
 
-        /* here starts the bullshit */
-        auto const &fac = std::use_facet<std::numpunct<wchar_t>>(p_loc);
-
         char tseps[MB_LEN_MAX];
-        int ntsep = detail::wc_to_mb_loc(fac.thousands_sep(), tseps, p_loc);
-
-        auto const &grp = fac.grouping();
-        auto grpp = reinterpret_cast<unsigned char const *>(grp.data());
-
+        int ntsep = 0;
+        unsigned char const *grpp = nullptr;
         std::size_t nseps = 0, sreps = 0;
         std::size_t total = tdig;
-        if (!ptr && (ntsep >= 0)) {
-            int cndig = int(ndig);
-            while (*grpp) {
-                cndig -= *grpp;
-                if (cndig > 0) {
-                    ++nseps;
-                    if (!grpp[1]) {
-                        ++sreps;
-                        continue;
+        /* the classic locale has no grouping, so skip the facets */
+        if (!ptr && (p_loc != std::locale::classic())) {
+            /* here starts the bullshit */
+            auto const &fac = std::use_facet<std::numpunct<wchar_t>>(p_loc);
+
+            ntsep = detail::wc_to_mb_loc(fac.thousands_sep(), tseps, p_loc);
+
+            auto const &grp = fac.grouping();
+            grpp = reinterpret_cast<unsigned char const *>(grp.data());
+
+            if (ntsep >= 0) {
+                int cndig = int(ndig);
+                while (*grpp) {
+                    cndig -= *grpp;
+                    if (cndig > 0) {
+                        ++nseps;
+                        if (!grpp[1]) {
+                            ++sreps;
+                            continue;
+                        }
+                    } else {
+                        break;
                     }
-                } else {
-                    break;
+                    ++grpp;
                 }
-                ++grpp;
+                total += nseps * std::size_t(ntsep);
             }
-            total += nseps * std::size_t(ntsep);
+            /* here ends the bullshit */
         }
-        /* here ends the bullshit */
 
         int fl = flags();
         bool lsgn = fl & FMT_FLAG_PLUS;
@@ -1199,30 +1312,32 @@ private:
         /* number itself (with potential thousands grouping) */
         if (total) {
             /* potential higher precision, no grouping applies */
-            for (std::size_t i = 0; i < (tdig - ndig); ++i) {
-                writer.put('0');
-            }
-            /* the rest of the number, with thousands grouping */
-            unsigned char grpn = *grpp;
-            for (std::size_t i = 0; i < ndig; ++i) {
-                if (nseps) {
-                    if (!grpn) {
-                        for (int j = 0; j < ntsep; ++j) {
-                            writer.put(tseps[j]);
+            write_fill(writer, tdig - ndig, '0');
+            if (!nseps) {
+                range_put_all(writer, string_range{dig, end});
+            } else {
+                /* the rest of the number, with thousands grouping */
+                unsigned char grpn = *grpp;
+                for (std::size_t i = 0; i < ndig; ++i) {
+                    if (nseps) {
+                        if (!grpn) {
+                            for (int j = 0; j < ntsep; ++j) {
+                                writer.put(tseps[j]);
+                            }
+                            if (sreps) {
+                                --sreps;
+                            } else {
+                                --grpp;
+                            }
+                            grpn = *grpp;
+                            --nseps;
                         }
-                        if (sreps) {
-                            --sreps;
-                        } else {
-                            --grpp;
+                        if (grpn) {
+                            --grpn;
                         }
-                        grpn = *grpp;
-                        --nseps;
-                    }
-                    if (grpn) {
-                        --grpn;
                     }
+                    writer.put(dig[i]);
                 }
-                writer.put(buf[ndig - i - 1]);
             }
         }
         write_spaces(writer, total + sign + (!!pfx * 2), false);
@@ -1237,6 +1352,14 @@ private:
             throw format_error{"cannot format floats with the given spec"};
         }
 
+#ifdef __cpp_lib_to_chars
+        /* the alternative form is left to num_put */
+        if (!(p_flags & FMT_FLAG_HASH) && (p_loc == std::locale::classic())) {
+            write_float_chars(writer, isp, val);
+            return;
+        }
+#endif
+
         /* null streambuf because it's only used to read flags etc */
         std::ios st{nullptr};
         st.imbue(p_loc);
@@ -1281,6 +1404,83 @@ private:
         );
     }
 
+#ifdef __cpp_lib_to_chars
+    /* floating point in the C locale, without any locale facets */
+    template<typename R, typename T>
+    void write_float_chars(R &writer, char isp, T val) const {
+        std::chars_format cfmt;
+        switch (isp | 32) {
+            case 'a': cfmt = std::chars_format::hex; break;
+            case 'e': cfmt = std::chars_format::scientific; break;
+            case 'f': cfmt = std::chars_format::fixed; break;
+            default: cfmt = std::chars_format::general; break;
+        }
+        /* large enough for anything but huge fixed or precise values */
+        char sbuf[128];
+        std::unique_ptr<char[]> hbuf;
+        char *buf = sbuf;
+        std::size_t bufs = sizeof(sbuf);
+        std::to_chars_result res;
+        for (;;) {
+            if (has_precision()) {
+                res = std::to_chars(buf, buf + bufs, val, cfmt, precision());
+            } else if ((isp == 's') || (cfmt == std::chars_format::hex)) {
+                /* shortest representation that reads back the same */
+                res = std::to_chars(buf, buf + bufs, val, cfmt);
+            } else {
+                res = std::to_chars(buf, buf + bufs, val, cfmt, 6);
+            }
+            if (res.ec == std::errc{}) {
+                break;
+            }
+            bufs *= 8;
+            hbuf = std::make_unique<char[]>(bufs);
+            buf = hbuf.get();
+        }
+
+        char *beg = buf;
+        bool neg = (*beg == '-');
+        beg += neg;
+        if (!(isp & 32)) {
+            for (char *p = beg; p != res.ptr; ++p) {
+                if ((*p >= 'a') && (*p <= 'z')) {
+                    *p ^= 32;
+                }
+            }
+        }
+
+        bool fin = std::isfinite(val);
+        char sign = '\0';
+        if (neg) {
+            sign = '-';
+        } else if (p_flags & FMT_FLAG_PLUS) {
+            sign = '+';
+        } else if (p_flags & FMT_FLAG_SPACE) {
+            sign = ' ';
+        }
+        bool pfx = fin && (cfmt == std::chars_format::hex);
+        /* zeroes only pad actual numbers, not infinities and nans */
+        bool zero = fin && (p_flags & FMT_FLAG_ZERO);
+        std::size_t len = std::size_t(res.ptr - beg) + !!sign + pfx * 2;
+
+        if (!zero) {
+            write_spaces(writer, len, true, ' ');
+        }
+        if (sign) {
+            writer.put(sign);
+        }
+        if (pfx) {
+            writer.put('0');
+            writer.put(char('x' ^ (isp & 32) ^ 32));
+        }
+        if (zero) {
+            write_spaces(writer, len, true, '0');
+        }
+        range_put_all(writer, string_range{beg, res.ptr});
+        write_spaces(writer, len, false);
+    }
+#endif
+
     template<typename R, typename T>
     void write_val(
         R &writer, [[maybe_unused]] bool escape, T const &val
@@ -1646,10 +1846,647 @@ inline R &&format(
     return format_spec{fmt, loc}.format(std::forward<R>(writer), args...);
 }
 
+/* compile-time format strings */
+namespace detail {
+    struct fmt_ct_item {
+        /* a literal slice of the format string when false */
+        bool is_spec = false;
+        std::size_t beg = 0, len = 0;
+
+        char spec = '\0';
+        int flags = 0;
+        int width = 0;
+        int precision = 0;
+        bool has_width = false;
+        bool has_precision = false;
+        bool arg_width = false;
+        bool arg_precision = false;
+
+        /* zero-based argument indexes */
+        std::size_t arg = 0;
+        std::size_t width_arg = 0;
+        std::size_t precision_arg = 0;
+    };
+
+    enum fmt_ct_error {
+        FMT_CT_OK = 0,
+        FMT_CT_BAD_SPEC,
+        FMT_CT_NO_ARG,
+        FMT_CT_BAD_PARAM,
+        FMT_CT_BAD_TYPE
+    };
+
+    template<std::size_t N>
+    struct fmt_ct_parsed {
+        fmt_ct_item items[N ? N : 1] = {};
+        std::size_t size = 0;
+        int error = FMT_CT_OK;
+        /* range and tuple specs are left to the runtime parser */
+        bool nested = false;
+    };
+
+    /* an upper bound for the number of items */
+    constexpr std::size_t fmt_ct_count(char const *s, std::size_t n) {
+        std::size_t ret = 1;
+        for (std::size_t i = 0; i < n; ++i) {
+            ret += 2 * (s[i] == '%');
+        }
+        return ret;
+    }
+
+    constexpr bool fmt_ct_isdigit(char c) {
+        return (c >= '0') && (c <= '9');
+    }
+
+    constexpr int fmt_ct_flag(char c) {
+        switch (c) {
+            case '-': return FMT_FLAG_DASH;
+            case '+': return FMT_FLAG_PLUS;
+            case '#': return FMT_FLAG_HASH;
+            case '@': return FMT_FLAG_AT;
+            case '0': return FMT_FLAG_ZERO;
+            case ' ': return FMT_FLAG_SPACE;
+            default: break;
+        }
+        return 0;
+    }
+
+    /* the same grammar as format_spec::read_spec, but anything the runtime
+     * parser would stop at is an error here
+     */
+    template<std::size_t N>
+    constexpr fmt_ct_parsed<N> fmt_ct_parse(char const *s, std::size_t n) {
+        fmt_ct_parsed<N> ret{};
+        std::size_t i = 0, lbeg = 0, argidx = 1;
+        auto at = [s, n](std::size_t j) { return (j < n) ? s[j] : '\0'; };
+        auto add_lit = [&ret](std::size_t b, std::size_t e) {
+            if (e > b) {
+                fmt_ct_item &it = ret.items[ret.size++];
+                it.beg = b;
+                it.len = e - b;
+            }
+        };
+        while (i < n) {
+            if (s[i] != '%') {
+                ++i;
+                continue;
+            }
+            add_lit(lbeg, i);
+            if (at(++i) == '%') {
+                lbeg = i++;
+                continue;
+            }
+            fmt_ct_item it{};
+            it.is_spec = true;
+            /* digits: either a position or flags + width */
+            std::size_t dbeg = i, ndig = 0;
+            for (; fmt_ct_isdigit(at(i)); ++i, ++ndig);
+            bool havepos = false;
+            std::size_t pos = 0;
+            if (at(i) == '$') {
+                for (std::size_t j = dbeg; j < i; ++j) {
+                    pos = pos * 10 + std::size_t(s[j] - '0');
+                    if (pos > 255) {
+                        break;
+                    }
+                }
+                if (!ndig || !pos || (pos > 255)) {
+                    ret.error = FMT_CT_BAD_SPEC;
+                    return ret;
+                }
+                havepos = true;
+                ++i;
+            }
+            std::size_t skipd = 0;
+            if (havepos || !ndig) {
+                for (; fmt_ct_flag(at(i)); ++i) {
+                    it.flags |= fmt_ct_flag(at(i));
+                }
+            } else {
+                for (; (skipd < ndig) && (s[dbeg + skipd] == '0'); ++skipd);
+                if (skipd) {
+                    it.flags |= FMT_FLAG_ZERO;
+                }
+                if (skipd == ndig) {
+                    for (; fmt_ct_flag(at(i)); ++i) {
+                        it.flags |= fmt_ct_flag(at(i));
+                    }
+                }
+            }
+            if (
+                ((at(i) == '(') || (at(i) == '<')) &&
+                (havepos || !(ndig - skipd))
+            ) {
+                ret.nested = true;
+                return ret;
+            }
+            /* width */
+            if (!havepos && ndig && (ndig - skipd)) {
+                for (std::size_t j = dbeg + skipd; j < (dbeg + ndig); ++j) {
+                    it.width = it.width * 10 + (s[j] - '0');
+                }
+                it.has_width = true;
+            } else if (fmt_ct_isdigit(at(i))) {
+                for (; fmt_ct_isdigit(at(i)); ++i) {
+                    it.width = it.width * 10 + (s[i] - '0');
+                }
+                it.has_width = true;
+            } else if (at(i) == '*') {
+                it.has_width = it.arg_width = true;
+                ++i;
+            }
+            /* precision */
+            if (at(i) == '.') {
+                ++i;
+                if (fmt_ct_isdigit(at(i))) {
+                    for (; fmt_ct_isdigit(at(i)); ++i) {
+                        it.precision = it.precision * 10 + (s[i] - '0');
+                    }
+                    it.has_precision = true;
+                } else if (at(i) == '*') {
+                    it.has_precision = it.arg_precision = true;
+                    ++i;
+                } else {
+                    ret.error = FMT_CT_BAD_SPEC;
+                    return ret;
+                }
+            }
+            /* the spec itself */
+            char c = at(i++);
+            if ((c < 'A') || (c > 'z') || !fmt_specs[c - 'A']) {
+                ret.error = FMT_CT_BAD_SPEC;
+                return ret;
+            }
+            it.spec = c;
+            /* argument positions, like format_spec::write_fmt */
+            if (!havepos) {
+                std::size_t argpos = argidx++;
+                if (it.arg_width) {
+                    it.width_arg = argpos - 1;
+                    argpos = argidx++;
+                }
+                if (it.arg_precision) {
+                    it.precision_arg = argpos - 1;
+                    argpos = argidx++;
+                }
+                it.arg = argpos - 1;
+            } else {
+                std::size_t argprec = it.arg_precision;
+                if (argprec) {
+                    if (pos <= 1) {
+                        ret.error = FMT_CT_NO_ARG;
+                        return ret;
+                    }
+                    it.precision_arg = pos - 2;
+                }
+                if (it.arg_width) {
+                    if (pos <= (argprec + 1)) {
+                        ret.error = FMT_CT_NO_ARG;
+                        return ret;
+                    }
+                    it.width_arg = pos - 2 - argprec;
+                }
+                if (pos > argidx) {
+                    argidx = pos + 1;
+                }
+                it.arg = pos - 1;
+            }
+            ret.items[ret.size++] = it;
+            lbeg = i;
+        }
+        add_lit(lbeg, n);
+        return ret;
+    }
+
+    /* which spec classes a type accepts, mirroring format_spec::write_val */
+    enum {
+        FMT_CT_S = 1 << 0,
+        FMT_CT_C = 1 << 1,
+        FMT_CT_INT = 1 << 2,
+        FMT_CT_FLOAT = 1 << 3,
+        FMT_CT_ANY = 0xF
+    };
+
+    template<typename T>
+    constexpr int fmt_ct_accepts() {
+        if constexpr(fmt_tofmt_test<T, decltype(noop_sink<char>())>) {
+            return FMT_CT_ANY;
+        } else if constexpr(
+            std::is_constructible_v<string_range, T const &> ||
+            std::is_constructible_v<u32string_range, T const &> ||
+            std::is_constructible_v<u16string_range, T const &> ||
+            std::is_constructible_v<wstring_range, T const &> ||
+            is_tuple_like<T> || iterable_test<T>
+        ) {
+            return FMT_CT_S;
+        } else if constexpr(std::is_same_v<T, bool>) {
+            return FMT_CT_S | FMT_CT_INT;
+        } else if constexpr(utf::is_character<T>) {
+            return FMT_CT_S | FMT_CT_C | FMT_CT_INT;
+        } else if constexpr(std::is_pointer_v<T> || std::is_integral_v<T>) {
+            return FMT_CT_S | FMT_CT_INT;
+        } else if constexpr(std::is_floating_point_v<T>) {
+            return FMT_CT_S | FMT_CT_FLOAT;
+        } else {
+            return 0;
+        }
+    }
+
+    constexpr int fmt_ct_spec_class(char c) {
+        switch (fmt_specs[c - 'A']) {
+            case 1: return FMT_CT_FLOAT;
+            case 2: return FMT_CT_C;
+            case 3: case 4: case 5: case 6: return FMT_CT_INT;
+            case 7: return FMT_CT_S;
+            default: break;
+        }
+        /* only custom objects take other specs */
+        return FMT_CT_ANY;
+    }
+
+    template<typename ...A, std::size_t N>
+    constexpr int fmt_ct_check(fmt_ct_parsed<N> const &p) {
+        if (p.error || p.nested) {
+            return p.error;
+        }
+        constexpr std::size_t nargs = sizeof...(A);
+        constexpr int accepts[] = {fmt_ct_accepts<A>()..., 0};
+        constexpr bool integral[] = {std::is_integral_v<A>..., false};
+        for (std::size_t i = 0; i < p.size; ++i) {
+            auto const &it = p.items[i];
+            if (!it.is_spec) {
+                continue;
+            }
+            if (
+                (it.arg >= nargs) ||
+                (it.arg_width && (it.width_arg >= nargs)) ||
+                (it.arg_precision && (it.precision_arg >= nargs))
+            ) {
+                return FMT_CT_NO_ARG;
+            }
+            if (
+                (it.arg_width && !integral[it.width_arg]) ||
+                (it.arg_precision && !integral[it.precision_arg])
+            ) {
+                return FMT_CT_BAD_PARAM;
+            }
+            int cl = fmt_ct_spec_class(it.spec);
+            if ((accepts[it.arg] & cl) != cl) {
+                return FMT_CT_BAD_TYPE;
+            }
+        }
+        return FMT_CT_OK;
+    }
+}
+
+/** @brief A format string parsed at compile time.
+ *
+ * Objects of this type are created with the #OSTD_FMT macro and can be
+ * used in place of format strings in ostd::format() and the `writef`
+ * family of functions of streams and standard output.
+ *
+ * The format string is split into literal text and format specifiers
+ * during compilation, and each specifier is checked against the type of
+ * its argument when the format call is compiled. Problems that would
+ * otherwise throw ostd::format_error at runtime, such as missing
+ * arguments, a string formatted with `%d` or a malformed specifier, are
+ * reported as compile errors instead. The formatting then runs through
+ * the pre-split items directly, with no parsing at runtime.
+ *
+ * Range and tuple specifiers (`%(...%)`, `%<...%>`) are not handled at
+ * compile time; format strings containing them are passed to the runtime
+ * formatter as is, without compile-time checks.
+ *
+ * @tparam S A type providing the string through static `data()` and
+ *           `size()` functions.
+ */
+template<typename S>
+struct static_format {
+    /** @brief Gets the format string. */
+    static string_range str() noexcept {
+        return string_range{S::data(), S::data() + S::size()};
+    }
+
+    /** @brief Formats into an output range.
+     *
+     * This is what ostd::format() calls when given a static_format.
+     *
+     * @throws ostd::format_error only for errors that depend on runtime
+     *         values, such as negative argument widths.
+     */
+    template<typename R, typename ...A>
+    R &&format(R &&writer, std::locale const &loc, A const &...args) const {
+        constexpr int err = detail::fmt_ct_check<A...>(parsed);
+        static_assert(err != detail::FMT_CT_BAD_SPEC, "invalid format spec");
+        static_assert(err != detail::FMT_CT_NO_ARG, "not enough format args");
+        static_assert(
+            err != detail::FMT_CT_BAD_PARAM,
+            "invalid argument for width/precision"
+        );
+        static_assert(
+            err != detail::FMT_CT_BAD_TYPE,
+            "argument cannot be formatted with the given spec"
+        );
+        if constexpr(parsed.nested) {
+            format_spec{str(), loc}.format(writer, args...);
+        } else {
+            write_items(
+                writer, loc, std::make_index_sequence<parsed.size>{}, args...
+            );
+        }
+        return std::forward<R>(writer);
+    }
+
+private:
+    static constexpr auto parsed = detail::fmt_ct_parse<
+        detail::fmt_ct_count(S::data(), S::size())
+    >(S::data(), S::size());
+
+    template<typename R, std::size_t ...I, typename ...A>
+    static void write_items(
+        R &writer, std::locale const &loc, std::index_sequence<I...>,
+        A const &...args
+    ) {
+        (write_item<I>(writer, loc, args...), ...);
+    }
+
+    template<std::size_t I, typename R, typename ...A>
+    static void write_item(
+        R &writer, std::locale const &loc, A const &...args
+    ) {
+        constexpr detail::fmt_ct_item it = parsed.items[I];
+        if constexpr(!it.is_spec) {
+            char const *p = S::data() + it.beg;
+            range_put_all(writer, string_range{p, p + it.len});
+        } else {
+            format_spec sp{it.spec, loc, it.flags};
+            if constexpr(it.arg_width) {
+                sp.set_width_arg(it.width_arg, args...);
+            } else if constexpr(it.has_width) {
+                sp.set_width(it.width);
+            }
+            if constexpr(it.arg_precision) {
+                sp.set_precision_arg(it.precision_arg, args...);
+            } else if constexpr(it.has_precision) {
+                sp.set_precision(it.precision);
+            }
+            sp.format_value(
+                writer, std::get<it.arg>(std::forward_as_tuple(args...))
+            );
+        }
+    }
+};
+
+/** @brief Creates an ostd::static_format from a string literal.
+ *
+ * ~~~{.cc}
+ * ostd::writefln(OSTD_FMT("%s: %d items"), name, count);
+ * ~~~
+ *
+ * The argument must be a string literal or a `constexpr` character array.
+ */
+#define OSTD_FMT(str) \
+    ([]() { \
+        struct ostd_fmt_str { \
+            static constexpr char const *data() { return str; } \
+            static constexpr std::size_t size() { return sizeof(str) - 1; } \
+        }; \
+        return ::ostd::static_format<ostd_fmt_str>{}; \
+    }())
+
+/** @brief Formats into an output range using a compile-time format string.
+ *
+ * Like ostd::format(R &&, string_range, A const &...), but with the format
+ * string parsed and checked at compile time, see ostd::static_format.
+ */
+template<typename R, typename S, typename ...A>
+inline R &&format(R &&writer, static_format<S> fmt, A const &...args) {
+    return fmt.format(
+        std::forward<R>(writer), std::locale::classic(), args...
+    );
+}
+
+/** @brief Formats into an output range using a compile-time format string.
+ *
+ * Like ostd::format(R &&, std::locale const &, string_range, A const &...),
+ * but with the format string parsed and checked at compile time, see
+ * ostd::static_format.
+ */
+template<typename R, typename S, typename ...A>
+inline R &&format(
+    R &&writer, std::locale const &loc, static_format<S> fmt,
+    A const &...args
+) {
+    return fmt.format(std::forward<R>(writer), loc, args...);
+}
+
+/** @brief Gets the number of characters a format would produce.
+ *
+ * The format is done into an ostd::counting_sink() over an
+ * ostd::noop_sink(), so nothing is stored anywhere. This is useful to
+ * reserve the exact amount of memory before formatting for real:
+ *
+ * ~~~{.cc}
+ * auto app = ostd::appender<std::string>();
+ * app.reserve(ostd::formatted_size("%s: %d", name, value));
+ * ostd::format(app, "%s: %d", name, value);
+ * ~~~
+ *
+ * The arguments are formatted twice then, so this only pays off when the
+ * growth of the output is more expensive than that.
+ */
+template<typename ...A>
+inline std::size_t formatted_size(string_range fmt, A const &...args) {
+    return format(
+        counting_sink(noop_sink<char>()), fmt, args...
+    ).get_written();
+}
+
+/** @brief Gets the number of characters a format would produce.
+ *
+ * Like ostd::formatted_size(string_range, A const &...), but with an
+ * explicit locale.
+ */
+template<typename ...A>
+inline std::size_t formatted_size(
+    std::locale const &loc, string_range fmt, A const &...args
+) {
+    return format(
+        counting_sink(noop_sink<char>()), loc, fmt, args...
+    ).get_written();
+}
+
+/** @brief Gets the number of characters a format would produce.
+ *
+ * Like ostd::formatted_size(string_range, A const &...), but with a
+ * compile-time format string.
+ */
+template<typename S, typename ...A>
+inline std::size_t formatted_size(static_format<S> fmt, A const &...args) {
+    return format(
+        counting_sink(noop_sink<char>()), fmt, args...
+    ).get_written();
+}
+
+/** @brief The result of ostd::format_to_n(). */
+struct format_to_n_result {
+    /** @brief The position past the last written character. */
+    char *out;
+    /** @brief The size of the whole output, as if it was not truncated. */
+    std::size_t size;
+    /** @brief Whether the output did not fit into the buffer. */
+    bool truncated;
+};
+
+namespace detail {
+    /* writes up to n chars and keeps counting after that */
+    struct fmt_bounded_range: output_range<fmt_bounded_range> {
+        using value_type = char;
+        using reference  = char &;
+        using size_type  = std::size_t;
+
+        fmt_bounded_range(char *buf, std::size_t n) noexcept:
+            p_cur(buf), p_end(buf + n)
+        {}
+
+        void put(char c) noexcept {
+            if (p_cur != p_end) {
+                *p_cur++ = c;
+            }
+            ++p_size;
+        }
+
+        void put_n(char const *p, std::size_t n) noexcept {
+            std::size_t left = std::size_t(p_end - p_cur);
+            if (n < left) {
+                left = n;
+            }
+            if (left) {
+                std::memcpy(p_cur, p, left);
+                p_cur += left;
+            }
+            p_size += n;
+        }
+
+        char *p_cur, *p_end;
+        std::size_t p_size = 0;
+    };
+
+    template<typename F>
+    inline format_to_n_result fmt_to_n(char *buf, std::size_t n, F func) {
+        fmt_bounded_range r{buf, n};
+        func(r);
+        return format_to_n_result{r.p_cur, r.p_size, r.p_size > n};
+    }
+}
+
+/** @brief Formats into a fixed size buffer.
+ *
+ * At most `n` characters are written into `buf` and the rest of the output
+ * is dropped, while still counted, so the result tells both where the
+ * written data ends and how large a buffer the whole output needs. No
+ * terminating zero is written. Nothing is allocated for the output, so
+ * with a stack buffer this formats without touching the heap:
+ *
+ * ~~~{.cc}
+ * char buf[64];
+ * auto r = ostd::format_to_n(buf, sizeof(buf), "%d:%d", x, y);
+ * if (!r.truncated) {
+ *     use(ostd::string_range{buf, r.out});
+ * }
+ * ~~~
+ */
+template<typename ...A>
+inline format_to_n_result format_to_n(
+    char *buf, std::size_t n, string_range fmt, A const &...args
+) {
+    return detail::fmt_to_n(buf, n, [&](auto &r) {
+        format(r, fmt, args...);
+    });
+}
+
+/** @brief Formats into a fixed size buffer.
+ *
+ * Like ostd::format_to_n(char *, std::size_t, string_range, A const &...),
+ * but with an explicit locale.
+ */
+template<typename ...A>
+inline format_to_n_result format_to_n(
+    char *buf, std::size_t n, std::locale const &loc, string_range fmt,
+    A const &...args
+) {
+    return detail::fmt_to_n(buf, n, [&](auto &r) {
+        format(r, loc, fmt, args...);
+    });
+}
+
+/** @brief Formats into a fixed size buffer.
+ *
+ * Like ostd::format_to_n(char *, std::size_t, string_range, A const &...),
+ * but with a compile-time format string.
+ */
+template<typename S, typename ...A>
+inline format_to_n_result format_to_n(
+    char *buf, std::size_t n, static_format<S> fmt, A const &...args
+) {
+    return detail::fmt_to_n(buf, n, [&](auto &r) {
+        format(r, fmt, args...);
+    });
+}
+
+#ifdef OSTD_BUILD_TESTS
+OSTD_UNIT_TEST {
+    using ostd::test::fail_if;
+    /* the compile-time parser must give the same as the runtime one */
+    auto both = [](auto fmt, auto const &...args) {
+        auto &loc = std::locale::classic();
+        auto ct = format(appender<std::string>(), loc, fmt, args...).get();
+        auto rt = format(
+            appender<std::string>(), loc, fmt.str(), args...
+        ).get();
+        fail_if(ct != rt);
+        return ct;
+    };
+    fail_if(both(OSTD_FMT("")) != "" || both(OSTD_FMT("abc")) != "abc");
+    fail_if(both(
+        OSTD_FMT("%d|%5d|%-5d|%05d|%+d|% d|%x|%#X|%#b|%o|%.4d|%.0d|"),
+        42, -42, 42, -42, 42, 42, 255, 255, 5, 8, 7, 0
+    ) != "42|  -42|42   |-0042|+42| 42|ff|0XFF|0b101|10|0007||");
+    fail_if(both(
+        OSTD_FMT("%f|%.3f|%10.2f|%-10.2e|%#.0f|%g|%s|%a|%+.1f"),
+        3.14159, 3.14159, 3.14159, 31.4159, 3.0, 0.1, 1.0 / 3, 1.5, -2.25
+    ) != "3.141590|3.142|      3.14|3.14e+01  |3.|0.1|0.3333333333333333|"
+         "0x1.8p+0|-2.2");
+    /* width and precision as arguments */
+    fail_if(both(
+        OSTD_FMT("[%*d|%-*d|%.*f|%*.*s]"), 6, 42, 4, 7, 2, 3.14159,
+        8, 3, "abcdef"
+    ) != "[    42|7   |3.14|     abc]");
+    /* explicit positions, also mixed with implicit ones */
+    fail_if(both(
+        OSTD_FMT("%2$s-%1$s-%s|%5$*d|%1$s"), "a", "b", "c", 6, 42
+    ) != "b-a-c|    42|a");
+    /* escapes, literal percents and strings */
+    fail_if(both(
+        OSTD_FMT("%%|%@s|%@c|%@s|%c|%-@8s|%@.3s|%-4s|%4s|%.2s%%"),
+        "a\"b\n", 'x', '\t', 'y', "q", "a\tbcd", "ab", "cd", "efg"
+    ) != "%|\"a\\\"b\\n\"|'x'|'\\t'|y|\"q\"       |\"a\\tb\"|ab  |  cd|ef%");
+    fail_if(both(
+        OSTD_FMT("%s %d %s %c"), true, true, 'c', 'd'
+    ) != "true 1 c d");
+    /* ranges are handed over to the runtime parser */
+    fail_if(both(
+        OSTD_FMT("%(%d%|, %)"), std::vector<int>{1, 2, 3}
+    ) != "1, 2, 3");
+}
+#endif
+
 /** @} */
 
 } /* namespace ostd */
 
+#undef OSTD_TEST_MODULE
+
 #endif
 
 /** @} */
@@ -0,0 +1,415 @@
+/** @addtogroup Utilities
+ * @{
+ */
+
+/** @file hash.hh
+ *
+ * @brief Fast seeded hashing of strings and byte data.
+ *
+ * The standard hash of strings, which is also what std::hash uses for
+ * ostd::basic_char_range, is neither particularly fast nor seeded, so
+ * anyone who controls the keys of a hash table can make all of them
+ * collide. This file provides a hash function based on wyhash, which is
+ * among the fastest non-cryptographic hashes for keys of any size, takes
+ * a 64-bit seed, and can be computed incrementally over data that comes
+ * in pieces, such as from a stream.
+ *
+ * ~~~{.cc}
+ * std::unordered_map<std::string, int, ostd::fast_hash> counts;
+ * auto h = ostd::hash_bytes(buf, len, ostd::hash_seed());
+ * ~~~
+ *
+ * The results only depend on the bytes, the length and the seed; they
+ * are the same on every platform, but may change between versions of
+ * the library, so they should not be stored.
+ *
+ * @copyright See COPYING.md in the project tree for further information.
+ */
+
+#ifndef OSTD_HASH_HH
+#define OSTD_HASH_HH
+
+#include <ostd/unit_test.hh>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <algorithm>
+
+#include <ostd/platform.hh>
+#include <ostd/string.hh>
+#include <ostd/stream.hh>
+
+#ifdef OSTD_BUILD_TESTS
+#include <vector>
+#include <ostd/memory_stream.hh>
+#endif
+
+#define OSTD_TEST_MODULE libostd_hash
+
+namespace ostd {
+
+/** @addtogroup Utilities
+ * @{
+ */
+
+namespace detail {
+    static constexpr std::uint64_t wy_secret[4] = {
+        0x2D358DCCAA6C78A5ULL, 0x8BB84B93962EACC9ULL,
+        0x4B33A62ED433D4A3ULL, 0x4D5A2DA51DE1AA47ULL
+    };
+
+    inline std::uint64_t wy_mix(std::uint64_t a, std::uint64_t b) noexcept {
+#ifdef __SIZEOF_INT128__
+        __extension__ using u128 = unsigned __int128;
+        u128 r = u128(a) * b;
+        return std::uint64_t(r) ^ std::uint64_t(r >> 64);
+#else
+        std::uint64_t ha = a >> 32, hb = b >> 32;
+        std::uint64_t la = std::uint32_t(a), lb = std::uint32_t(b);
+        std::uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la;
+        std::uint64_t rl = la * lb, t = rl + (rm0 << 32);
+        std::uint64_t c = (t < rl);
+        std::uint64_t lo = t + (rm1 << 32);
+        c += (lo < t);
+        return lo ^ (rh + (rm0 >> 32) + (rm1 >> 32) + c);
+#endif
+    }
+
+    /* the full 128-bit product, as two halves */
+    inline void wy_mum(std::uint64_t &a, std::uint64_t &b) noexcept {
+#ifdef __SIZEOF_INT128__
+        __extension__ using u128 = unsigned __int128;
+        u128 r = u128(a) * b;
+        a = std::uint64_t(r);
+        b = std::uint64_t(r >> 64);
+#else
+        std::uint64_t ha = a >> 32, hb = b >> 32;
+        std::uint64_t la = std::uint32_t(a), lb = std::uint32_t(b);
+        std::uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la;
+        std::uint64_t rl = la * lb, t = rl + (rm0 << 32);
+        std::uint64_t c = (t < rl);
+        std::uint64_t lo = t + (rm1 << 32);
+        c += (lo < t);
+        a = lo;
+        b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+    }
+
+    inline std::uint64_t wy_r8(unsigned char const *p) noexcept {
+        std::uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return from_lil_endian<std::uint64_t>{}(v);
+    }
+
+    inline std::uint64_t wy_r4(unsigned char const *p) noexcept {
+        std::uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return from_lil_endian<std::uint32_t>{}(v);
+    }
+
+    inline std::uint64_t wy_seed(std::uint64_t seed) noexcept {
+        return seed ^ wy_mix(seed ^ wy_secret[0], wy_secret[1]);
+    }
+
+    /* one 48-byte block of the main loop */
+    inline void wy_block(
+        unsigned char const *p, std::uint64_t &seed,
+        std::uint64_t &see1, std::uint64_t &see2
+    ) noexcept {
+        seed = wy_mix(wy_r8(p) ^ wy_secret[1], wy_r8(p + 8) ^ seed);
+        see1 = wy_mix(wy_r8(p + 16) ^ wy_secret[2], wy_r8(p + 24) ^ see1);
+        see2 = wy_mix(wy_r8(p + 32) ^ wy_secret[3], wy_r8(p + 40) ^ see2);
+    }
+
+    /* up to 48 bytes after the blocks, the 16 bytes before `p` must be
+     * readable if there were any blocks
+     */
+    inline std::uint64_t wy_tail(
+        unsigned char const *p, std::size_t i, std::size_t len,
+        std::uint64_t seed
+    ) noexcept {
+        std::uint64_t a, b;
+        if (len <= 16) {
+            if (len >= 4) {
+                std::size_t o = (len >> 3) << 2;
+                a = (wy_r4(p) << 32) | wy_r4(p + o);
+                b = (wy_r4(p + len - 4) << 32) | wy_r4(p + len - 4 - o);
+            } else if (len > 0) {
+                a = (std::uint64_t(p[0]) << 16) |
+                    (std::uint64_t(p[len >> 1]) << 8) | p[len - 1];
+                b = 0;
+            } else {
+                a = b = 0;
+            }
+        } else {
+            while (i > 16) {
+                seed = wy_mix(wy_r8(p) ^ wy_secret[1], wy_r8(p + 8) ^ seed);
+                i -= 16;
+                p += 16;
+            }
+            a = wy_r8(p + i - 16);
+            b = wy_r8(p + i - 8);
+        }
+        a ^= wy_secret[1];
+        b ^= seed;
+        wy_mum(a, b);
+        return wy_mix(a ^ wy_secret[0] ^ len, b ^ wy_secret[1]);
+    }
+}
+
+/** @brief Hashes a sequence of bytes.
+ *
+ * Different seeds give unrelated results, so a secret seed (such as the
+ * one from ostd::hash_seed()) makes the hashes unpredictable from outside.
+ */
+inline std::uint64_t hash_bytes(
+    void const *data, std::size_t len, std::uint64_t seed = 0
+) noexcept {
+    auto *p = static_cast<unsigned char const *>(data);
+    seed = detail::wy_seed(seed);
+    std::size_t i = len;
+    if (i > 48) {
+        std::uint64_t see1 = seed, see2 = seed;
+        do {
+            detail::wy_block(p, seed, see1, see2);
+            p += 48;
+            i -= 48;
+        } while (i > 48);
+        seed ^= see1 ^ see2;
+    }
+    return detail::wy_tail(p, i, len, seed);
+}
+
+/** @brief Hashes the contents of a character range.
+ *
+ * This is the same as hashing the bytes of the characters with
+ * ostd::hash_bytes().
+ */
+template<typename T>
+inline std::uint64_t hash_bytes(
+    basic_char_range<T> r, std::uint64_t seed = 0
+) noexcept {
+    return hash_bytes(r.data(), r.size() * sizeof(T), seed);
+}
+
+/** @brief Gets a random seed for the process.
+ *
+ * The seed is generated on the first call and is then the same for the
+ * rest of the process's life. It is the default seed of ostd::fast_hash.
+ */
+OSTD_EXPORT std::uint64_t hash_seed() noexcept;
+
+/** @brief Computes ostd::hash_bytes() over data given in pieces.
+ *
+ * The result is the same as hashing all of the data at once, no matter
+ * how it's split. The state is small and has a fixed size, as only the
+ * last few bytes are buffered.
+ */
+struct hash_state {
+    /** @brief Starts hashing with the given seed. */
+    hash_state(std::uint64_t seed = 0) noexcept {
+        reset(seed);
+    }
+
+    /** @brief Starts over with the given seed. */
+    void reset(std::uint64_t seed = 0) noexcept {
+        p_seed = p_see1 = p_see2 = detail::wy_seed(seed);
+        p_len = 0;
+        p_npend = 0;
+    }
+
+    /** @brief Adds a sequence of bytes. */
+    void update(void const *data, std::size_t len) noexcept {
+        auto *p = static_cast<unsigned char const *>(data);
+        p_len += len;
+        while (len) {
+            /* a full block is only hashed once it's known not to be the
+             * last data, because the final one is handled differently
+             */
+            if (p_npend == 48) {
+                detail::wy_block(p_buf + 16, p_seed, p_see1, p_see2);
+                std::memcpy(p_buf, p_buf + 48, 16);
+                p_npend = 0;
+            }
+            if (!p_npend && (len > 48)) {
+                do {
+                    detail::wy_block(p, p_seed, p_see1, p_see2);
+                    p += 48;
+                    len -= 48;
+                } while (len > 48);
+                std::memcpy(p_buf, p - 16, 16);
+            }
+            std::size_t n = std::min(len, 48 - p_npend);
+            std::memcpy(p_buf + 16 + p_npend, p, n);
+            p_npend += n;
+            p += n;
+            len -= n;
+        }
+    }
+
+    /** @brief Adds the contents of a character range. */
+    template<typename T>
+    void update(basic_char_range<T> r) noexcept {
+        update(r.data(), r.size() * sizeof(T));
+    }
+
+    /** @brief Gets the number of bytes added so far. */
+    std::uint64_t size() const noexcept {
+        return p_len;
+    }
+
+    /** @brief Gets the hash of all the data added so far.
+     *
+     * More data can still be added afterwards.
+     */
+    std::uint64_t digest() const noexcept {
+        std::uint64_t seed = p_seed;
+        if (p_len > 48) {
+            seed ^= p_see1 ^ p_see2;
+        }
+        return detail::wy_tail(p_buf + 16, p_npend, p_len, seed);
+    }
+
+private:
+    std::uint64_t p_seed, p_see1, p_see2, p_len;
+    std::size_t p_npend;
+    /* the last 16 hashed bytes, followed by the pending ones */
+    unsigned char p_buf[64];
+};
+
+/** @brief Hashes the rest of a stream.
+ *
+ * The stream is read in blocks until its end, so it doesn't have to fit
+ * into memory.
+ *
+ * @throws ostd::stream_error on read errors.
+ */
+inline std::uint64_t hash_stream(stream &s, std::uint64_t seed = 0) {
+    hash_state h{seed};
+    char buf[4096];
+    for (;;) {
+        std::size_t n = s.read_bytes(buf, sizeof(buf));
+        if (!n) {
+            break;
+        }
+        h.update(buf, n);
+    }
+    return h.digest();
+}
+
+/** @brief A seeded hash function object for strings.
+ *
+ * This can be used as the hasher of standard unordered containers in
+ * place of std::hash. It accepts ostd::basic_char_range, standard strings
+ * and string views of any character type, and anything with a `string()`
+ * method returning a string, such as ostd::path. Equal strings get equal
+ * hashes regardless of their type.
+ *
+ * By default it uses the random seed of the process, so the hashes are
+ * different in every run; a fixed seed can be given to get stable ones.
+ */
+struct fast_hash {
+    /** @brief Creates the hash function with ostd::hash_seed(). */
+    fast_hash() noexcept: p_seed(hash_seed()) {}
+
+    /** @brief Creates the hash function with the given seed. */
+    explicit fast_hash(std::uint64_t seed) noexcept: p_seed(seed) {}
+
+    /** @brief Hashes a character range. */
+    template<typename T>
+    std::size_t operator()(basic_char_range<T> const &v) const noexcept {
+        return std::size_t(hash_bytes(v, p_seed));
+    }
+
+    /** @brief Hashes a standard string view. */
+    template<typename T, typename TR>
+    std::size_t operator()(std::basic_string_view<T, TR> v) const noexcept {
+        return std::size_t(
+            hash_bytes(v.data(), v.size() * sizeof(T), p_seed)
+        );
+    }
+
+    /** @brief Hashes a standard string. */
+    template<typename T, typename TR, typename A>
+    std::size_t operator()(std::basic_string<T, TR, A> const &v)
+        const noexcept
+    {
+        return std::size_t(
+            hash_bytes(v.data(), v.size() * sizeof(T), p_seed)
+        );
+    }
+
+    /** @brief Hashes a zero terminated string. */
+    std::size_t operator()(char const *v) const noexcept {
+        return std::size_t(hash_bytes(v, std::strlen(v), p_seed));
+    }
+
+    /** @brief Hashes an object by its `string()`, such as ostd::path. */
+    template<typename T>
+    auto operator()(T const &v) const noexcept ->
+        std::enable_if_t<
+            std::is_same_v<decltype(v.string()), std::string const &>,
+            std::size_t
+        >
+    {
+        return (*this)(v.string());
+    }
+
+private:
+    std::uint64_t p_seed;
+};
+
+#ifdef OSTD_BUILD_TESTS
+OSTD_UNIT_TEST {
+    using ostd::test::fail_if;
+    unsigned char data[300];
+    for (std::size_t i = 0; i < sizeof(data); ++i) {
+        data[i] = static_cast<unsigned char>(i * 37 + (i >> 3));
+    }
+
+    /* incremental hashing matches no matter how the data is split */
+    std::vector<std::uint64_t> hashes;
+    for (std::size_t len = 0; len <= sizeof(data); ++len) {
+        auto h = hash_bytes(data, len, 42);
+        for (std::size_t step: {1, 7, 16, 48, 49, 100}) {
+            hash_state st{42};
+            for (std::size_t i = 0; i < len; i += step) {
+                st.update(data + i, std::min(step, len - i));
+            }
+            fail_if(st.digest() != h || st.size() != len);
+        }
+        hashes.push_back(h);
+    }
+    /* all prefixes hash differently, and the seed matters */
+    std::sort(hashes.begin(), hashes.end());
+    fail_if(std::unique(hashes.begin(), hashes.end()) != hashes.end());
+    fail_if(hash_bytes(data, 10, 1) == hash_bytes(data, 10, 2));
+    fail_if(hash_bytes(data, 100, 1) == hash_bytes(data, 100, 2));
+
+    memory_stream ms{"the quick brown fox jumps over the lazy dog"};
+    fail_if(hash_stream(ms, 5) != hash_bytes(
+        string_range{"the quick brown fox jumps over the lazy dog"}, 5
+    ));
+
+    fast_hash fh{7};
+    std::string s{"hello world"};
+    fail_if(fh(s) != fh(string_range{s}) || fh(s) != fh("hello world"));
+    fail_if(fh(std::string_view{s}) != fh(s));
+    fail_if(fh(s) == fast_hash{8}(s));
+    fail_if(fast_hash{}(s) != fast_hash{}(s));
+}
+#endif
+
+/** @} */
+
+} /* namespace ostd */
+
+#undef OSTD_TEST_MODULE
+
+#endif
+
+/** @} */
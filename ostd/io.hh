@@ -39,23 +39,6 @@ namespace ostd {
  * @{
  */
 
-/** @brief The mode to open file streams with.
- *
- * Libostd file streams are always opened in binary mode. Text mode is not
- * directly supported (the only way to get it is to encapsulate a C `FILE *`
- * that is already opened in text mode).
- *
- * See the C fopen() function documentation for more info on modes.
-*/
-enum class stream_mode {
-    READ = 0, ///< Reading, equivalent to the C `rb` mode.
-    WRITE,    ///< Writing, equivalent to the C `wb` mode.
-    APPEND,   ///< Appending, equivalent to the C `ab` mode.
-    READ_U,   ///< Read/update, equivalent to the C `rb+` mode.
-    WRITE_U,  ///< Write/update, equivalent to the C `wb+` mode.
-    APPEND_U  ///< Append/update, equivalent to the C `ab+` mode.
-};
-
 /** @brief A file stream.
  *
  * File streams are equivalent to the C `FILE` type. You can open new file
@@ -294,36 +277,6 @@ OSTD_EXPORT extern file_stream cerr;
 
 /* no need to call anything from file_stream, prefer simple calls... */
 
-namespace detail {
-    /* lightweight output range for direct stdout */
-    struct stdout_range: output_range<stdout_range> {
-        using value_type = char;
-
-        stdout_range() {}
-        void put(char c) {
-            if (std::putchar(c) == EOF) {
-                throw stream_error{EIO, std::generic_category()};
-            }
-        }
-    };
-
-    template<typename R>
-    inline void range_put_all(stdout_range &r, R range) {
-        if constexpr(
-            is_contiguous_range<R> &&
-            std::is_same_v<std::remove_const_t<range_value_t<R>>, char>
-        ) {
-            if (std::fwrite(range.data(), 1, range.size(), stdout) != range.size()) {
-                throw stream_error{EIO, std::generic_category()};
-            }
-        } else {
-            for (; !range.empty(); range.pop_front()) {
-                r.put(range.front());
-            }
-        }
-    }
-}
-
 /** @brief Writes all given values into standard output.
  *
  * Behaves the same as calling ostd::stream::write() on ostd::cout,
@@ -333,8 +286,7 @@ namespace detail {
  */
 template<typename ...A>
 inline void write(A const &...args) {
-    format_spec sp{'s', cout.getloc()};
-    (sp.format_value(detail::stdout_range{}, args), ...);
+    cout.write(args...);
 }
 
 /** @brief Writes all given values into standard output followed by a newline.
@@ -346,10 +298,7 @@ inline void write(A const &...args) {
  */
 template<typename ...A>
 inline void writeln(A const &...args) {
-    write(args...);
-    if (std::putchar('\n') == EOF) {
-        throw stream_error{EIO, std::generic_category()};
-    }
+    cout.writeln(args...);
 }
 
 /** @brief Writes a formatted string into standard output.
@@ -361,8 +310,7 @@ inline void writeln(A const &...args) {
  */
 template<typename ...A>
 inline void writef(string_range fmt, A const &...args) {
-    format_spec sp{fmt, cout.getloc()};
-    sp.format(detail::stdout_range{}, args...);
+    cout.writef(fmt, args...);
 }
 
 /** @brief Writes a formatted string into standard output followed by a newline.
@@ -374,10 +322,27 @@ inline void writef(string_range fmt, A const &...args) {
  */
 template<typename ...A>
 inline void writefln(string_range fmt, A const &...args) {
-    writef(fmt, args...);
-    if (std::putchar('\n') == EOF) {
-        throw stream_error{EIO, std::generic_category()};
-    }
+    cout.writefln(fmt, args...);
+}
+
+/** @brief Writes a compile-time format string into standard output.
+ *
+ * Like ostd::writef(string_range, A const &...), but the format string is
+ * parsed and checked at compile time, see ostd::static_format.
+ */
+template<typename S, typename ...A>
+inline void writef(static_format<S> fmt, A const &...args) {
+    cout.writef(fmt, args...);
+}
+
+/** @brief Writes a compile-time format string and a newline into standard output.
+ *
+ * Like ostd::writefln(string_range, A const &...), but the format string
+ * is parsed and checked at compile time, see ostd::static_format.
+ */
+template<typename S, typename ...A>
+inline void writefln(static_format<S> fmt, A const &...args) {
+    cout.writefln(fmt, args...);
 }
 
 /** @} */
@@ -0,0 +1,427 @@
+/** @addtogroup Strings
+ * @{
+ */
+
+/** @file json.hh
+ *
+ * @brief Streaming JSON output, particularly for JSON lines logs.
+ *
+ * This writes JSON straight into any output range, using the formatting
+ * system for numbers and strings, so no intermediate strings are built.
+ * Values are serialized according to their types, including ranges,
+ * tuples and custom types with ostd::format_traits or ostd::json_traits.
+ *
+ * ~~~{.cc}
+ * // {"level":"info","msg":"done","took_ms":12.5,"ids":[1,2,3]}
+ * ostd::json_line(ostd::cout,
+ *     "level", "info", "msg", "done", "took_ms", 12.5, "ids", ids
+ * );
+ * ~~~
+ *
+ * @copyright See COPYING.md in the project tree for further information.
+ */
+
+#ifndef OSTD_JSON_HH
+#define OSTD_JSON_HH
+
+#include <ostd/unit_test.hh>
+
+#include <cstddef>
+#include <cmath>
+#include <limits>
+#include <locale>
+#include <tuple>
+#include <optional>
+#include <utility>
+#include <type_traits>
+
+#include <ostd/platform.hh>
+#include <ostd/range.hh>
+#include <ostd/string.hh>
+#include <ostd/format.hh>
+#include <ostd/stream.hh>
+
+#define OSTD_TEST_MODULE libostd_json
+
+namespace ostd {
+
+/** @addtogroup Strings
+ * @{
+ */
+
+/** @brief Specialize this to serialize custom objects as JSON.
+ *
+ * Without a specialization, custom types that have ostd::format_traits
+ * are written as JSON strings containing their formatted form. For any
+ * other representation, specialize this like:
+ *
+ * ~~~{.cc}
+ * template<>
+ * struct json_traits<point> {
+ *     template<typename W>
+ *     static void to_json(point const &v, W &writer) {
+ *         writer.begin_object();
+ *         writer.member("x", v.x);
+ *         writer.member("y", v.y);
+ *         writer.end_object();
+ *     }
+ * };
+ * ~~~
+ *
+ * The `writer` is an ostd::json_writer and the function must write
+ * exactly one value into it.
+ */
+template<typename>
+struct json_traits {};
+
+template<typename R>
+struct json_writer;
+
+namespace detail {
+    /* control characters up to 0x20 (space) */
+    static inline constexpr char const *json_escapes[] = {
+        "\\u0000", "\\u0001", "\\u0002", "\\u0003", "\\u0004", "\\u0005",
+        "\\u0006", "\\u0007", "\\b"    , "\\t"    , "\\n"    , "\\u000B",
+        "\\f"    , "\\r"    , "\\u000E", "\\u000F", "\\u0010", "\\u0011",
+        "\\u0012", "\\u0013", "\\u0014", "\\u0015", "\\u0016", "\\u0017",
+        "\\u0018", "\\u0019", "\\u001A", "\\u001B", "\\u001C", "\\u001D",
+        "\\u001E", "\\u001F"
+    };
+
+    inline char const *escape_json_char(char v) noexcept {
+        if (static_cast<unsigned char>(v) < 0x20) {
+            return json_escapes[std::size_t(v)];
+        } else if (v == '"') {
+            return "\\\"";
+        } else if (v == '\\') {
+            return "\\\\";
+        }
+        return nullptr;
+    }
+
+    /* escapes everything put into it, for custom formatted values */
+    template<typename R>
+    struct json_escape_range: output_range<json_escape_range<R>> {
+        using value_type = char;
+        using reference  = char &;
+        using size_type  = std::size_t;
+
+        json_escape_range(R &out) noexcept: p_out(&out) {}
+
+        void put(char c) {
+            char const *esc = escape_json_char(c);
+            if (esc) {
+                range_put_all(*p_out, string_range{esc});
+            } else {
+                p_out->put(c);
+            }
+        }
+
+    private:
+        R *p_out;
+    };
+
+    template<typename T, typename W>
+    inline auto test_tojson(int) -> typename std::is_void<
+        decltype(json_traits<T>::to_json(
+            std::declval<T const &>(), std::declval<W &>()
+        ))
+    >::type;
+
+    template<typename, typename>
+    inline std::false_type test_tojson(...);
+
+    template<typename T>
+    static inline constexpr bool json_tojson_test = decltype(test_tojson<
+        T, json_writer<decltype(noop_sink<char>())>
+    >(0))::value;
+
+    template<typename T>
+    struct json_is_optional: std::false_type {};
+
+    template<typename T>
+    struct json_is_optional<std::optional<T>>: std::true_type {};
+
+    /* ranges of pairs with string keys become objects */
+    template<typename T, bool = is_tuple_like<T>>
+    static inline constexpr bool json_is_member = false;
+
+    template<typename T>
+    static inline constexpr bool json_is_member<T, true> =
+        (std::tuple_size<T>::value == 2) && std::is_constructible_v<
+            string_range, std::tuple_element_t<0, T> const &
+        >;
+}
+
+/** @brief A streaming JSON writer over an output range.
+ *
+ * The writer keeps track of where separators go, so the values are just
+ * written in order; objects and arrays are opened and closed explicitly,
+ * and object members are a key() followed by a value. Nothing is buffered
+ * here, every token goes straight into the range, so when writing into
+ * a stream, use an ostd::buffered_stream_range.
+ *
+ * The output is compact, without any whitespace. The writer does not
+ * check that the calls form valid JSON; that's up to the caller.
+ *
+ * @tparam R The output range type, with `char` values.
+ */
+template<typename R>
+struct json_writer {
+    /** @brief Creates a writer over a range.
+     *
+     * The range is not copied, so it must stay alive while writing.
+     */
+    json_writer(R &out) noexcept: p_out(&out) {}
+
+    /** @brief Starts an object. */
+    void begin_object() {
+        separate();
+        p_out->put('{');
+        p_first = true;
+    }
+
+    /** @brief Ends an object. */
+    void end_object() {
+        p_out->put('}');
+        p_first = false;
+    }
+
+    /** @brief Starts an array. */
+    void begin_array() {
+        separate();
+        p_out->put('[');
+        p_first = true;
+    }
+
+    /** @brief Ends an array. */
+    void end_array() {
+        p_out->put(']');
+        p_first = false;
+    }
+
+    /** @brief Writes an object key; a value must follow. */
+    void key(string_range k) {
+        separate();
+        write_string(k);
+        p_out->put(':');
+        p_key = true;
+    }
+
+    /** @brief Writes an object member, i.e. a key and a value. */
+    template<typename T>
+    void member(string_range k, T const &v) {
+        key(k);
+        value(v);
+    }
+
+    /** @brief Writes a value.
+     *
+     * The representation is chosen by the type, in this order:
+     *
+     * * Types with ostd::json_traits use that.
+     * * `std::nullptr_t` and empty `std::optional` are `null`.
+     * * Strings of any character type are strings (UTF-8 encoded).
+     * * `bool` is `true` or `false`.
+     * * Characters are strings of one character.
+     * * Integers are numbers.
+     * * Floats are numbers in the shortest form that reads back the same;
+     *   infinities and NaNs are `null`, as JSON has no way to write them.
+     * * Ranges are arrays, except ranges of pairs (or other tuple-likes
+     *   of two) with string keys, such as maps, which are objects.
+     * * Other tuple-likes are arrays.
+     * * Types with ostd::format_traits are strings of their `%s` format.
+     */
+    template<typename T>
+    void value(T const &v) {
+        if constexpr(detail::json_tojson_test<T>) {
+            json_traits<T>::to_json(v, *this);
+        } else if constexpr(std::is_same_v<T, std::nullptr_t>) {
+            write_raw("null");
+        } else if constexpr(detail::json_is_optional<T>::value) {
+            if (v) {
+                value(*v);
+            } else {
+                write_raw("null");
+            }
+        } else if constexpr(std::is_constructible_v<string_range, T const &>) {
+            separate();
+            write_string(string_range{v});
+        } else if constexpr(
+            std::is_constructible_v<u32string_range, T const &>
+        ) {
+            separate();
+            write_string(u32string_range{v});
+        } else if constexpr(
+            std::is_constructible_v<u16string_range, T const &>
+        ) {
+            separate();
+            write_string(u16string_range{v});
+        } else if constexpr(std::is_constructible_v<wstring_range, T const &>) {
+            separate();
+            write_string(wstring_range{v});
+        } else if constexpr(std::is_same_v<T, bool>) {
+            write_raw(v ? "true" : "false");
+        } else if constexpr(utf::is_character<T>) {
+            separate();
+            write_string(basic_char_range<T const>{&v, &v + 1});
+        } else if constexpr(std::is_integral_v<T>) {
+            separate();
+            format_spec{'d', std::locale::classic()}.format_value(*p_out, v);
+        } else if constexpr(std::is_floating_point_v<T>) {
+            if (!std::isfinite(v)) {
+                write_raw("null");
+                return;
+            }
+            separate();
+            format_spec{'s', std::locale::classic()}.format_value(*p_out, v);
+        } else if constexpr(detail::iterable_test<T>) {
+            using VT = std::decay_t<decltype(ostd::iter(v).front())>;
+            bool obj = detail::json_is_member<VT>;
+            obj ? begin_object() : begin_array();
+            for (auto r = ostd::iter(v); !r.empty(); r.pop_front()) {
+                if constexpr(detail::json_is_member<VT>) {
+                    auto &&item = r.front();
+                    member(std::get<0>(item), std::get<1>(item));
+                } else {
+                    value(r.front());
+                }
+            }
+            obj ? end_object() : end_array();
+        } else if constexpr(detail::is_tuple_like<T>) {
+            begin_array();
+            std::apply([this](auto const &...args) {
+                (value(args), ...);
+            }, v);
+            end_array();
+        } else if constexpr(
+            detail::fmt_tofmt_test<T, decltype(noop_sink<char>())>
+        ) {
+            separate();
+            p_out->put('"');
+            detail::json_escape_range<R> esc{*p_out};
+            format_traits<T>::to_format(
+                v, esc, format_spec{'s', std::locale::classic()}
+            );
+            p_out->put('"');
+        } else {
+            static_assert(
+                detail::fmt_tofmt_test<T, decltype(noop_sink<char>())>,
+                "the value cannot be serialized as JSON"
+            );
+        }
+    }
+
+    /** @brief Gets the output range. */
+    R &output() noexcept {
+        return *p_out;
+    }
+
+private:
+    void separate() {
+        if (p_key) {
+            p_key = false;
+        } else if (!p_first) {
+            p_out->put(',');
+        }
+        p_first = false;
+    }
+
+    void write_raw(string_range s) {
+        separate();
+        range_put_all(*p_out, s);
+    }
+
+    template<typename C>
+    void write_string(basic_char_range<C const> s) {
+        p_out->put('"');
+        detail::write_escaped(
+            *p_out, s, s.size(), detail::escape_json_char
+        );
+        p_out->put('"');
+    }
+
+    R *p_out;
+    bool p_first = true;
+    bool p_key = false;
+};
+
+namespace detail {
+    template<typename W>
+    inline void json_members(W &) {}
+
+    template<typename W, typename K, typename V, typename ...A>
+    inline void json_members(W &w, K const &k, V const &v, A const &...args) {
+        w.member(k, v);
+        json_members(w, args...);
+    }
+}
+
+/** @brief Writes a single JSON object followed by a newline.
+ *
+ * The arguments are pairs of keys and values, written as members with
+ * ostd::json_writer::member(). This is a line of the JSON lines format,
+ * so it's a convenient way to write structured logs.
+ *
+ * The output is either an output range or an ostd::stream. Streams are
+ * written through an ostd::buffered_stream_range, so every line reaches
+ * the stream in a single write unless it's longer than the buffer.
+ *
+ * @throws ostd::stream_error when writing into a stream fails.
+ */
+template<typename R, typename ...A>
+inline void json_line(R &&out, A const &...args) {
+    static_assert(
+        !(sizeof...(A) % 2), "JSON members must be pairs of keys and values"
+    );
+    if constexpr(std::is_base_of_v<stream, std::remove_reference_t<R>>) {
+        buffered_stream_range<> sout{out};
+        json_line(sout, args...);
+        sout.flush();
+    } else {
+        json_writer<std::remove_reference_t<R>> w{out};
+        w.begin_object();
+        detail::json_members(w, args...);
+        w.end_object();
+        out.put('\n');
+    }
+}
+
+#ifdef OSTD_BUILD_TESTS
+OSTD_UNIT_TEST {
+    using ostd::test::fail_if;
+    auto app = appender<std::string>();
+    json_line(
+        app, "s", "a\"b\\c\n\x01", "i", -42, "f", 0.1, "b", true,
+        "n", nullptr, "o", std::optional<int>{},
+        "inf", std::numeric_limits<double>::infinity()
+    );
+    fail_if(app.get() != (
+        "{\"s\":\"a\\\"b\\\\c\\n\\u0001\",\"i\":-42,\"f\":0.1,\"b\":true,"
+        "\"n\":null,\"o\":null,\"inf\":null}\n"
+    ));
+
+    app.clear();
+    std::vector<std::pair<std::string, int>> m{{"x", 1}, {"y", 2}};
+    std::vector<std::vector<int>> nested{{1, 2}, {}, {3}};
+    json_writer<decltype(app)> w{app};
+    w.begin_array();
+    w.value(m);
+    w.value(nested);
+    w.value(std::make_tuple(1, 'c', u"é"));
+    w.end_array();
+    fail_if(app.get() != (
+        "[{\"x\":1,\"y\":2},[[1,2],[],[3]],[1,\"c\",\"\xC3\xA9\"]]"
+    ));
+}
+#endif
+
+/** @} */
+
+} /* namespace ostd */
+
+#undef OSTD_TEST_MODULE
+
+#endif
+
+/** @} */
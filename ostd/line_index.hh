@@ -0,0 +1,308 @@
+/** @addtogroup Streams
+ * @{
+ */
+
+/** @file line_index.hh
+ *
+ * @brief Random access to lines of large text files.
+ *
+ * Reading a specific line of a text file normally means scanning all of
+ * the data before it, for example with ostd::stream::iter_lines(). This
+ * file provides an index of line offsets, which is built by scanning the
+ * file once and can be saved next to the file, so that later lookups can
+ * seek straight to the requested line.
+ *
+ * ~~~{.cc}
+ * auto idx = ostd::line_index::open("huge.log");
+ * ostd::file_stream f{"huge.log"};
+ * auto lines = idx.iter(f);
+ * ostd::writeln(lines[1000000]);
+ * ~~~
+ *
+ * @copyright See COPYING.md in the project tree for further information.
+ */
+
+#ifndef OSTD_LINE_INDEX_HH
+#define OSTD_LINE_INDEX_HH
+
+#include <ostd/unit_test.hh>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#include <ostd/platform.hh>
+#include <ostd/range.hh>
+#include <ostd/string.hh>
+#include <ostd/stream.hh>
+
+#ifdef OSTD_BUILD_TESTS
+#include <ostd/memory_stream.hh>
+#endif
+
+#define OSTD_TEST_MODULE libostd_line_index
+
+namespace ostd {
+
+/** @addtogroup Streams
+ * @{
+ */
+
+struct line_index_range;
+
+/** @brief An index of line offsets in a stream.
+ *
+ * The lines are delimited the same way as with ostd::stream::get_line(),
+ * i.e. by `\n`, and a final line without a newline counts as a line too,
+ * while an empty remainder after the last newline does not. The index
+ * stores the offset of the start of every line and the total size of the
+ * data, so the bounds of any line can be computed in constant time.
+ *
+ * Scanning is done in large blocks using `memchr`, which the C library
+ * usually implements with vector instructions. When building from a file
+ * path, the file can be split into chunks that are scanned in parallel.
+ *
+ * The index can be saved into a compact file; the offsets are stored as
+ * variable length deltas (see ostd::binary_writer), so typical text takes
+ * one or two bytes per line. In memory, each line takes 8 bytes.
+ */
+struct OSTD_EXPORT line_index {
+    /** @brief The file name suffix used by open(). */
+    static constexpr char const *suffix = ".lidx";
+
+    /** @brief Creates an empty index. */
+    line_index() {}
+
+    /** @brief Builds an index by scanning a stream.
+     *
+     * The stream is scanned from the beginning, so it must be seekable.
+     * Afterwards it's positioned at the end.
+     *
+     * @throws ostd::stream_error on read or seek errors.
+     */
+    static line_index build(stream &s);
+
+    /** @brief Builds an index by scanning a file.
+     *
+     * The file is split into up to `threads` chunks which are scanned
+     * in parallel, each through its own ostd::file_stream. Zero means the
+     * number of hardware threads. Small files are always scanned by the
+     * calling thread.
+     *
+     * @throws ostd::stream_error if the file cannot be opened or read.
+     */
+    static line_index build(string_range path, std::size_t threads = 0);
+
+    /** @brief Loads an index previously written by save().
+     *
+     * @throws ostd::serialize_error if the data is not a valid index.
+     * @throws ostd::stream_error on read errors.
+     */
+    static line_index load(stream &s);
+
+    /** @brief Gets an index for a file, creating it if needed.
+     *
+     * Loads the index from the file's path with ostd::line_index::suffix
+     * appended. If that is missing, invalid, or made for data of another
+     * size, the index is rebuilt using build() and saved there. Failing to
+     * save the index is not an error.
+     *
+     * Only the size is used to detect stale indexes, so an index will not
+     * be rebuilt after a modification that keeps the file size.
+     *
+     * @throws ostd::stream_error if the file cannot be opened or read.
+     */
+    static line_index open(string_range path, std::size_t threads = 0);
+
+    /** @brief Writes the index into a stream.
+     *
+     * @throws ostd::stream_error on write errors.
+     */
+    void save(stream &s) const;
+
+    /** @brief Gets the number of lines. */
+    std::size_t size() const noexcept {
+        return p_offsets.size();
+    }
+
+    /** @brief Checks if there are no lines. */
+    bool empty() const noexcept {
+        return p_offsets.empty();
+    }
+
+    /** @brief Gets the size of the indexed data in bytes. */
+    stream_off_t data_size() const noexcept {
+        return stream_off_t(p_size);
+    }
+
+    /** @brief Gets the offset of the first byte of the line `i`. */
+    stream_off_t line_begin(std::size_t i) const noexcept {
+        return stream_off_t(p_offsets[i]);
+    }
+
+    /** @brief Gets the offset past the line `i`, including its newline. */
+    stream_off_t line_end(std::size_t i) const noexcept {
+        return stream_off_t(
+            ((i + 1) < p_offsets.size()) ? p_offsets[i + 1] : p_size
+        );
+    }
+
+    /** @brief Creates a random access range over the lines of a stream.
+     *
+     * The stream must contain the data the index was built for and must
+     * be seekable. The range keeps pointers to both the index and the
+     * stream, so both must stay alive while it's used.
+     */
+    line_index_range iter(stream &s) const;
+
+private:
+    std::vector<std::uint64_t> p_offsets;
+    std::uint64_t p_size = 0;
+};
+
+/** @brief A random access range over lines using an ostd::line_index.
+ *
+ * This is an ostd::finite_random_access_range_tag range of lines as
+ * std::string, without the trailing newline (and carriage return before
+ * it, if any), just like ostd::stream::iter_lines() returns them. Every
+ * access seeks the stream and reads exactly the line's bytes, so there
+ * is no caching; accessing the same line twice reads it twice.
+ *
+ * Since all copies share the stream's position, they are not safe to use
+ * from multiple threads at once.
+ */
+struct OSTD_EXPORT line_index_range: input_range<line_index_range> {
+    using range_category = finite_random_access_range_tag;
+    using value_type     = std::string;
+    using reference      = std::string;
+    using size_type      = std::size_t;
+
+    line_index_range() = delete;
+
+    /** @brief Creates a range over all lines of the index. */
+    line_index_range(line_index const &idx, stream &s) noexcept:
+        p_index(&idx), p_stream(&s), p_beg(0), p_end(idx.size())
+    {}
+
+    /** @brief Checks if the range is empty. */
+    bool empty() const noexcept {
+        return p_beg == p_end;
+    }
+
+    /** @brief Gets the number of lines in the range. */
+    size_type size() const noexcept {
+        return p_end - p_beg;
+    }
+
+    /** @brief Pops the first line.
+     *
+     * @throws std::out_of_range on empty range.
+     */
+    void pop_front() {
+        if (p_beg == p_end) {
+            throw std::out_of_range{"pop_front on empty range"};
+        }
+        ++p_beg;
+    }
+
+    /** @brief Pops the last line.
+     *
+     * @throws std::out_of_range on empty range.
+     */
+    void pop_back() {
+        if (p_beg == p_end) {
+            throw std::out_of_range{"pop_back on empty range"};
+        }
+        --p_end;
+    }
+
+    /** @brief Reads the first line.
+     *
+     * @throws ostd::stream_error on seek or read errors.
+     */
+    reference front() const {
+        return read_line(p_beg);
+    }
+
+    /** @brief Reads the last line.
+     *
+     * @throws ostd::stream_error on seek or read errors.
+     */
+    reference back() const {
+        return read_line(p_end - 1);
+    }
+
+    /** @brief Reads the line `i` of the range.
+     *
+     * @throws ostd::stream_error on seek or read errors.
+     */
+    reference operator[](size_type i) const {
+        return read_line(p_beg + i);
+    }
+
+    /** @brief Slices the range. */
+    line_index_range slice(size_type start, size_type end) const noexcept {
+        line_index_range ret{*this};
+        ret.p_end = p_beg + end;
+        ret.p_beg = p_beg + start;
+        return ret;
+    }
+
+    /** @brief Slices the range until the end. */
+    line_index_range slice(size_type start) const noexcept {
+        return slice(start, size());
+    }
+
+    /** @brief Gets the line number of the first line in the range. */
+    size_type line_number() const noexcept {
+        return p_beg;
+    }
+
+private:
+    std::string read_line(size_type i) const;
+
+    line_index const *p_index;
+    stream *p_stream;
+    size_type p_beg, p_end;
+};
+
+inline line_index_range line_index::iter(stream &s) const {
+    return line_index_range{*this, s};
+}
+
+#ifdef OSTD_BUILD_TESTS
+OSTD_UNIT_TEST {
+    using ostd::test::fail_if;
+    memory_stream ms{"first\nsecond\r\n\nlast"};
+    auto idx = line_index::build(ms);
+    fail_if(idx.size() != 4 || idx.data_size() != 19);
+    fail_if(idx.line_begin(1) != 6 || idx.line_end(1) != 14);
+    auto lines = idx.iter(ms);
+    fail_if(lines[1] != "second" || !lines[2].empty());
+    fail_if(lines.back() != "last" || lines.front() != "first");
+    fail_if(lines.slice(1, 3).size() != 2);
+
+    buffer_stream<> saved;
+    idx.save(saved);
+    saved.seek(0);
+    auto idx2 = line_index::load(saved);
+    fail_if(idx2.size() != 4 || idx2.line_begin(3) != 15);
+
+    memory_stream nl{"a\nb\n"};
+    fail_if(line_index::build(nl).size() != 2);
+    memory_stream none{""};
+    fail_if(!line_index::build(none).empty());
+}
+#endif
+
+/** @} */
+
+} /* namespace ostd */
+
+#undef OSTD_TEST_MODULE
+
+#endif
+
+/** @} */
@@ -0,0 +1,401 @@
+/** @addtogroup Streams
+ * @{
+ */
+
+/** @file memory_stream.hh
+ *
+ * @brief Streams over memory buffers.
+ *
+ * This file implements streams that operate on data in memory rather than
+ * on files. There is a read-only stream over an existing string slice and
+ * a growable buffer stream which owns a contiguous container and can be
+ * written into as well as read from.
+ *
+ * Both support seeking, so they can be used anywhere a file stream would
+ * be used without a round trip through the filesystem:
+ *
+ * ~~~{.cc}
+ * ostd::buffer_stream<> bs;
+ * bs.writefln("%d: %s", 5, "hello");
+ * bs.seek(0);
+ * for (auto const &line: bs.iter_lines()) {
+ *     ostd::writeln(line);
+ * }
+ * ~~~
+ *
+ * @copyright See COPYING.md in the project tree for further information.
+ */
+
+#ifndef OSTD_MEMORY_STREAM_HH
+#define OSTD_MEMORY_STREAM_HH
+
+#include <ostd/unit_test.hh>
+
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <utility>
+#include <type_traits>
+
+#include <ostd/platform.hh>
+#include <ostd/string.hh>
+#include <ostd/stream.hh>
+
+#define OSTD_TEST_MODULE libostd_memory_stream
+
+namespace ostd {
+
+/** @addtogroup Streams
+ * @{
+ */
+
+namespace detail {
+    inline stream_off_t mem_stream_seek(
+        stream_off_t cur, stream_off_t size, stream_off_t pos,
+        stream_seek whence
+    ) {
+        stream_off_t base = 0;
+        switch (whence) {
+            case stream_seek::CUR: base = cur; break;
+            case stream_seek::END: base = size; break;
+            default: break;
+        }
+        if ((pos < 0) && (-pos > base)) {
+            throw stream_error{EINVAL, std::generic_category()};
+        }
+        return base + pos;
+    }
+}
+
+/** @brief A read-only stream over a string slice.
+ *
+ * The stream does not own the memory, it only keeps the slice, so the
+ * data has to outlive the stream. Reading past the end is not an error
+ * but sets the end-of-stream indicator just like with file streams.
+ *
+ * It is fully seekable, including the end-of-stream reference point. It
+ * is possible to seek past the end of the data, in which case any read
+ * will simply set the end-of-stream indicator.
+ *
+ * @see ostd::buffer_stream
+ */
+struct memory_stream: stream {
+    /** @brief Creates an empty memory stream. */
+    memory_stream(): p_data() {}
+
+    /** @brief Creates a memory stream over a string slice. */
+    memory_stream(string_range data): p_data(data) {}
+
+    /** @brief Creates a memory stream over a buffer of bytes. */
+    memory_stream(void const *data, std::size_t len):
+        p_data(
+            static_cast<char const *>(data),
+            static_cast<char const *>(data) + len
+        )
+    {}
+
+    /** @brief Resets the stream to an empty state. */
+    void close() {
+        p_data = string_range{};
+        p_pos = 0;
+        p_eof = false;
+    }
+
+    /** @brief Checks if the stream has the end-of-stream indicator set.
+     *
+     * Like with files, this only becomes true after a read attempt past
+     * the end of the data, and gets cleared by a successful seek().
+     */
+    bool end() const {
+        return p_eof;
+    }
+
+    /** @brief Gets the size of the underlying data. */
+    offset_type size() {
+        return offset_type(p_data.size());
+    }
+
+    /** @brief Seeks within the stream.
+     *
+     * All reference positions are supported. Seeking before the beginning
+     * is an error.
+     *
+     * @throws ostd::stream_error with EINVAL on a negative position.
+     */
+    void seek(offset_type pos, stream_seek whence = stream_seek::SET) {
+        p_pos = std::size_t(detail::mem_stream_seek(
+            offset_type(p_pos), offset_type(p_data.size()), pos, whence
+        ));
+        p_eof = false;
+    }
+
+    /** @brief Tells the current position in the stream. */
+    offset_type tell() const {
+        return offset_type(p_pos);
+    }
+
+    /** @brief Reads at most `count` bytes from the stream.
+     *
+     * This is a single memcpy from the underlying slice and never fails.
+     * If fewer bytes than requested are available, end() becomes true.
+     */
+    std::size_t read_bytes(void *buf, std::size_t count) {
+        std::size_t left = (p_pos < p_data.size()) ? (p_data.size() - p_pos) : 0;
+        if (count > left) {
+            count = left;
+            p_eof = true;
+        }
+        if (count) {
+            std::memcpy(buf, p_data.data() + p_pos, count);
+            p_pos += count;
+        }
+        return count;
+    }
+
+    /** @brief Reads a single byte from the stream.
+     *
+     * Does not go through read_bytes().
+     *
+     * @throws ostd::stream_error with EIO at the end of the stream.
+     */
+    int get_char() {
+        if (p_pos >= p_data.size()) {
+            p_eof = true;
+            throw stream_error{EIO, std::generic_category()};
+        }
+        return static_cast<unsigned char>(p_data[p_pos++]);
+    }
+
+    /** @brief Gets the whole underlying slice. */
+    string_range data() const {
+        return p_data;
+    }
+
+    /** @brief Gets the portion of the slice that has not been read yet. */
+    string_range rest() const {
+        if (p_pos >= p_data.size()) {
+            return string_range{};
+        }
+        return p_data.slice(p_pos);
+    }
+
+private:
+    string_range p_data;
+    std::size_t p_pos = 0;
+    bool p_eof = false;
+};
+
+/** @brief A growable stream writing into a contiguous container.
+ *
+ * The stream owns a container of byte-sized values, std::string by
+ * default (std::vector<char> or similar also work). Writing at the end
+ * appends to the container, writing anywhere else overwrites the existing
+ * contents. Seeking past the end and writing fills the gap with zeros,
+ * like with files. The stream can also be read from.
+ *
+ * The container is exposed through buffer(), which is ref-qualified like
+ * the `get()` of ostd::appender(), so the buffer can be moved out of the
+ * stream once writing is done. Capacity can be controlled with reserve()
+ * to avoid repeated reallocation.
+ *
+ * @tparam TC The container type.
+ *
+ * @see ostd::memory_stream
+ */
+template<typename TC = std::string>
+struct buffer_stream: stream {
+    static_assert(
+        sizeof(typename TC::value_type) == 1,
+        "buffer_stream needs a container of byte-sized values"
+    );
+
+    /** @brief Creates an empty buffer stream. */
+    buffer_stream(): p_buf() {}
+
+    /** @brief Creates a buffer stream with the given container.
+     *
+     * The position is at the beginning, so writes will overwrite the
+     * existing contents unless you seek to the end first.
+     */
+    buffer_stream(TC const &buf): p_buf(buf) {}
+
+    /** @brief Creates a buffer stream by moving in the given container. */
+    buffer_stream(TC &&buf): p_buf(std::move(buf)) {}
+
+    /** @brief Clears the buffer and resets the position. */
+    void close() {
+        p_buf.clear();
+        p_pos = 0;
+        p_eof = false;
+    }
+
+    /** @brief Checks if the stream has the end-of-stream indicator set. */
+    bool end() const {
+        return p_eof;
+    }
+
+    /** @brief Gets the size of the buffer. */
+    offset_type size() {
+        return offset_type(p_buf.size());
+    }
+
+    /** @brief Seeks within the stream.
+     *
+     * All reference positions are supported. Seeking past the end is
+     * allowed, the buffer is only extended once something is written.
+     *
+     * @throws ostd::stream_error with EINVAL on a negative position.
+     */
+    void seek(offset_type pos, stream_seek whence = stream_seek::SET) {
+        p_pos = std::size_t(detail::mem_stream_seek(
+            offset_type(p_pos), offset_type(p_buf.size()), pos, whence
+        ));
+        p_eof = false;
+    }
+
+    /** @brief Tells the current position in the stream. */
+    offset_type tell() const {
+        return offset_type(p_pos);
+    }
+
+    /** @brief Reads at most `count` bytes from the buffer. */
+    std::size_t read_bytes(void *buf, std::size_t count) {
+        std::size_t left = (p_pos < p_buf.size()) ? (p_buf.size() - p_pos) : 0;
+        if (count > left) {
+            count = left;
+            p_eof = true;
+        }
+        if (count) {
+            std::memcpy(buf, p_buf.data() + p_pos, count);
+            p_pos += count;
+        }
+        return count;
+    }
+
+    /** @brief Writes `count` bytes into the buffer.
+     *
+     * The buffer grows as needed; the growth follows the container's own
+     * policy, use reserve() beforehand for exact control.
+     */
+    void write_bytes(void const *buf, std::size_t count) {
+        std::size_t nend = p_pos + count;
+        if (nend > p_buf.size()) {
+            p_buf.resize(nend);
+        }
+        if (count) {
+            std::memcpy(&p_buf[p_pos], buf, count);
+        }
+        p_pos = nend;
+    }
+
+    /** @brief Reads a single byte from the buffer.
+     *
+     * @throws ostd::stream_error with EIO at the end of the stream.
+     */
+    int get_char() {
+        if (p_pos >= p_buf.size()) {
+            p_eof = true;
+            throw stream_error{EIO, std::generic_category()};
+        }
+        return static_cast<unsigned char>(p_buf[p_pos++]);
+    }
+
+    /** @brief Writes a single byte into the buffer. */
+    void put_char(int c) {
+        using VT = typename TC::value_type;
+        if (p_pos == p_buf.size()) {
+            p_buf.push_back(VT(static_cast<unsigned char>(c)));
+            ++p_pos;
+            return;
+        }
+        unsigned char wc = static_cast<unsigned char>(c);
+        write_bytes(&wc, 1);
+    }
+
+    /** @brief Reserves capacity in the underlying container. */
+    void reserve(std::size_t cap) {
+        p_buf.reserve(cap);
+    }
+
+    /** @brief Gets the capacity of the underlying container. */
+    std::size_t capacity() const {
+        return p_buf.capacity();
+    }
+
+    /** @brief Gets the written data as a string slice. */
+    string_range data() const {
+        auto *p = reinterpret_cast<char const *>(p_buf.data());
+        return string_range{p, p + p_buf.size()};
+    }
+
+    /** @brief Gets the underlying container. */
+    TC &buffer() & { return p_buf; }
+
+    /** @brief Gets the underlying container. */
+    TC const &buffer() const & { return p_buf; }
+
+    /** @brief Moves the underlying container out of the stream.
+     *
+     * The stream is left at position zero with an empty buffer.
+     */
+    TC buffer() && {
+        p_pos = 0;
+        p_eof = false;
+        return std::move(p_buf);
+    }
+
+private:
+    TC p_buf;
+    std::size_t p_pos = 0;
+    bool p_eof = false;
+};
+
+#ifdef OSTD_BUILD_TESTS
+OSTD_UNIT_TEST {
+    using ostd::test::fail_if;
+    memory_stream ms{"foo\nbar\r\nbaz"};
+    fail_if(ms.size() != 12);
+    std::string lines;
+    for (auto const &l: ms.iter_lines()) {
+        lines += l;
+        lines += '|';
+    }
+    fail_if(lines != "foo|bar|baz|");
+    fail_if(!ms.end());
+    ms.seek(-3, stream_seek::END);
+    fail_if(ms.end() || (ms.tell() != 9));
+    fail_if(ms.get_char() != 'b');
+    fail_if(ms.rest() != "az");
+    char buf[8];
+    fail_if(ms.read_bytes(buf, sizeof(buf)) != 2);
+    fail_if(!ms.end());
+
+    buffer_stream<> bs;
+    bs.reserve(64);
+    bs.writef("%d-%s", 42, "abc");
+    fail_if(bs.data() != "42-abc");
+    bs.seek(1);
+    bs.put_char('X');
+    fail_if(bs.data() != "4X-abc");
+    bs.seek(2, stream_seek::END);
+    bs.write("!");
+    fail_if(bs.size() != 9);
+    fail_if(bs.buffer()[6] != '\0' || bs.buffer()[8] != '!');
+    bs.seek(0);
+    fail_if(bs.get<char>() != '4');
+    auto s = std::move(bs).buffer();
+    fail_if(s.size() != 9);
+    fail_if(bs.size() != 0);
+}
+#endif
+
+/** @} */
+
+} /* namespace ostd */
+
+#undef OSTD_TEST_MODULE
+
+#endif
+
+/** @} */
@@ -0,0 +1,379 @@
+/** @addtogroup Strings
+ * @{
+ */
+
+/** @file multi_match.hh
+ *
+ * @brief Searching for many patterns at once.
+ *
+ * Looking for each of a set of patterns separately means going over the
+ * data once per pattern. This file provides a matcher compiled from all
+ * of the patterns (using the Aho-Corasick algorithm), which finds every
+ * occurrence of every pattern in a single pass. The matching state can
+ * be kept between pieces of data, so that matches spanning the boundary
+ * of two buffers are found as well.
+ *
+ * ~~~{.cc}
+ * ostd::multi_matcher m{"error", "warning", "fatal"};
+ * ostd::multi_match_scanner sc{m};
+ * for (auto line: ostd::cin.iter_lines(true)) {
+ *     sc.feed(line, [&m](ostd::multi_match const &mt) {
+ *         ostd::writefln("%s at %d", m.pattern(mt.pattern), mt.position);
+ *     });
+ * }
+ * ~~~
+ *
+ * @copyright See COPYING.md in the project tree for further information.
+ */
+
+#ifndef OSTD_MULTI_MATCH_HH
+#define OSTD_MULTI_MATCH_HH
+
+#include <ostd/unit_test.hh>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <initializer_list>
+
+#include <ostd/platform.hh>
+#include <ostd/range.hh>
+#include <ostd/string.hh>
+#include <ostd/stream.hh>
+
+#ifdef OSTD_BUILD_TESTS
+#include <utility>
+#include <ostd/memory_stream.hh>
+#endif
+
+#define OSTD_TEST_MODULE libostd_multi_match
+
+namespace ostd {
+
+/** @addtogroup Strings
+ * @{
+ */
+
+/** @brief A single match found by an ostd::multi_matcher. */
+struct multi_match {
+    /** @brief The index of the matched pattern. */
+    std::size_t pattern;
+    /** @brief The offset of the first byte of the match. */
+    std::size_t position;
+};
+
+/** @brief A matcher for a fixed set of patterns.
+ *
+ * The patterns are compiled into an automaton once, and the automaton
+ * is then used to find all of them in any amount of data. Each byte of
+ * the data is examined exactly once, no matter how many patterns there
+ * are, and no byte is ever looked at again, which is what allows the
+ * data to be given in pieces (see ostd::multi_match_scanner).
+ *
+ * All occurrences are reported, including overlapping ones, ordered by
+ * the position of their last byte; when several patterns end at the
+ * same byte, the longer ones come first. If the same pattern is given
+ * more than once, every copy is reported. Empty patterns never match.
+ *
+ * The automaton is stored as a dense transition table when that's small
+ * enough, i.e. when the patterns are made of a small set of distinct
+ * bytes (such as words of text) and their total size is reasonable;
+ * the bytes that appear in no pattern all share a single column of the
+ * table. Otherwise it's stored as a trie with failure links, which is
+ * more compact but slower to match with.
+ *
+ * The matching is byte-based, so with UTF-8 input and patterns, matches
+ * are always positioned on whole code points.
+ */
+struct OSTD_EXPORT multi_matcher {
+    /** @brief Creates a matcher with no patterns, which never matches. */
+    multi_matcher() {
+        compile();
+    }
+
+    /** @brief Creates a matcher from a list of patterns.
+     *
+     * The patterns are numbered in the given order, starting with zero.
+     */
+    multi_matcher(std::initializer_list<string_range> patterns) {
+        for (auto p: patterns) {
+            p_patterns.emplace_back(p.data(), p.size());
+        }
+        compile();
+    }
+
+    /** @brief Creates a matcher from a range or container of patterns.
+     *
+     * The elements can be anything convertible to ostd::string_range.
+     * The patterns are numbered in the given order, starting with zero.
+     */
+    template<typename R>
+    explicit multi_matcher(R const &patterns) {
+        for (auto &&p: patterns) {
+            string_range sr{p};
+            p_patterns.emplace_back(sr.data(), sr.size());
+        }
+        compile();
+    }
+
+    /** @brief Gets the number of patterns. */
+    std::size_t size() const noexcept {
+        return p_patterns.size();
+    }
+
+    /** @brief Gets the pattern with the index `i`. */
+    string_range pattern(std::size_t i) const noexcept {
+        return string_range{p_patterns[i]};
+    }
+
+    /** @brief Checks if the automaton uses a dense transition table. */
+    bool dense() const noexcept {
+        return !p_delta.empty();
+    }
+
+    /** @brief Finds all matches in a string.
+     *
+     * Calls `func` with an ostd::multi_match for every match, where the
+     * position is an offset into `data`.
+     */
+    template<typename F>
+    void match(string_range data, F func) const;
+
+    /** @brief Finds all matches in the rest of a stream.
+     *
+     * The stream is read in blocks until its end; the positions are
+     * offsets from where the stream was when this was called.
+     *
+     * @throws ostd::stream_error on read errors.
+     */
+    template<typename F>
+    void match(stream &s, F func) const;
+
+    /** @brief Checks if any of the patterns occurs in a string. */
+    bool contains_any(string_range data) const noexcept {
+        std::uint32_t st = 0;
+        for (unsigned char c: data) {
+            st = step(st, c);
+            if (p_report[st]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    friend struct multi_match_scanner;
+
+    static constexpr std::size_t BLOCK_SIZE = 1 << 16;
+
+    /* the maximum number of entries of the dense table */
+    static constexpr std::size_t DENSE_MAX = 1 << 20;
+
+    void compile();
+
+    std::uint32_t step(std::uint32_t st, unsigned char c) const noexcept {
+        if (!p_delta.empty()) {
+            return p_delta[st * p_nclasses + p_classes[c]];
+        }
+        if (!p_classes[c]) {
+            return 0;
+        }
+        for (;;) {
+            for (auto i = p_edges[st], e = p_edges[st + 1]; i != e; ++i) {
+                if (p_edge_bytes[i] == c) {
+                    return p_edge_states[i];
+                }
+            }
+            if (!st) {
+                return 0;
+            }
+            st = p_fail[st];
+        }
+    }
+
+    template<typename F>
+    void report(std::uint32_t st, std::size_t end, F &func) const {
+        for (st = p_report[st]; st; st = p_dict[st]) {
+            for (auto i = p_outs[st], e = p_outs[st + 1]; i != e; ++i) {
+                std::size_t pat = p_out_pats[i];
+                func(multi_match{pat, end - p_patterns[pat].size()});
+            }
+        }
+    }
+
+    std::vector<std::string> p_patterns;
+    /* byte to its column in the dense table, 0 if in no pattern */
+    std::uint16_t p_classes[256];
+    std::size_t p_nclasses = 1;
+    /* dense transitions, empty when sparse */
+    std::vector<std::uint32_t> p_delta;
+    /* sparse transitions: the trie edges of each state and failure links */
+    std::vector<std::uint32_t> p_edges;
+    std::vector<unsigned char> p_edge_bytes;
+    std::vector<std::uint32_t> p_edge_states;
+    std::vector<std::uint32_t> p_fail;
+    /* first state with output on the suffix chain, including itself */
+    std::vector<std::uint32_t> p_report;
+    /* next state with output on the suffix chain, excluding itself */
+    std::vector<std::uint32_t> p_dict;
+    /* patterns ending in each state */
+    std::vector<std::uint32_t> p_outs;
+    std::vector<std::uint32_t> p_out_pats;
+};
+
+/** @brief An incremental search using an ostd::multi_matcher.
+ *
+ * The scanner keeps the state of the automaton and the number of bytes
+ * given so far, so the data can be fed in pieces of any size and the
+ * matches are the same as if it was given all at once. The reported
+ * positions are counted from the beginning of all the data.
+ *
+ * When feeding lines from ostd::stream::iter_lines(), keep the newlines
+ * to get positions in the stream, or call reset() before each line when
+ * matches should not span lines.
+ *
+ * The scanner only refers to the matcher, so the matcher must stay alive
+ * while the scanner is used. Any number of scanners can share a matcher,
+ * including from different threads.
+ */
+struct multi_match_scanner {
+    multi_match_scanner() = delete;
+
+    /** @brief Creates a scanner at the beginning of the data. */
+    multi_match_scanner(multi_matcher const &m) noexcept: p_matcher(&m) {}
+
+    /** @brief Gets the matcher used by the scanner. */
+    multi_matcher const &matcher() const noexcept {
+        return *p_matcher;
+    }
+
+    /** @brief Gets the number of bytes fed so far. */
+    std::size_t position() const noexcept {
+        return p_pos;
+    }
+
+    /** @brief Starts over, as if nothing was fed yet. */
+    void reset() noexcept {
+        p_state = 0;
+        p_pos = 0;
+    }
+
+    /** @brief Continues the search with another piece of data.
+     *
+     * Calls `func` with an ostd::multi_match for every match that ends
+     * within `data`, even if it starts in a previous piece.
+     */
+    template<typename F>
+    void feed(string_range data, F func) {
+        auto &m = *p_matcher;
+        auto st = p_state;
+        auto pos = p_pos;
+        auto *b = reinterpret_cast<unsigned char const *>(data.data());
+        auto *p = b, *e = b + data.size();
+        if (m.dense()) {
+            auto *delta = m.p_delta.data();
+            auto *cls = m.p_classes;
+            auto *rep = m.p_report.data();
+            auto ncls = m.p_nclasses;
+            for (; p != e; ++p) {
+                st = delta[st * ncls + cls[*p]];
+                if (rep[st]) {
+                    m.report(st, pos + std::size_t(p - b) + 1, func);
+                }
+            }
+        } else {
+            for (; p != e; ++p) {
+                st = m.step(st, *p);
+                if (m.p_report[st]) {
+                    m.report(st, pos + std::size_t(p - b) + 1, func);
+                }
+            }
+        }
+        p_state = st;
+        p_pos = pos + data.size();
+    }
+
+private:
+    multi_matcher const *p_matcher;
+    std::uint32_t p_state = 0;
+    std::size_t p_pos = 0;
+};
+
+template<typename F>
+inline void multi_matcher::match(string_range data, F func) const {
+    multi_match_scanner{*this}.feed(data, func);
+}
+
+template<typename F>
+inline void multi_matcher::match(stream &s, F func) const {
+    multi_match_scanner sc{*this};
+    std::vector<char> buf(BLOCK_SIZE);
+    for (;;) {
+        std::size_t n = s.read_bytes(buf.data(), buf.size());
+        if (!n) {
+            break;
+        }
+        sc.feed(string_range{buf.data(), buf.data() + n}, func);
+    }
+}
+
+#ifdef OSTD_BUILD_TESTS
+OSTD_UNIT_TEST {
+    using ostd::test::fail_if;
+    using mres = std::vector<std::pair<std::size_t, std::size_t>>;
+    auto collect = [](mres &out) {
+        return [&out](multi_match const &m) {
+            out.emplace_back(m.pattern, m.position);
+        };
+    };
+
+    multi_matcher m{"he", "she", "his", "hers", ""};
+    fail_if(m.size() != 5 || !m.dense() || m.pattern(2) != "his");
+    mres res;
+    m.match("ushers", collect(res));
+    fail_if(res != mres{{1, 1}, {0, 2}, {3, 2}});
+    fail_if(!m.contains_any("this") || m.contains_any("hxs"));
+
+    /* the same matches when fed in pieces */
+    mres pieces;
+    multi_match_scanner sc{m};
+    sc.feed("us", collect(pieces));
+    sc.feed("h", collect(pieces));
+    sc.feed("", collect(pieces));
+    sc.feed("ers", collect(pieces));
+    fail_if(pieces != res || sc.position() != 6);
+    sc.reset();
+    sc.feed("ers", collect(pieces));
+    fail_if(pieces.size() != 3);
+
+    /* overlapping and repeated patterns */
+    std::vector<std::string> pats{"aa", "a", "aa"};
+    multi_matcher rep{pats};
+    res.clear();
+    rep.match("aaa", collect(res));
+    fail_if(res != mres{
+        {1, 0}, {0, 0}, {2, 0}, {1, 1}, {0, 1}, {2, 1}, {1, 2}
+    });
+
+    memory_stream ms{"one two three two one"};
+    multi_matcher words{"two", "one"};
+    res.clear();
+    words.match(ms, collect(res));
+    fail_if(res != mres{{1, 0}, {0, 4}, {0, 14}, {1, 18}});
+
+    res.clear();
+    multi_matcher{}.match("anything", collect(res));
+    fail_if(!res.empty());
+}
+#endif
+
+/** @} */
+
+} /* namespace ostd */
+
+#undef OSTD_TEST_MODULE
+
+#endif
+
+/** @} */
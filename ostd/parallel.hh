@@ -0,0 +1,891 @@
+/** @addtogroup Concurrency
+ * @{
+ */
+
+/** @file parallel.hh
+ *
+ * @brief Parallel stages for range pipelines.
+ *
+ * Range pipelines built with the `|` syntax are lazy and run entirely on
+ * the thread that iterates them. This file provides pipeline stages that
+ * run on tasks of their own, either on the current scheduler or on an
+ * ostd::thread_pool, and are connected to the rest of the pipeline with
+ * bounded buffers, so that a slow consumer stops the producers instead of
+ * letting them run ahead without limits.
+ *
+ * ostd::par_map() calls a function on several workers at once, keeping
+ * the order of the input, while ostd::par_map_unordered() passes on the
+ * results as they're done. ostd::stage() runs everything before it on a
+ * single task of its own, so that it overlaps with everything after it.
+ *
+ * ~~~{.cc}
+ * ostd::thread_pool tp;
+ * tp.start();
+ * auto r = f.iter_lines()
+ *     | ostd::stage(tp)
+ *     | ostd::par_map(tp, [](auto &line) { return parse(line); })
+ *     | ostd::filter([](auto &rec) { return rec.valid; });
+ * for (auto &rec: r) {
+ *     store(rec);
+ * }
+ * ~~~
+ *
+ * Both stages use the default number of workers, the size of the pool,
+ * as workers that can't go on give their threads back to the pool; the
+ * pool only needs a thread for each of the two stages chained on it.
+ *
+ * @copyright See COPYING.md in the project tree for further information.
+ */
+
+#ifndef OSTD_PARALLEL_HH
+#define OSTD_PARALLEL_HH
+
+#include <ostd/unit_test.hh>
+
+#include <cstddef>
+#include <vector>
+#include <optional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <stdexcept>
+#include <exception>
+#include <algorithm>
+#include <type_traits>
+
+#include <ostd/platform.hh>
+#include <ostd/range.hh>
+#include <ostd/generic_condvar.hh>
+#include <ostd/concurrency.hh>
+#include <ostd/thread_pool.hh>
+
+#define OSTD_TEST_MODULE libostd_parallel
+
+namespace ostd {
+
+/** @addtogroup Concurrency
+ * @{
+ */
+
+namespace detail {
+    /* pool threads are not to be blocked waiting for other workers, as
+     * those may need the same threads, so workers park there instead
+     */
+    struct par_pool_exec {
+        static constexpr bool park = true;
+
+        thread_pool *p_pool;
+
+        template<typename F>
+        void spawn(F func) {
+            p_pool->push(std::move(func));
+        }
+
+        generic_condvar make_condition() {
+            return generic_condvar{};
+        }
+
+        std::size_t concurrency() const {
+            return p_pool->threads();
+        }
+    };
+
+    struct par_sched_exec {
+        static constexpr bool park = false;
+
+        scheduler *p_sched;
+
+        template<typename F>
+        void spawn(F func) {
+            p_sched->spawn(std::move(func));
+        }
+
+        generic_condvar make_condition() {
+            return p_sched->make_condition();
+        }
+
+        std::size_t concurrency() const {
+            return std::thread::hardware_concurrency();
+        }
+    };
+
+    inline par_sched_exec par_current_exec() {
+        if (!current_scheduler) {
+            throw std::logic_error{"no scheduler is running"};
+        }
+        return par_sched_exec{current_scheduler};
+    }
+
+    enum class par_claim {
+        OK, STOP, PARK
+    };
+
+    /* the part of the state that does not depend on the source range
+     *
+     * Results are stored in a ring of slots, which the consumer reads in
+     * order. A worker may only take a new input while fewer than the
+     * number of slots are taken but not yet consumed, which bounds the
+     * memory and guarantees that results never overwrite each other; in
+     * ordered mode a result goes to the slot of its input's sequence
+     * number, otherwise to the next slot in order of completion.
+     *
+     * When parking, a worker that can't take an input returns instead of
+     * waiting, and is spawned again once it can; it stays pending in the
+     * meantime.
+     */
+    template<typename T>
+    struct par_state_base {
+        template<typename CF>
+        par_state_base(
+            CF &cf, std::size_t nslots, bool ordered, bool park
+        ):
+            p_space(cf()), p_ready(cf()), p_slots(nslots),
+            p_ordered(ordered), p_park(park)
+        {}
+
+        virtual ~par_state_base() {}
+
+        /* spawns a parked worker again */
+        virtual void respawn() = 0;
+
+        /* drops the source and the function after the last worker */
+        virtual void drop() = 0;
+
+        void fail(std::exception_ptr e) {
+            {
+                std::lock_guard<std::mutex> l{p_lock};
+                if (!p_eptr) {
+                    p_eptr = e;
+                }
+                p_stop = true;
+            }
+            p_space.notify_all();
+            p_ready.notify_all();
+        }
+
+        /* false if the workers were stopped before this one started */
+        bool enter() {
+            std::lock_guard<std::mutex> l{p_lock};
+            ++p_running;
+            return !p_stop;
+        }
+
+        /* true for the last worker to finish */
+        bool done() {
+            std::lock_guard<std::mutex> l{p_lock};
+            return !--p_pending;
+        }
+
+        void leave() {
+            {
+                std::lock_guard<std::mutex> l{p_lock};
+                --p_running;
+            }
+            p_ready.notify_all();
+        }
+
+        /* claims the source along with a free slot, so that the source
+         * is only ever used by one worker at a time; no lock is held while
+         * it's used, as it can itself wait, which may switch tasks
+         */
+        par_claim claim() {
+            std::unique_lock<std::mutex> l{p_lock};
+            while (!p_stop && busy()) {
+                if (p_park) {
+                    ++p_parked;
+                    return par_claim::PARK;
+                }
+                p_space.wait(l);
+            }
+            if (p_stop) {
+                /* pass the wakeup on to the next worker, as the conditions
+                 * of some schedulers wake only one waiter even on notify_all
+                 */
+                l.unlock();
+                p_space.notify_one();
+                return par_claim::STOP;
+            }
+            p_pulling = true;
+            return par_claim::OK;
+        }
+
+        /* spawns a parked worker if it can take an input now */
+        void unpark() {
+            {
+                std::lock_guard<std::mutex> l{p_lock};
+                if (!p_parked || p_stop || busy()) {
+                    return;
+                }
+                --p_parked;
+            }
+            try {
+                respawn();
+            } catch (...) {
+                {
+                    std::lock_guard<std::mutex> l{p_lock};
+                    ++p_parked;
+                }
+                fail(std::current_exception());
+            }
+        }
+
+        /* gives the source back, returns the sequence number of the item */
+        std::size_t release(bool got) {
+            std::size_t seq;
+            {
+                std::lock_guard<std::mutex> l{p_lock};
+                p_pulling = false;
+                seq = p_taken;
+                p_taken += got;
+            }
+            p_space.notify_all();
+            unpark();
+            return seq;
+        }
+
+        void finish(std::size_t seq, T &&v) {
+            {
+                std::lock_guard<std::mutex> l{p_lock};
+                std::size_t pos = p_ordered ? seq : p_done++;
+                p_slots[pos % p_slots.size()].emplace(std::move(v));
+            }
+            p_ready.notify_all();
+        }
+
+        bool fetch(std::optional<T> &cur) {
+            std::unique_lock<std::mutex> l{p_lock};
+            for (;;) {
+                if (p_eptr) {
+                    std::rethrow_exception(std::exchange(p_eptr, nullptr));
+                }
+                auto &slot = p_slots[p_consumed % p_slots.size()];
+                if (slot) {
+                    cur = std::move(slot);
+                    slot.reset();
+                    ++p_consumed;
+                    break;
+                }
+                if (!p_pending) {
+                    return false;
+                }
+                p_ready.wait(l);
+            }
+            l.unlock();
+            p_space.notify_one();
+            unpark();
+            return true;
+        }
+
+        void stop() {
+            bool last;
+            {
+                std::lock_guard<std::mutex> l{p_lock};
+                p_stop = true;
+                /* parked workers are never spawned again */
+                std::size_t n = std::exchange(p_parked, 0);
+                p_pending -= n;
+                last = n && !p_pending;
+            }
+            if (last) {
+                drop();
+            }
+            p_space.notify_all();
+            std::unique_lock<std::mutex> l{p_lock};
+            while (p_running) {
+                p_ready.wait(l);
+            }
+        }
+
+        bool busy() const {
+            return p_pulling || ((p_taken - p_consumed) >= p_slots.size());
+        }
+
+        std::mutex p_lock;
+        generic_condvar p_space, p_ready;
+        std::vector<std::optional<T>> p_slots;
+        std::exception_ptr p_eptr;
+        std::size_t p_taken = 0, p_done = 0, p_consumed = 0;
+        /* spawned but not finished, actually running, and parked */
+        std::size_t p_pending = 0, p_running = 0, p_parked = 0;
+        /* the pool the workers run on and the number of stages directly
+         * on top of each other on it, this one included
+         */
+        thread_pool *p_pool = nullptr;
+        std::size_t p_chain = 1;
+        bool p_ordered, p_park, p_stop = false, p_pulling = false;
+    };
+
+    template<typename T, typename E, typename R, typename F>
+    struct par_state:
+        par_state_base<T>, std::enable_shared_from_this<par_state<T, E, R, F>>
+    {
+        template<typename CF>
+        par_state(
+            CF &cf, std::size_t nslots, bool ordered, E ex, R range, F func
+        ):
+            par_state_base<T>(cf, nslots, ordered, E::park), p_exec(ex),
+            p_range(std::move(range)), p_func(std::move(func))
+        {}
+
+        void spawn() {
+            p_exec.spawn([st = this->shared_from_this()]() {
+                st->run();
+            });
+        }
+
+        void respawn() override {
+            spawn();
+        }
+
+        void run() {
+            bool parked = false;
+            if (this->enter()) {
+                try {
+                    parked = work();
+                } catch (...) {
+                    this->fail(std::current_exception());
+                }
+            }
+            /* the last worker drops the source and the function while it's
+             * still a running task; the source may be another stage, which
+             * has to wait for its workers when destroyed, and that can't be
+             * done wherever the scheduler happens to destroy this closure
+             */
+            if (!parked && this->done()) {
+                drop();
+            }
+            this->leave();
+        }
+
+        /* accounts for workers that could not be spawned */
+        void abandon(std::size_t n) {
+            bool last;
+            {
+                std::lock_guard<std::mutex> l{this->p_lock};
+                last = !(this->p_pending -= n);
+            }
+            if (last) {
+                drop();
+            }
+        }
+
+        void drop() override {
+            p_range.reset();
+            p_func.reset();
+        }
+
+    private:
+        /* true if the worker was parked */
+        bool work() {
+            for (;;) {
+                std::optional<std::decay_t<range_reference_t<R>>> item;
+                switch (this->claim()) {
+                    case par_claim::OK:
+                        break;
+                    case par_claim::STOP:
+                        return false;
+                    case par_claim::PARK:
+                        return true;
+                }
+                try {
+                    if (p_range->empty()) {
+                        this->release(false);
+                        return false;
+                    }
+                    item.emplace(p_range->front());
+                    p_range->pop_front();
+                } catch (...) {
+                    this->release(false);
+                    throw;
+                }
+                std::size_t seq = this->release(true);
+                this->finish(seq, T((*p_func)(*item)));
+            }
+        }
+
+        E p_exec;
+        std::optional<R> p_range;
+        std::optional<F> p_func;
+    };
+
+    template<typename T>
+    struct par_handle {
+        ~par_handle() {
+            p_state->stop();
+        }
+
+        bool fetch() {
+            return p_cur || p_state->fetch(p_cur);
+        }
+
+        std::shared_ptr<par_state_base<T>> p_state;
+        std::optional<T> p_cur;
+    };
+
+    template<typename T>
+    struct par_range: input_range<par_range<T>> {
+        using range_category = input_range_tag;
+        using value_type     = T;
+        using reference      = T &;
+        using size_type      = std::size_t;
+
+        par_range() = delete;
+        par_range(std::shared_ptr<par_handle<T>> h): p_h(std::move(h)) {}
+
+        bool empty() const { return !p_h->fetch(); }
+
+        void pop_front() {
+            if (p_h->fetch()) {
+                p_h->p_cur.reset();
+            }
+        }
+
+        reference front() const {
+            p_h->fetch();
+            return *p_h->p_cur;
+        }
+
+        par_state_base<T> const &state() const {
+            return *p_h->p_state;
+        }
+
+    private:
+        std::shared_ptr<par_handle<T>> p_h;
+    };
+
+    /* the number of stages on `pool` the source is directly on top of */
+    template<typename R>
+    inline std::size_t par_chain(R const &, thread_pool *) {
+        return 0;
+    }
+
+    template<typename T>
+    inline std::size_t par_chain(par_range<T> const &r, thread_pool *pool) {
+        return (r.state().p_pool == pool) ? r.state().p_chain : 0;
+    }
+
+    template<typename E, typename R, typename F>
+    inline auto par_start(
+        E ex, R range, F func, std::size_t workers, std::size_t nslots,
+        bool ordered
+    ) {
+        using V = std::decay_t<range_reference_t<R>>;
+        using T = std::decay_t<std::invoke_result_t<F &, V &>>;
+        static_assert(
+            !std::is_void_v<T>, "the function must return a value"
+        );
+        if (!workers) {
+            workers = std::max(ex.concurrency(), std::size_t(1));
+        }
+        if (!nslots) {
+            nslots = workers * 4;
+        }
+        /* a worker taking its input from another stage on the same pool
+         * waits for it on its thread, so every stage in such a chain keeps
+         * one of the threads and the first one needs at least one more
+         */
+        thread_pool *pool = nullptr;
+        std::size_t chain = 1;
+        if constexpr(std::is_same_v<E, par_pool_exec>) {
+            pool = ex.p_pool;
+            chain += par_chain(range, pool);
+            if (chain > pool->threads()) {
+                throw std::logic_error{
+                    "not enough threads in the pool for the chained stages"
+                };
+            }
+        }
+        auto cf = [&ex]() {
+            return ex.make_condition();
+        };
+        auto st = std::make_shared<par_state<T, E, R, F>>(
+            cf, std::max(nslots, workers), ordered, ex,
+            std::move(range), std::move(func)
+        );
+        auto h = std::make_shared<par_handle<T>>();
+        h->p_state = st;
+        st->p_pool = pool;
+        st->p_chain = chain;
+        st->p_pending = workers;
+        for (std::size_t i = 0; i < workers; ++i) {
+            try {
+                st->spawn();
+            } catch (...) {
+                /* the ones not spawned will never finish */
+                st->abandon(workers - i);
+                throw;
+            }
+        }
+        return par_range<T>{std::move(h)};
+    }
+
+    template<typename R>
+    using ParRange = std::enable_if_t<is_input_range<R>, R>;
+
+    struct par_identity {
+        template<typename T>
+        T operator()(T &v) const {
+            return std::move(v);
+        }
+    };
+} /* namespace detail */
+
+/** @brief Maps a range in parallel on the current scheduler.
+ *
+ * Works like ostd::map(), but `func` is called on `workers` tasks at once,
+ * spawned on the current scheduler (see ostd::spawn()), which must be
+ * running. The workers take items from `range` one by one, so `range`
+ * itself is only ever accessed by one of them at a time; `func` must be
+ * safe to call from several tasks at once. The results are passed on in
+ * the same order as the items of `range`.
+ *
+ * At most `buffer` items are in flight at any time, counting the ones
+ * being mapped as well as finished results that have not been consumed
+ * yet; once the buffer is full, the workers wait for the consumer. With
+ * zero `workers`, the number of hardware threads is used, and with zero
+ * `buffer`, four items per worker are allowed.
+ *
+ * The resulting range is an ostd::input_range_tag whose copies all share
+ * the same position. Its value type is the decayed return type of `func`
+ * and its reference type is an lvalue reference to that. The workers start
+ * right away. If `func` or `range` throws, the workers stop and the
+ * exception is rethrown from the next access to the resulting range.
+ * When the last copy of the resulting range is destroyed, the workers
+ * are stopped and waited for, so `func` may safely refer to local state.
+ *
+ * Because every item goes through a lock, `func` should do noticeably
+ * more work than that for this to be worth it.
+ *
+ * @see ostd::par_map_unordered(), ostd::stage()
+ */
+template<typename InputRange, typename UnaryFunction>
+inline auto par_map(
+    InputRange range, UnaryFunction func,
+    std::size_t workers = 0, std::size_t buffer = 0
+) -> decltype(detail::par_start(
+    detail::par_current_exec(), std::declval<
+        detail::ParRange<InputRange>
+    >(), std::move(func), workers, buffer, true
+)) {
+    return detail::par_start(
+        detail::par_current_exec(), std::move(range), std::move(func),
+        workers, buffer, true
+    );
+}
+
+/** @brief Maps a range in parallel on a thread pool.
+ *
+ * Like ostd::par_map(), but the workers are queued onto `pool` and the
+ * default number of workers is the size of the pool. A worker that has
+ * to wait for space in the buffer or for its turn to take an item gives
+ * its thread back to the pool and is queued again once it can go on, so
+ * any number of workers and stages can share the pool.
+ *
+ * A worker taking an item from another stage on the same pool, such as
+ * in `ostd::stage(pool) | ostd::par_map(pool, func)`, waits for it on
+ * its thread though. Such a chain of stages directly on top of each
+ * other therefore needs a thread per stage, and std::logic_error is
+ * thrown if the pool has fewer threads than that.
+ */
+template<typename InputRange, typename UnaryFunction>
+inline auto par_map(
+    thread_pool &pool, InputRange range, UnaryFunction func,
+    std::size_t workers = 0, std::size_t buffer = 0
+) -> decltype(detail::par_start(
+    detail::par_pool_exec{&pool}, std::declval<
+        detail::ParRange<InputRange>
+    >(), std::move(func), workers, buffer, true
+)) {
+    return detail::par_start(
+        detail::par_pool_exec{&pool}, std::move(range), std::move(func),
+        workers, buffer, true
+    );
+}
+
+/** @brief A pipeable version of ostd::par_map().
+ *
+ * The `func` is forwarded.
+ */
+template<typename UnaryFunction>
+inline auto par_map(
+    UnaryFunction &&func, std::size_t workers = 0, std::size_t buffer = 0
+) {
+    return [
+        func = std::forward<UnaryFunction>(func), workers, buffer
+    ](auto &obj) mutable {
+        return par_map(
+            obj, std::forward<UnaryFunction>(func), workers, buffer
+        );
+    };
+}
+
+/** @brief A pipeable version of ostd::par_map() with a thread pool.
+ *
+ * The `func` is forwarded.
+ */
+template<typename UnaryFunction>
+inline auto par_map(
+    thread_pool &pool, UnaryFunction &&func,
+    std::size_t workers = 0, std::size_t buffer = 0
+) {
+    return [
+        &pool, func = std::forward<UnaryFunction>(func), workers, buffer
+    ](auto &obj) mutable {
+        return par_map(
+            pool, obj, std::forward<UnaryFunction>(func), workers, buffer
+        );
+    };
+}
+
+/** @brief Maps a range in parallel, passing results on as they're done.
+ *
+ * Like ostd::par_map(), but the results come in the order in which the
+ * workers finish them, so one slow item does not hold back the others.
+ */
+template<typename InputRange, typename UnaryFunction>
+inline auto par_map_unordered(
+    InputRange range, UnaryFunction func,
+    std::size_t workers = 0, std::size_t buffer = 0
+) -> decltype(detail::par_start(
+    detail::par_current_exec(), std::declval<
+        detail::ParRange<InputRange>
+    >(), std::move(func), workers, buffer, false
+)) {
+    return detail::par_start(
+        detail::par_current_exec(), std::move(range), std::move(func),
+        workers, buffer, false
+    );
+}
+
+/** @brief Like ostd::par_map_unordered(), but on a thread pool.
+ *
+ * See ostd::par_map() for the requirements on the pool.
+ */
+template<typename InputRange, typename UnaryFunction>
+inline auto par_map_unordered(
+    thread_pool &pool, InputRange range, UnaryFunction func,
+    std::size_t workers = 0, std::size_t buffer = 0
+) -> decltype(detail::par_start(
+    detail::par_pool_exec{&pool}, std::declval<
+        detail::ParRange<InputRange>
+    >(), std::move(func), workers, buffer, false
+)) {
+    return detail::par_start(
+        detail::par_pool_exec{&pool}, std::move(range), std::move(func),
+        workers, buffer, false
+    );
+}
+
+/** @brief A pipeable version of ostd::par_map_unordered().
+ *
+ * The `func` is forwarded.
+ */
+template<typename UnaryFunction>
+inline auto par_map_unordered(
+    UnaryFunction &&func, std::size_t workers = 0, std::size_t buffer = 0
+) {
+    return [
+        func = std::forward<UnaryFunction>(func), workers, buffer
+    ](auto &obj) mutable {
+        return par_map_unordered(
+            obj, std::forward<UnaryFunction>(func), workers, buffer
+        );
+    };
+}
+
+/** @brief A pipeable version of ostd::par_map_unordered() with a pool.
+ *
+ * The `func` is forwarded.
+ */
+template<typename UnaryFunction>
+inline auto par_map_unordered(
+    thread_pool &pool, UnaryFunction &&func,
+    std::size_t workers = 0, std::size_t buffer = 0
+) {
+    return [
+        &pool, func = std::forward<UnaryFunction>(func), workers, buffer
+    ](auto &obj) mutable {
+        return par_map_unordered(
+            pool, obj, std::forward<UnaryFunction>(func), workers, buffer
+        );
+    };
+}
+
+/** @brief Iterates a range on a task of its own.
+ *
+ * A single task spawned on the current scheduler iterates `range` and
+ * stores copies of its items in a buffer of `buffer` items (64 when
+ * zero), from which the resulting range takes them. This way the work
+ * done by `range`, such as reading a file or a chain of ostd::map() and
+ * ostd::filter() calls, overlaps with the work done on the results.
+ *
+ * The resulting range behaves the same as the one of ostd::par_map().
+ */
+template<typename InputRange>
+inline auto stage(InputRange range, std::size_t buffer = 0) -> decltype(
+    detail::par_start(
+        detail::par_current_exec(), std::declval<
+            detail::ParRange<InputRange>
+        >(), detail::par_identity{}, 1, buffer, true
+    )
+) {
+    return detail::par_start(
+        detail::par_current_exec(), std::move(range),
+        detail::par_identity{}, 1, buffer ? buffer : 64, true
+    );
+}
+
+/** @brief Like ostd::stage(), but on a thread pool.
+ *
+ * See ostd::par_map() for the requirements on the pool.
+ */
+template<typename InputRange>
+inline auto stage(
+    thread_pool &pool, InputRange range, std::size_t buffer = 0
+) -> decltype(detail::par_start(
+    detail::par_pool_exec{&pool}, std::declval<
+        detail::ParRange<InputRange>
+    >(), detail::par_identity{}, 1, buffer, true
+)) {
+    return detail::par_start(
+        detail::par_pool_exec{&pool}, std::move(range),
+        detail::par_identity{}, 1, buffer ? buffer : 64, true
+    );
+}
+
+/** @brief A pipeable version of ostd::stage(). */
+inline auto stage(std::size_t buffer = 0) {
+    return [buffer](auto &obj) {
+        return stage(obj, buffer);
+    };
+}
+
+/** @brief A pipeable version of ostd::stage() with a thread pool. */
+inline auto stage(thread_pool &pool, std::size_t buffer = 0) {
+    return [&pool, buffer](auto &obj) {
+        return stage(pool, obj, buffer);
+    };
+}
+
+#ifdef OSTD_BUILD_TESTS
+OSTD_UNIT_TEST {
+    using ostd::test::fail_if;
+    thread_pool tp;
+    tp.start(4);
+
+    /* ordered results, with a buffer smaller than the input */
+    std::vector<int> v;
+    auto sq = [](int i) { return i * i; };
+    for (auto i: range(1000) | par_map(tp, sq, 3, 4)) {
+        v.push_back(i);
+    }
+    fail_if(v.size() != 1000);
+    for (int i = 0; i < 1000; ++i) {
+        fail_if(v[i] != i * i);
+    }
+
+    /* unordered results, behind a stage */
+    v.clear();
+    auto ur = range(500)
+        | stage(tp, 8)
+        | par_map_unordered(tp, [](int i) { return i + 1; }, 2);
+    for (auto i: ur) {
+        v.push_back(i);
+    }
+    std::sort(v.begin(), v.end());
+    fail_if(v.size() != 500 || v.front() != 1 || v.back() != 500);
+
+    /* errors are passed on to the consumer */
+    bool thrown = false;
+    try {
+        auto er = range(100) | par_map(tp, [](int i) {
+            if (i == 50) {
+                throw std::runtime_error{"bad item"};
+            }
+            return i;
+        }, 2);
+        for (auto i: er) {
+            (void)i;
+        }
+    } catch (std::runtime_error const &) {
+        thrown = true;
+    }
+    fail_if(!thrown);
+
+    /* giving up early stops the workers */
+    auto lr = range(1 << 30) | par_map(tp, [](int i) { return i; }, 4, 16);
+    fail_if(lr.front() != 0);
+    lr.pop_front();
+    fail_if(lr.front() != 1);
+
+    /* stages chained on the same pool, all with the default workers */
+    auto dbl = [](int i) { return i * 2; };
+    long long total = 0;
+    for (auto i: range(100000) | par_map(tp, dbl) | stage(tp)) {
+        total += i;
+    }
+    fail_if(total != 9999900000LL);
+    int expect = 0;
+    auto inc = [](int i) { return i + 1; };
+    for (auto i: range(100000) | par_map(tp, dbl) | par_map(tp, inc)) {
+        fail_if(i != (expect++ * 2 + 1));
+    }
+    fail_if(expect != 100000);
+
+    /* chains longer than the pool can run are refused */
+    thread_pool tp1;
+    tp1.start(1);
+    thrown = false;
+    try {
+        auto cr = range(10) | stage(tp1) | stage(tp1);
+    } catch (std::logic_error const &) {
+        thrown = true;
+    }
+    fail_if(!thrown);
+
+    /* the same on the current scheduler, with chained stages */
+    auto sched_test = [](auto &sched) {
+        return sched.start([]() {
+            long sum = 0;
+            auto cr = range(2000)
+                | stage(16)
+                | par_map_unordered([](int i) { return long(i); }, 3);
+            for (auto i: cr) {
+                sum += i;
+            }
+            int next = 0;
+            bool ordered = true;
+            auto dr = range(100)
+                | par_map([](int i) { return i * 2; }, 2, 4)
+                | par_map([](int i) { return i + 1; }, 2);
+            for (auto i: dr) {
+                ordered = ordered && (i == (next++ * 2 + 1));
+            }
+            auto ar = range(1 << 30) | par_map([](int i) { return i; }, 4, 16);
+            bool abandoned = (ar.front() == 0);
+            auto as = range(1 << 30) | stage() | par_map_unordered(
+                [](int i) { return i; }, 2
+            );
+            abandoned = abandoned && (as.front() >= 0);
+            return (sum == 1999000) && ordered && (next == 100) && abandoned;
+        });
+    };
+    simple_coroutine_scheduler ss;
+    fail_if(!sched_test(ss));
+    thread_scheduler ts;
+    fail_if(!sched_test(ts));
+    coroutine_scheduler cs;
+    fail_if(!sched_test(cs));
+}
+#endif
+
+/** @} */
+
+} /* namespace ostd */
+
+#undef OSTD_TEST_MODULE
+
+#endif
+
+/** @} */
@@ -56,6 +56,7 @@
 #include <ostd/unit_test.hh>
 
 #include <cstddef>
+#include <cstring>
 #include <new>
 #include <tuple>
 #include <utility>
@@ -64,6 +65,9 @@
 #include <initializer_list>
 #include <algorithm>
 #include <optional>
+#include <memory>
+#include <string>
+#include <vector>
 
 #define OSTD_TEST_MODULE libostd_range
 
@@ -633,6 +637,122 @@ template<typename T>
 static inline constexpr bool const is_output_range =
     detail::is_output_range_base<T>;
 
+namespace detail {
+    template<typename R, typename T>
+    inline auto test_put_n(int) -> decltype(
+        std::declval<R &>().put_n(std::declval<T const *>(), std::size_t(0)),
+        std::true_type{}
+    );
+
+    template<typename, typename>
+    inline std::false_type test_put_n(...);
+}
+
+/** @brief Checks if an output range can put many values at once.
+ *
+ * Output ranges can optionally provide a method to put `n` values stored
+ * contiguously in memory with a single call:
+ *
+ * ~~~{.cc}
+ * void put_n(T const *p, std::size_t n);
+ * ~~~
+ *
+ * This is then used by ostd::range_put_all() for contiguous input ranges,
+ * and therefore by everything built on top of it, such as formatting,
+ * so that ranges which store into memory can do a single copy instead of
+ * a call for every value. This check never fails, so it will return
+ * `false` for types without that method.
+ *
+ * @tparam R The output range type.
+ * @tparam T The value type, by default the range's value type.
+ */
+template<typename R, typename T = range_value_t<R>>
+static inline constexpr bool const output_range_has_put_n =
+    decltype(detail::test_put_n<R, T>(0))::value;
+
+namespace detail {
+    template<typename V>
+    static inline constexpr bool const is_std_char =
+        std::is_same_v<V, char> || std::is_same_v<V, wchar_t> ||
+        std::is_same_v<V, char16_t> || std::is_same_v<V, char32_t>;
+
+    template<typename It, typename V, bool = is_std_char<V>>
+    static inline constexpr bool const is_string_iterator = false;
+
+    template<typename It, typename V>
+    static inline constexpr bool const is_string_iterator<It, V, true> =
+        std::is_same_v<It, typename std::basic_string<V>::iterator> ||
+        std::is_same_v<It, typename std::basic_string<V>::const_iterator>;
+
+    /* vector<bool> iterators are proxies, not contiguous */
+    template<typename It, typename V, bool = (
+        std::is_object_v<V> && !std::is_same_v<V, bool>
+    )>
+    static inline constexpr bool const is_vector_iterator = false;
+
+    template<typename It, typename V>
+    static inline constexpr bool const is_vector_iterator<It, V, true> =
+        std::is_same_v<It, typename std::vector<V>::iterator> ||
+        std::is_same_v<It, typename std::vector<V>::const_iterator>;
+
+    template<typename It, typename = void>
+    static inline constexpr bool const is_contiguous_iterator_base =
+        std::is_pointer_v<It>;
+
+    template<typename It>
+    static inline constexpr bool const is_contiguous_iterator_base<
+        It, std::void_t<typename std::iterator_traits<It>::value_type>
+    > = std::is_pointer_v<It> || is_vector_iterator<
+        It, typename std::iterator_traits<It>::value_type
+    > || is_string_iterator<
+        It, typename std::iterator_traits<It>::value_type
+    >;
+}
+
+/** @brief Checks if the given iterator type is known to be contiguous.
+ *
+ * The standard has no way to tell contiguous iterators apart from other
+ * random access iterators before C++20, so this recognizes pointers and
+ * the iterators of std::vector (except `std::vector<bool>`) and of
+ * std::basic_string over the standard character types, which covers the
+ * common cases. This check never fails, so it will return `false` for
+ * all other types.
+ *
+ * @see ostd::is_contiguous_range
+ */
+template<typename It>
+static inline constexpr bool const is_contiguous_iterator =
+    detail::is_contiguous_iterator_base<It>;
+
+template<typename T>
+struct iterator_range;
+
+namespace detail {
+    template<typename R>
+    static inline constexpr bool const is_contiguous_iterator_range = false;
+
+    template<typename It>
+    static inline constexpr bool const is_contiguous_iterator_range<
+        iterator_range<It>
+    > = is_contiguous_iterator<It>;
+
+    /* copies into contiguous memory, returning how many values fit */
+    template<typename T>
+    inline std::size_t put_n_copy(
+        T *dst, std::size_t room, T const *src, std::size_t n
+    ) {
+        n = std::min(n, room);
+        if constexpr(std::is_trivially_copyable_v<T>) {
+            if (n) {
+                std::memmove(dst, src, n * sizeof(T));
+            }
+        } else {
+            std::copy(src, src + n, dst);
+        }
+        return n;
+    }
+}
+
 namespace detail {
     // range iterator
     template<typename T>
@@ -1041,11 +1161,33 @@ struct output_range {
  * calling `orange.put(range.front())` on each, but it can be overloaded
  * with more efficient implementations per type. Usages of this in generic
  * algortihms follow ADL, so the right function will always be resolved.
+ *
+ * When `range` is contiguous and `orange` has a `put_n` method for its
+ * values (see ostd::output_range_has_put_n), the whole range is put with
+ * a single call to that instead. Besides contiguous ranges, this applies
+ * to ostd::iterator_range over iterators that are known to be contiguous
+ * (see ostd::is_contiguous_iterator), such as the ranges that ostd::iter()
+ * returns for std::vector and std::string.
  */
 template<typename OR, typename IR>
 inline void range_put_all(OR &orange, IR range) {
-    for (; !range.empty(); range.pop_front()) {
-        orange.put(range.front());
+    constexpr bool has_put_n = output_range_has_put_n<
+        OR, std::remove_const_t<range_value_t<IR>>
+    >;
+    if constexpr(has_put_n && is_contiguous_range<IR>) {
+        if (!range.empty()) {
+            orange.put_n(range.data(), range.size());
+        }
+    } else if constexpr(
+        has_put_n && detail::is_contiguous_iterator_range<IR>
+    ) {
+        if (!range.empty()) {
+            orange.put_n(std::addressof(range.front()), range.size());
+        }
+    } else {
+        for (; !range.empty(); range.pop_front()) {
+            orange.put(range.front());
+        }
     }
 }
 
@@ -1056,6 +1198,9 @@ namespace detail {
 
         /** @brief Has no effect. */
         void put(T const &) {}
+
+        /** @brief Has no effect. */
+        void put_n(T const *, std::size_t) {}
     };
 }
 
@@ -1094,6 +1239,17 @@ namespace detail {
             ++p_written;
         }
 
+        void put_n(value_type const *p, size_t n) {
+            if constexpr(output_range_has_put_n<R, value_type>) {
+                p_range.put_n(p, n);
+            } else {
+                for (size_t i = 0; i < n; ++i) {
+                    p_range.put(p[i]);
+                }
+            }
+            p_written += n;
+        }
+
         size_t get_written() const {
             return p_written;
         }
@@ -1707,6 +1863,15 @@ namespace detail {
             p_data.push_back(std::move(v));
         }
 
+        template<typename U = T>
+        auto put_n(
+            typename U::value_type const *p, typename U::size_type n
+        ) -> decltype(std::declval<U &>().insert(
+            std::declval<U &>().end(), p, p + n
+        ), void()) {
+            p_data.insert(p_data.end(), p, p + n);
+        }
+
         T &get() & { return p_data; }
         T const &get() const & { return p_data; }
 
@@ -1741,6 +1906,8 @@ namespace detail {
  * returned value.
  *
  * The `put(v)` method is overloaded for both by-copy and by-move put.
+ * When the container can insert a range of values at its end, there is
+ * also `put_n(p, n)` to append `n` values at once.
  *
  * @see ostd::appender(Container &&)
  */
@@ -1924,7 +2091,7 @@ struct iterator_range: input_range<iterator_range<T>> {
      *
      * Only valid/useful if the range is contiguous.
      */
-    value_type *data() { return &front(); }
+    std::remove_reference_t<reference> *data() { return &front(); }
 
     /** @brief Gets the pointer to the first element.
      *
@@ -1961,6 +2128,29 @@ struct iterator_range: input_range<iterator_range<T>> {
         *(p_beg++) = std::move(v);
     }
 
+    /** @brief Assigns `n` values from `p` to the front and pops them out.
+     *
+     * Only available if the iterator is mutable and contiguous (see
+     * ostd::is_contiguous_iterator). Trivially copyable values are copied
+     * with a single `memmove`. If fewer than `n` values fit, the ones that
+     * do are written and std::out_of_range is thrown.
+     */
+    template<typename U = T>
+    auto put_n(value_type const *p, size_type n) -> std::enable_if_t<
+        is_contiguous_iterator<U> &&
+        !std::is_const_v<std::remove_reference_t<reference>>
+    > {
+        size_type room = size();
+        size_type m = room ? size_type(detail::put_n_copy(
+            std::addressof(*p_beg), room, p, n
+        )) : 0;
+        using DT = typename std::iterator_traits<T>::difference_type;
+        p_beg += DT(m);
+        if (m < n) {
+            throw std::out_of_range{"put into an empty range"};
+        }
+    }
+
 private:
     T p_beg, p_end;
 };
@@ -0,0 +1,554 @@
+/** @addtogroup Strings
+ * @{
+ */
+
+/** @file scan.hh
+ *
+ * @brief Parsing of numbers and formatted input.
+ *
+ * This is the input counterpart of ostd::format(). Numbers are parsed
+ * straight from string ranges, without making null terminated copies
+ * and without regard to the current locale, using `std::from_chars`.
+ * Nothing here allocates memory unless a `std::string` is scanned into.
+ *
+ * ~~~{.cc}
+ * auto port = ostd::parse<unsigned short>("8080");
+ *
+ * ostd::string_range key;
+ * double value;
+ * ostd::scan("gamma = 2.2", "%s = %f", key, value);
+ * ~~~
+ *
+ * @copyright See COPYING.md in the project tree for further information.
+ */
+
+#ifndef OSTD_SCAN_HH
+#define OSTD_SCAN_HH
+
+#include <ostd/unit_test.hh>
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <limits>
+#include <string>
+#include <charconv>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <ostd/platform.hh>
+#include <ostd/string.hh>
+#include <ostd/format.hh>
+
+#define OSTD_TEST_MODULE libostd_scan
+
+namespace ostd {
+
+/** @addtogroup Strings
+ * @{
+ */
+
+/** @brief The kinds of errors when parsing or scanning. */
+enum class scan_errc {
+    OK = 0,       ///< No error.
+    INVALID,      ///< The input does not start with a valid value.
+    OUT_OF_RANGE, ///< The value does not fit into the type.
+    MISMATCH,     ///< The input does not match a literal of the format.
+    END,          ///< The input ended before the format.
+    TRAILING      ///< There are characters left after the value.
+};
+
+/** @brief Thrown when the input cannot be parsed or scanned.
+ *
+ * Besides the message, this carries the kind of the error and the offset
+ * in the input where it happened, which is the start of the offending
+ * value, or the first unparsed character for ostd::scan_errc::TRAILING.
+ */
+struct OSTD_EXPORT scan_error: std::runtime_error {
+    /** @brief Creates the error with a message for the kind. */
+    scan_error(scan_errc ec, std::size_t pos):
+        std::runtime_error{message(ec)}, p_ec{ec}, p_pos{pos}
+    {}
+
+    /* empty, for vtable placement */
+    virtual ~scan_error();
+
+    /** @brief Gets the kind of the error. */
+    scan_errc code() const noexcept {
+        return p_ec;
+    }
+
+    /** @brief Gets the offset in the input where the error happened. */
+    std::size_t position() const noexcept {
+        return p_pos;
+    }
+
+    /** @brief Gets the message used for a kind of error. */
+    static char const *message(scan_errc ec) noexcept {
+        switch (ec) {
+            case scan_errc::OK: return "no error";
+            case scan_errc::INVALID: return "invalid value";
+            case scan_errc::OUT_OF_RANGE: return "value out of range";
+            case scan_errc::MISMATCH: return "input does not match format";
+            case scan_errc::END: return "unexpected end of input";
+            case scan_errc::TRAILING: return "trailing characters";
+        }
+        return "unknown error";
+    }
+
+private:
+    scan_errc p_ec;
+    std::size_t p_pos;
+};
+
+namespace detail {
+    inline bool scan_isspace(char c) noexcept {
+        return (c == ' ') || ((c >= '\t') && (c <= '\r'));
+    }
+
+    inline scan_errc scan_ec(std::errc ec) noexcept {
+        if (ec == std::errc{}) {
+            return scan_errc::OK;
+        }
+        if (ec == std::errc::result_out_of_range) {
+            return scan_errc::OUT_OF_RANGE;
+        }
+        return scan_errc::INVALID;
+    }
+
+    /* skips an optional sign and returns true for a minus */
+    inline bool scan_sign(char const *&p, char const *e) noexcept {
+        if ((p != e) && ((*p == '-') || (*p == '+'))) {
+            return *p++ == '-';
+        }
+        return false;
+    }
+
+    /* skips an optional 0x or 0b prefix when it's followed by something */
+    inline bool scan_prefix(char const *&p, char const *e, char c) noexcept {
+        if (((e - p) > 2) && (p[0] == '0') && ((p[1] | 32) == c)) {
+            p += 2;
+            return true;
+        }
+        return false;
+    }
+
+    template<typename T>
+    inline scan_errc scan_int(
+        char const *&p, char const *e, T &val, int base
+    ) noexcept {
+        using UT = std::make_unsigned_t<T>;
+        char const *s = p;
+        bool neg = scan_sign(s, e);
+        if ((s != e) && ((*s == '-') || (*s == '+'))) {
+            return scan_errc::INVALID;
+        }
+        if (base == 16) {
+            scan_prefix(s, e, 'x');
+        } else if (base == 2) {
+            scan_prefix(s, e, 'b');
+        }
+        UT uval;
+        auto r = std::from_chars(s, e, uval, base);
+        if (r.ec != std::errc{}) {
+            return scan_ec(r.ec);
+        }
+        if constexpr(std::is_signed_v<T>) {
+            UT lim = UT(std::numeric_limits<T>::max()) + neg;
+            if (uval > lim) {
+                return scan_errc::OUT_OF_RANGE;
+            }
+            val = neg ? T(UT(0) - uval) : T(uval);
+        } else {
+            if (neg && uval) {
+                return scan_errc::OUT_OF_RANGE;
+            }
+            val = uval;
+        }
+        p = r.ptr;
+        return scan_errc::OK;
+    }
+
+    template<typename T>
+    inline scan_errc scan_float(
+        char const *&p, char const *e, T &val, bool hex
+    ) noexcept {
+        char const *s = p;
+        bool neg = scan_sign(s, e);
+        if ((s != e) && ((*s == '-') || (*s == '+'))) {
+            return scan_errc::INVALID;
+        }
+        /* like strtod, a prefix selects hex floats */
+        hex = scan_prefix(s, e, 'x') || hex;
+#ifdef __cpp_lib_to_chars
+        auto r = std::from_chars(s, e, val, (
+            hex ? std::chars_format::hex : std::chars_format::general
+        ));
+        if (r.ec != std::errc{}) {
+            return scan_ec(r.ec);
+        }
+        char const *end = r.ptr;
+#else
+        /* strtod needs a terminated string and a C numeric locale */
+        char buf[128];
+        std::size_t n = std::size_t(e - s);
+        if (n >= (sizeof(buf) - 2)) {
+            n = sizeof(buf) - 3;
+        }
+        std::size_t off = 0;
+        if (hex) {
+            buf[0] = '0';
+            buf[1] = 'x';
+            off = 2;
+        }
+        std::memcpy(&buf[off], s, n);
+        buf[off + n] = '\0';
+        char *bend;
+        errno = 0;
+        if constexpr(std::is_same_v<T, float>) {
+            val = std::strtof(buf, &bend);
+        } else if constexpr(std::is_same_v<T, double>) {
+            val = std::strtod(buf, &bend);
+        } else {
+            val = std::strtold(buf, &bend);
+        }
+        if (bend == buf) {
+            return scan_errc::INVALID;
+        }
+        if (errno == ERANGE) {
+            return scan_errc::OUT_OF_RANGE;
+        }
+        char const *end = s + (bend - buf - off);
+#endif
+        if (neg) {
+            val = -val;
+        }
+        p = end;
+        return scan_errc::OK;
+    }
+
+    template<typename T>
+    inline scan_errc scan_value(
+        char const *&p, char const *e, T &val, int base, bool hex
+    ) noexcept {
+        if constexpr(std::is_same_v<T, bool>) {
+            if (((e - p) >= 4) && !std::memcmp(p, "true", 4)) {
+                val = true;
+                p += 4;
+            } else if (((e - p) >= 5) && !std::memcmp(p, "false", 5)) {
+                val = false;
+                p += 5;
+            } else if ((p != e) && ((*p == '0') || (*p == '1'))) {
+                val = (*p++ == '1');
+            } else {
+                return scan_errc::INVALID;
+            }
+            return scan_errc::OK;
+        } else if constexpr(std::is_integral_v<T>) {
+            return scan_int(p, e, val, base);
+        } else {
+            return scan_float(p, e, val, hex);
+        }
+    }
+
+    template<typename T>
+    static inline constexpr bool const scan_number =
+        std::is_arithmetic_v<T> && !std::is_same_v<T, char>;
+}
+
+/** @brief Parses a value at the start of a string range.
+ *
+ * Supported types are all integers, floating point types and `bool`.
+ *
+ * Integers are written in `base` (2 to 36) with an optional sign; hex
+ * and binary numbers can also have the `0x` and `0b` prefixes. Values
+ * that do not fit into the type are an error rather than being clamped
+ * or wrapped, and so are negative numbers for unsigned types.
+ *
+ * Floats are parsed like with `strtod` in the C locale, including hex
+ * floats with the `0x` prefix, infinities and NaNs; `base` is ignored.
+ * With a standard library that implements `std::from_chars` for floats,
+ * this is an exact and fast conversion without copying the input.
+ *
+ * Booleans are either `true`, `false`, `1` or `0`.
+ *
+ * Nothing is skipped before the value. On success, `input` is advanced
+ * past the value. On failure, both `input` and `val` are left alone.
+ *
+ * @returns ostd::scan_errc::OK or the error.
+ */
+template<typename T>
+inline scan_errc parse_prefix(
+    string_range &input, T &val, int base = 10
+) noexcept {
+    static_assert(detail::scan_number<T>, "cannot parse the given type");
+    char const *p = input.data();
+    T v;
+    auto ec = detail::scan_value(p, p + input.size(), v, base, false);
+    if (ec == scan_errc::OK) {
+        val = v;
+        input = input.slice(std::size_t(p - input.data()));
+    }
+    return ec;
+}
+
+/** @brief Parses a string range as a value.
+ *
+ * Like ostd::parse_prefix(), but the whole input must be the value.
+ *
+ * @throws ostd::scan_error when the input is not a valid value.
+ */
+template<typename T>
+inline T parse(string_range input, int base = 10) {
+    T ret{};
+    string_range s = input;
+    auto ec = parse_prefix(s, ret, base);
+    if (ec != scan_errc::OK) {
+        throw scan_error{ec, 0};
+    }
+    if (!s.empty()) {
+        throw scan_error{scan_errc::TRAILING, input.size() - s.size()};
+    }
+    return ret;
+}
+
+namespace detail {
+    struct scan_state {
+        scan_state(string_range input, string_range fmt) noexcept:
+            p_beg(input.data()), p_cur(input.data()),
+            p_end(input.data() + input.size()), p_fmt(fmt)
+        {}
+
+        template<typename T>
+        void item(T &val) {
+            char spec;
+            std::size_t width;
+            if (!next_spec(spec, width)) {
+                throw format_error{"too many arguments for the scan format"};
+            }
+            if (spec != 'c') {
+                skip_spaces();
+            }
+            char const *end = p_end;
+            if (width && (std::size_t(p_end - p_cur) > width)) {
+                end = p_cur + width;
+            }
+            if (p_cur == end) {
+                fail(scan_errc::END);
+            }
+            if constexpr(std::is_same_v<T, char>) {
+                if ((spec != 'c') && (spec != 's')) {
+                    throw format_error{"characters need the '%c' spec"};
+                }
+                val = *p_cur++;
+            } else if constexpr(
+                std::is_same_v<T, string_range> || std::is_same_v<T, std::string>
+            ) {
+                char const *p = p_cur;
+                if (spec == 'c') {
+                    p = end;
+                } else if (spec == 's') {
+                    while ((p != end) && !scan_isspace(*p)) {
+                        ++p;
+                    }
+                } else {
+                    throw format_error{"strings need the '%s' or '%c' spec"};
+                }
+                val = T{p_cur, p};
+                p_cur = p;
+            } else if constexpr(scan_number<T>) {
+                int base = 10;
+                bool hex = false;
+                bool isint = true;
+                switch (spec | 32) {
+                    case 'b': base = 2; break;
+                    case 'o': base = 8; break;
+                    case 'd': break;
+                    case 'x': base = 16; break;
+                    case 'a': hex = true; [[fallthrough]];
+                    case 'e':
+                    case 'f':
+                    case 'g': isint = false; break;
+                    case 's': isint = std::is_integral_v<T>; break;
+                    default:
+                        throw format_error{"invalid scan spec"};
+                }
+                if (isint != std::is_integral_v<T>) {
+                    throw format_error{isint
+                        ? "cannot scan floats with the given spec"
+                        : "cannot scan integers with the given spec"
+                    };
+                }
+                auto ec = scan_value(p_cur, end, val, base, hex);
+                if (ec != scan_errc::OK) {
+                    fail(ec);
+                }
+            } else {
+                static_assert(scan_number<T>, "cannot scan the given type");
+            }
+        }
+
+        string_range finish() {
+            char spec;
+            std::size_t width;
+            if (next_spec(spec, width)) {
+                throw format_error{"not enough arguments for the scan format"};
+            }
+            return string_range{p_cur, p_end};
+        }
+
+    private:
+        [[noreturn]] void fail(scan_errc ec) const {
+            throw scan_error{ec, std::size_t(p_cur - p_beg)};
+        }
+
+        void skip_spaces() noexcept {
+            while ((p_cur != p_end) && scan_isspace(*p_cur)) {
+                ++p_cur;
+            }
+        }
+
+        /* matches literal input up to the next spec */
+        bool next_spec(char &spec, std::size_t &width) {
+            while (!p_fmt.empty()) {
+                char c = p_fmt.front();
+                p_fmt.pop_front();
+                if (scan_isspace(c)) {
+                    skip_spaces();
+                    continue;
+                }
+                if ((c == '%') && !p_fmt.empty() && (p_fmt.front() != '%')) {
+                    width = 0;
+                    while (
+                        !p_fmt.empty() &&
+                        (p_fmt.front() >= '0') && (p_fmt.front() <= '9')
+                    ) {
+                        width = width * 10 + std::size_t(p_fmt.front() - '0');
+                        p_fmt.pop_front();
+                    }
+                    if (p_fmt.empty()) {
+                        throw format_error{"unexpected end of scan format"};
+                    }
+                    spec = p_fmt.front();
+                    p_fmt.pop_front();
+                    return true;
+                }
+                if (c == '%') {
+                    p_fmt.pop_front();
+                }
+                if (p_cur == p_end) {
+                    fail(scan_errc::END);
+                }
+                if (*p_cur != c) {
+                    fail(scan_errc::MISMATCH);
+                }
+                ++p_cur;
+            }
+            return false;
+        }
+
+        char const *p_beg, *p_cur, *p_end;
+        string_range p_fmt;
+    };
+}
+
+/** @brief Scans values from a string range according to a format.
+ *
+ * The format is a string similar to the one used by `scanf`. Whitespace
+ * in the format matches any amount of whitespace in the input, including
+ * none. `%%` matches a percent sign and other characters match themselves.
+ * A specifier is `%[width]spec`, where the optional width is the maximum
+ * number of characters to consume for the value.
+ *
+ * The type of each argument decides what is read, and the specifiers are
+ * checked against it like with ostd::format():
+ *
+ * * `d`, `x`, `X`, `o`, `b` - integers in base 10, 16, 8 and 2.
+ * * `a`, `A`, `e`, `E`, `f`, `F`, `g`, `G` - floats; all of them accept
+ *   any float representation, `a` and `A` assume hex digits.
+ * * `c` - a single character for `char`, or exactly `width` characters
+ *   (the rest of the input without a width) for strings.
+ * * `s` - any value: decimal integers, floats, booleans (see
+ *   ostd::parse_prefix()), single characters and for strings, a run of
+ *   non-whitespace characters.
+ *
+ * Leading whitespace is skipped before every value except with `c`.
+ * Strings can be either ostd::string_range, which then points into the
+ * input, or `std::string`, which gets a copy.
+ *
+ * @returns The rest of the input after the last match.
+ *
+ * @throws ostd::scan_error when the input does not match the format.
+ * @throws ostd::format_error when the format does not match the arguments.
+ */
+template<typename ...A>
+inline string_range scan(string_range input, string_range fmt, A &...args) {
+    detail::scan_state st{input, fmt};
+    (st.item(args), ...);
+    return st.finish();
+}
+
+#ifdef OSTD_BUILD_TESTS
+OSTD_UNIT_TEST {
+    using ostd::test::fail_if;
+    fail_if(parse<int>("-2147483648") != INT_MIN);
+    fail_if(parse<unsigned>("0xFF", 16) != 255);
+    fail_if(parse<unsigned char>("+0b101", 2) != 5);
+    fail_if(parse<double>("0.1") != 0.1);
+    fail_if(parse<double>("-0x1.8p1") != -3.0);
+    fail_if(!parse<bool>("true") || parse<bool>("0"));
+
+    auto code = [](auto f) {
+        try {
+            f();
+        } catch (scan_error const &e) {
+            return std::make_pair(e.code(), e.position());
+        }
+        return std::make_pair(scan_errc::OK, std::size_t(0));
+    };
+    auto ret = code([]() { parse<signed char>("128"); });
+    fail_if(ret.first != scan_errc::OUT_OF_RANGE);
+    ret = code([]() { parse<unsigned>("-1"); });
+    fail_if(ret.first != scan_errc::OUT_OF_RANGE);
+    ret = code([]() { parse<int>("12ab"); });
+    fail_if(ret.first != scan_errc::TRAILING || ret.second != 2);
+    ret = code([]() { parse<float>("--1"); });
+    fail_if(ret.first != scan_errc::INVALID);
+
+    string_range s = "42,rest";
+    int i = 0;
+    fail_if(parse_prefix(s, i) != scan_errc::OK || i != 42 || s != ",rest");
+    fail_if(parse_prefix(s, i) != scan_errc::INVALID || s != ",rest");
+
+    string_range key;
+    std::string unit;
+    double val = 0;
+    int hex = 0;
+    char c = 0;
+    auto rest = scan(
+        "  gamma = 2.5e1 cm [%ff] tail", "%s = %f %s [%%%2x%c",
+        key, val, unit, hex, c
+    );
+    fail_if(key != "gamma" || val != 25.0 || unit != "cm");
+    fail_if(hex != 0xff || c != ']' || rest != " tail");
+
+    ret = code([]() { int x; scan("a: 5", "b: %d", x); });
+    fail_if(ret.first != scan_errc::MISMATCH || ret.second != 0);
+    ret = code([]() { int x, y; scan("1 ", "%d %d", x, y); });
+    fail_if(ret.first != scan_errc::END || ret.second != 2);
+}
+#endif
+
+/** @} */
+
+} /* namespace ostd */
+
+#undef OSTD_TEST_MODULE
+
+#endif
+
+/** @} */
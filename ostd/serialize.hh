@@ -0,0 +1,996 @@
+/** @addtogroup Streams
+ * @{
+ */
+
+/** @file serialize.hh
+ *
+ * @brief A portable binary serialization system.
+ *
+ * The ostd::stream::put() and ostd::stream::get() methods write the raw
+ * bytes of an object, which ties the data to the byte order and layout of
+ * the machine that wrote it. This file provides a serializer with a fixed
+ * wire format instead, which can be used for file formats and network
+ * protocols alike.
+ *
+ * The format is simple and has no type tags or schema information; the
+ * reader has to know what to expect, just like with the raw methods:
+ *
+ * - `bool` is one byte, either 0 or 1.
+ * - Other arithmetic types are written as little endian fixed size values,
+ *   floating point values use their IEEE 754 representation.
+ * - Enumerations are written as their underlying type.
+ * - ostd::varint values are written as LEB128 variable length integers,
+ *   signed values are zigzag encoded first, so small negative values are
+ *   short as well.
+ * - Strings, vectors and other sequences are written as a varint element
+ *   count followed by the elements.
+ * - `std::optional` is a `bool` followed by the value if present.
+ * - Tuple-like types (`std::pair`, `std::tuple`, `std::array`) are written
+ *   as their elements with no length prefix.
+ * - Custom types are written as specified by their ostd::serialize_traits.
+ *
+ * Writing goes through ostd::binary_writer, which collects the output in
+ * a fixed buffer and hands it to a stream or an output range in blocks.
+ * Reading goes through ostd::binary_reader, which can read from a stream,
+ * directly from memory or from any input range of bytes.
+ *
+ * ~~~{.cc}
+ * struct point {
+ *     std::string name;
+ *     std::uint32_t id;
+ *     std::vector<float> coords;
+ * };
+ *
+ * template<>
+ * struct ostd::serialize_traits<point> {
+ *     static constexpr auto members = std::make_tuple(
+ *         &point::name, ostd::as_varint(&point::id), &point::coords
+ *     );
+ * };
+ *
+ * auto data = ostd::serialize(ostd::appender<std::string>(), p).get();
+ * auto q = ostd::deserialize<point>(ostd::string_range{data});
+ * ~~~
+ *
+ * @copyright See COPYING.md in the project tree for further information.
+ */
+
+#ifndef OSTD_SERIALIZE_HH
+#define OSTD_SERIALIZE_HH
+
+#include <ostd/unit_test.hh>
+
+#include <cstddef>
+#include <cstdint>
+#include <climits>
+#include <cstring>
+#include <string>
+#include <array>
+#include <vector>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#include <ostd/platform.hh>
+#include <ostd/range.hh>
+#include <ostd/string.hh>
+#include <ostd/stream.hh>
+
+#define OSTD_TEST_MODULE libostd_serialize
+
+namespace ostd {
+
+/** @addtogroup Streams
+ * @{
+ */
+
+/** @brief Thrown when the serialized data cannot be decoded.
+ *
+ * This happens on truncated input, on variable length integers that do not
+ * fit the requested type and on otherwise invalid values. Errors of the
+ * underlying stream are propagated as ostd::stream_error.
+ */
+struct OSTD_EXPORT serialize_error: std::runtime_error {
+    using std::runtime_error::runtime_error;
+    /* empty, for vtable placement */
+    virtual ~serialize_error();
+};
+
+/** @brief A wrapper marking an integer for variable length encoding.
+ *
+ * It implicitly converts from and to the wrapped integer type, so it can
+ * be used both as a temporary when writing (`w.write(ostd::varint{x})`)
+ * and as a member type of serialized structures.
+ *
+ * @tparam T The integer type.
+ */
+template<typename T>
+struct varint {
+    static_assert(
+        std::is_integral_v<T> && !std::is_same_v<T, bool>,
+        "varint needs an integer type"
+    );
+
+    /** @brief The wrapped type. */
+    using value_type = T;
+
+    /** @brief Creates a zero value. */
+    constexpr varint() noexcept: value() {}
+
+    /** @brief Creates a wrapper for the given value. */
+    constexpr varint(T v) noexcept: value(v) {}
+
+    /** @brief Gets the wrapped value. */
+    constexpr operator T() const noexcept { return value; }
+
+    /** @brief The wrapped value. */
+    T value;
+};
+
+/** @brief A member list entry for variable length integer members.
+ *
+ * Created by ostd::as_varint().
+ */
+template<typename C, typename M>
+struct varint_member {
+    /** @brief The member pointer. */
+    M C::*ptr;
+};
+
+/** @brief Marks an integer member for variable length encoding.
+ *
+ * Use this in the `members` list of ostd::serialize_traits for integer
+ * members that are usually small, such as identifiers and counters.
+ */
+template<typename C, typename M>
+inline constexpr varint_member<C, M> as_varint(M C::*ptr) noexcept {
+    static_assert(
+        std::is_integral_v<M> && !std::is_same_v<M, bool>,
+        "as_varint needs an integer member"
+    );
+    return varint_member<C, M>{ptr};
+}
+
+/** @brief Specialize this to serialize custom objects.
+ *
+ * By default it's empty. There are two ways to specialize it. The simple
+ * way is providing a tuple of member pointers, which are serialized in
+ * the given order:
+ *
+ * ~~~{.cc}
+ * template<>
+ * struct serialize_traits<foo> {
+ *     static constexpr auto members = std::make_tuple(
+ *         &foo::name, &foo::size, ostd::as_varint(&foo::count)
+ *     );
+ * };
+ * ~~~
+ *
+ * The members can be of any serializable type. The object has to be
+ * default constructible to be read with ostd::binary_reader::read().
+ *
+ * For full control, provide the functions directly:
+ *
+ * ~~~{.cc}
+ * template<>
+ * struct serialize_traits<foo> {
+ *     template<typename W>
+ *     static void to_binary(foo const &v, W &writer) {
+ *         writer.write(v.name);
+ *     }
+ *     template<typename R>
+ *     static void from_binary(foo &v, R &reader) {
+ *         reader.read(v.name);
+ *     }
+ * };
+ * ~~~
+ *
+ * The `writer` is an ostd::binary_writer and the `reader` is an
+ * ostd::binary_reader. The functions take precedence over `members`, and
+ * either of them can be omitted if the type is only ever written or read.
+ */
+template<typename>
+struct serialize_traits {};
+
+template<typename S>
+struct binary_writer;
+
+template<typename S>
+struct binary_reader;
+
+/* implementation helpers */
+namespace detail {
+    template<typename>
+    static inline constexpr bool ser_false = false;
+
+    template<typename S>
+    static inline constexpr bool ser_is_stream =
+        std::is_base_of_v<stream, S>;
+
+    template<typename T>
+    struct ser_is_char_range: std::false_type {};
+
+    template<typename T>
+    struct ser_is_char_range<basic_char_range<T>>:
+        std::bool_constant<sizeof(T) == 1>
+    {};
+
+    template<typename T>
+    struct ser_is_varint: std::false_type {};
+
+    template<typename T>
+    struct ser_is_varint<varint<T>>: std::true_type {};
+
+    template<typename T>
+    struct ser_is_varint_member: std::false_type {};
+
+    template<typename C, typename M>
+    struct ser_is_varint_member<varint_member<C, M>>: std::true_type {};
+
+    /* sequences with a length prefix we can both read and write */
+    template<typename T>
+    struct ser_is_seq: std::false_type {};
+
+    template<typename T, typename A>
+    struct ser_is_seq<std::vector<T, A>>: std::true_type {};
+
+    template<typename C, typename TR, typename A>
+    struct ser_is_seq<std::basic_string<C, TR, A>>: std::true_type {};
+
+    template<typename T>
+    struct ser_is_optional: std::false_type {};
+
+    template<typename T>
+    struct ser_is_optional<std::optional<T>>: std::true_type {};
+
+    template<typename T>
+    struct ser_is_array: std::false_type {};
+
+    template<typename T, std::size_t N>
+    struct ser_is_array<std::array<T, N>>: std::true_type {};
+
+    template<typename T>
+    inline auto ser_tuple_like_test(int) ->
+        typename std::is_integral<decltype(std::tuple_size<T>::value)>::type;
+
+    template<typename>
+    inline std::false_type ser_tuple_like_test(...);
+
+    template<typename T>
+    static inline constexpr bool ser_is_tuple_like =
+        decltype(ser_tuple_like_test<T>(0))::value;
+
+    /* element types whose in-memory representation is the wire format,
+     * so sequences of them can be copied as a single block
+     */
+    template<typename T>
+    static inline constexpr bool ser_is_block = std::is_arithmetic_v<T> &&
+        !std::is_same_v<T, bool> && (
+            (sizeof(T) == 1) || (OSTD_BYTE_ORDER == OSTD_ENDIAN_LIL)
+        );
+
+    /* test if serialize traits are available for the type */
+    template<typename T, typename W>
+    inline auto test_to_binary(int) -> typename std::is_void<
+        decltype(serialize_traits<T>::to_binary(
+            std::declval<T const &>(), std::declval<W &>()
+        ))
+    >::type;
+
+    template<typename, typename>
+    inline std::false_type test_to_binary(...);
+
+    template<typename T, typename W>
+    static inline constexpr bool ser_to_binary_test =
+        decltype(test_to_binary<T, W>(0))::value;
+
+    template<typename T, typename R>
+    inline auto test_from_binary(int) -> typename std::is_void<
+        decltype(serialize_traits<T>::from_binary(
+            std::declval<T &>(), std::declval<R &>()
+        ))
+    >::type;
+
+    template<typename, typename>
+    inline std::false_type test_from_binary(...);
+
+    template<typename T, typename R>
+    static inline constexpr bool ser_from_binary_test =
+        decltype(test_from_binary<T, R>(0))::value;
+
+    template<typename T>
+    inline auto test_ser_members(int) -> decltype(
+        serialize_traits<T>::members, std::true_type{}
+    );
+
+    template<typename>
+    inline std::false_type test_ser_members(...);
+
+    template<typename T>
+    static inline constexpr bool ser_members_test =
+        decltype(test_ser_members<T>(0))::value;
+
+    /* the largest encoded varint, 64 bits in 7 bit groups */
+    static inline constexpr std::size_t ser_varint_max = 10;
+
+    template<typename T>
+    inline std::size_t ser_encode_varint(T v, unsigned char *buf) noexcept {
+        using U = std::make_unsigned_t<T>;
+        U uv = U(v);
+        if constexpr(std::is_signed_v<T>) {
+            /* zigzag */
+            uv = (v < 0) ? U(~U(uv << 1)) : U(uv << 1);
+        }
+        std::size_t n = 0;
+        while (uv >= 0x80) {
+            buf[n++] = static_cast<unsigned char>(uv | 0x80);
+            uv >>= 7;
+        }
+        buf[n++] = static_cast<unsigned char>(uv);
+        return n;
+    }
+}
+
+/** @brief Serializes values into a stream or an output range.
+ *
+ * The writer collects the encoded data in an internal buffer of
+ * ostd::binary_writer::block_size bytes and passes it on in whole blocks,
+ * so writing many small values does not result in many small writes into
+ * the sink. Writes larger than the buffer bypass it.
+ *
+ * The sink is either an ostd::stream, in which case the data is written
+ * using ostd::stream::write_bytes(), or an output range of bytes. The
+ * writer keeps a reference to the sink and does not own it.
+ *
+ * The buffered data is written on flush() or when the writer is destroyed.
+ * Errors during destruction are ignored, so flush explicitly if you want
+ * to handle them.
+ *
+ * @tparam S The sink type.
+ */
+template<typename S>
+struct binary_writer {
+    /** @brief The sink type. */
+    using sink_type = S;
+
+    /** @brief The size of the internal buffer. */
+    static constexpr std::size_t block_size = 4096;
+
+    /** @brief Creates a writer over a sink. */
+    binary_writer(S &sink) noexcept: p_sink(&sink) {}
+
+    binary_writer(binary_writer const &) = delete;
+    binary_writer &operator=(binary_writer const &) = delete;
+
+    /** @brief Flushes the buffer, ignoring any errors. */
+    ~binary_writer() {
+        try {
+            flush();
+        } catch (...) {}
+    }
+
+    /** @brief Writes a value.
+     *
+     * The encoding depends on the type as described in the file overview.
+     *
+     * @returns The writer.
+     *
+     * @throws Anything the sink throws.
+     */
+    template<typename T>
+    binary_writer &write(T const &v) {
+        if constexpr(detail::ser_to_binary_test<T, binary_writer>) {
+            serialize_traits<T>::to_binary(v, *this);
+        } else if constexpr(detail::ser_members_test<T>) {
+            std::apply([this, &v](auto const &...mems) {
+                (write_member(v, mems), ...);
+            }, serialize_traits<T>::members);
+        } else if constexpr(std::is_same_v<T, bool>) {
+            write_fixed(std::uint8_t(v));
+        } else if constexpr(std::is_arithmetic_v<T>) {
+            write_fixed(v);
+        } else if constexpr(std::is_enum_v<T>) {
+            write_fixed(std::underlying_type_t<T>(v));
+        } else if constexpr(detail::ser_is_varint<T>::value) {
+            write_varint(v.value);
+        } else if constexpr(
+            detail::ser_is_seq<T>::value ||
+            detail::ser_is_char_range<T>::value
+        ) {
+            write_varint(std::size_t(v.size()));
+            write_seq(v);
+        } else if constexpr(detail::ser_is_optional<T>::value) {
+            write(bool(v));
+            if (v) {
+                write(*v);
+            }
+        } else if constexpr(detail::ser_is_array<T>::value) {
+            write_elems(v.data(), v.size());
+        } else if constexpr(detail::ser_is_tuple_like<T>) {
+            std::apply([this](auto const &...elems) {
+                (write(elems), ...);
+            }, v);
+        } else if constexpr(std::is_convertible_v<T const &, string_range>) {
+            write(string_range{v});
+        } else {
+            static_assert(
+                detail::ser_false<T>, "the type is not serializable"
+            );
+        }
+        return *this;
+    }
+
+    /** @brief Writes an arithmetic value as a fixed size little endian.
+     *
+     * @throws Anything the sink throws.
+     */
+    template<typename T>
+    binary_writer &write_fixed(T v) {
+        static_assert(
+            std::is_arithmetic_v<T> && (sizeof(T) <= 8),
+            "write_fixed needs an arithmetic type of at most 64 bits"
+        );
+        if constexpr(sizeof(T) > 1) {
+            v = from_lil_endian<T>{}(v);
+        }
+        return write_bytes(&v, sizeof(T));
+    }
+
+    /** @brief Writes an integer as a variable length integer.
+     *
+     * @throws Anything the sink throws.
+     */
+    template<typename T>
+    binary_writer &write_varint(T v) {
+        static_assert(
+            std::is_integral_v<T> && !std::is_same_v<T, bool>,
+            "write_varint needs an integer type"
+        );
+        if ((block_size - p_len) >= detail::ser_varint_max) {
+            std::size_t n = detail::ser_encode_varint(v, &p_buf[p_len]);
+            p_len += n;
+            p_written += n;
+            return *this;
+        }
+        unsigned char buf[detail::ser_varint_max];
+        return write_bytes(buf, detail::ser_encode_varint(v, buf));
+    }
+
+    /** @brief Writes raw bytes.
+     *
+     * @throws Anything the sink throws.
+     */
+    binary_writer &write_bytes(void const *data, std::size_t n) {
+        auto *p = static_cast<unsigned char const *>(data);
+        p_written += n;
+        if (n <= (block_size - p_len)) {
+            if (n) {
+                std::memcpy(&p_buf[p_len], p, n);
+                p_len += n;
+            }
+            return *this;
+        }
+        flush();
+        if (n >= block_size) {
+            sink_write(p, n);
+        } else {
+            std::memcpy(p_buf, p, n);
+            p_len = n;
+        }
+        return *this;
+    }
+
+    /** @brief Writes the buffered data into the sink.
+     *
+     * This does not flush the sink itself.
+     *
+     * @throws Anything the sink throws.
+     */
+    void flush() {
+        if (p_len) {
+            /* reset first so a throwing sink does not get the data twice */
+            std::size_t n = p_len;
+            p_len = 0;
+            sink_write(p_buf, n);
+        }
+    }
+
+    /** @brief Gets the number of bytes written so far, buffered or not. */
+    std::size_t written() const noexcept {
+        return p_written;
+    }
+
+    /** @brief Gets the sink. */
+    S &sink() const noexcept {
+        return *p_sink;
+    }
+
+private:
+    template<typename T, typename M>
+    void write_member(T const &v, M const &mem) {
+        if constexpr(detail::ser_is_varint_member<M>::value) {
+            write_varint(v.*(mem.ptr));
+        } else {
+            write(v.*mem);
+        }
+    }
+
+    template<typename T>
+    void write_elems(T const *elems, std::size_t n) {
+        if constexpr(detail::ser_is_block<T>) {
+            write_bytes(elems, n * sizeof(T));
+        } else {
+            for (std::size_t i = 0; i < n; ++i) {
+                write(elems[i]);
+            }
+        }
+    }
+
+    template<typename T>
+    void write_seq(T const &v) {
+        using E = std::remove_cv_t<typename T::value_type>;
+        if constexpr(detail::ser_is_block<E>) {
+            write_bytes(v.data(), v.size() * sizeof(E));
+        } else {
+            /* no data() for std::vector<bool>, convert the proxies */
+            for (auto it = v.begin(); it != v.end(); ++it) {
+                write(static_cast<E const &>(*it));
+            }
+        }
+    }
+
+    void sink_write(unsigned char const *p, std::size_t n) {
+        if constexpr(detail::ser_is_stream<S>) {
+            p_sink->write_bytes(p, n);
+        } else {
+            auto *cp = reinterpret_cast<char const *>(p);
+            range_put_all(*p_sink, string_range{cp, cp + n});
+        }
+    }
+
+    S *p_sink;
+    std::size_t p_len = 0;
+    std::size_t p_written = 0;
+    unsigned char p_buf[block_size];
+};
+
+/** @brief Deserializes values from a stream, memory or an input range.
+ *
+ * The source can be one of the following:
+ *
+ * - An ostd::stream. The writer reads it in blocks of
+ *   ostd::binary_reader::block_size bytes, so it generally consumes more
+ *   of the stream than it decodes. Use sync() to give the unused data
+ *   back to a seekable stream.
+ * - A byte sized ostd::basic_char_range such as ostd::string_range. The
+ *   data is read directly from memory and the range is advanced as the
+ *   data is consumed, so it always holds the part not read yet.
+ * - Any other input range of bytes. It's read one byte at a time and
+ *   advanced as the data is consumed.
+ *
+ * The reader keeps a reference to the source and does not own it.
+ *
+ * @tparam S The source type.
+ */
+template<typename S>
+struct binary_reader {
+    /** @brief The source type. */
+    using source_type = S;
+
+    /** @brief The size of the internal buffer used for streams. */
+    static constexpr std::size_t block_size = 4096;
+
+    /** @brief Creates a reader over a source. */
+    binary_reader(S &src) noexcept: p_src(&src) {}
+
+    binary_reader(binary_reader const &) = delete;
+    binary_reader &operator=(binary_reader const &) = delete;
+
+    /** @brief Reads a value.
+     *
+     * The value is expected in the encoding of ostd::binary_writer::write()
+     * for the same type. Sequences and optionals are replaced rather than
+     * appended to.
+     *
+     * @returns The reader.
+     *
+     * @throws ostd::serialize_error on invalid or truncated data.
+     * @throws ostd::stream_error on stream read errors.
+     */
+    template<typename T>
+    binary_reader &read(T &v) {
+        if constexpr(detail::ser_from_binary_test<T, binary_reader>) {
+            serialize_traits<T>::from_binary(v, *this);
+        } else if constexpr(detail::ser_members_test<T>) {
+            std::apply([this, &v](auto const &...mems) {
+                (read_member(v, mems), ...);
+            }, serialize_traits<T>::members);
+        } else if constexpr(std::is_same_v<T, bool>) {
+            auto b = read_fixed<std::uint8_t>();
+            if (b > 1) {
+                throw serialize_error{"invalid boolean value"};
+            }
+            v = (b != 0);
+        } else if constexpr(std::is_arithmetic_v<T>) {
+            v = read_fixed<T>();
+        } else if constexpr(std::is_enum_v<T>) {
+            v = T(read_fixed<std::underlying_type_t<T>>());
+        } else if constexpr(detail::ser_is_varint<T>::value) {
+            v.value = read_varint<typename T::value_type>();
+        } else if constexpr(detail::ser_is_seq<T>::value) {
+            read_seq(v, read_varint<std::size_t>());
+        } else if constexpr(detail::ser_is_optional<T>::value) {
+            if (read<bool>()) {
+                read(v.emplace());
+            } else {
+                v.reset();
+            }
+        } else if constexpr(detail::ser_is_array<T>::value) {
+            read_elems(v.data(), v.size());
+        } else if constexpr(detail::ser_is_tuple_like<T>) {
+            std::apply([this](auto &...elems) {
+                (read(elems), ...);
+            }, v);
+        } else {
+            static_assert(
+                detail::ser_false<T>, "the type is not deserializable"
+            );
+        }
+        return *this;
+    }
+
+    /** @brief Reads a value.
+     *
+     * The type has to be default constructible.
+     *
+     * @throws ostd::serialize_error on invalid or truncated data.
+     * @throws ostd::stream_error on stream read errors.
+     */
+    template<typename T>
+    T read() {
+        T v{};
+        read(v);
+        return v;
+    }
+
+    /** @brief Reads a fixed size little endian arithmetic value.
+     *
+     * @throws ostd::serialize_error on truncated data.
+     * @throws ostd::stream_error on stream read errors.
+     */
+    template<typename T>
+    T read_fixed() {
+        static_assert(
+            std::is_arithmetic_v<T> && (sizeof(T) <= 8),
+            "read_fixed needs an arithmetic type of at most 64 bits"
+        );
+        T v;
+        read_bytes(&v, sizeof(T));
+        if constexpr(sizeof(T) > 1) {
+            v = from_lil_endian<T>{}(v);
+        }
+        return v;
+    }
+
+    /** @brief Reads a variable length integer.
+     *
+     * @throws ostd::serialize_error on truncated data or when the value
+     *         does not fit in the type.
+     * @throws ostd::stream_error on stream read errors.
+     */
+    template<typename T>
+    T read_varint() {
+        static_assert(
+            std::is_integral_v<T> && !std::is_same_v<T, bool>,
+            "read_varint needs an integer type"
+        );
+        using U = std::make_unsigned_t<T>;
+        constexpr unsigned bits = sizeof(U) * CHAR_BIT;
+        U uv = 0;
+        for (unsigned shift = 0;; shift += 7) {
+            unsigned char b = read_byte();
+            U part = U(b & 0x7F);
+            if (
+                (shift >= bits) ||
+                (((bits - shift) < 7) && (part >> (bits - shift)))
+            ) {
+                throw serialize_error{"varint out of range"};
+            }
+            uv |= U(part << shift);
+            if (!(b & 0x80)) {
+                break;
+            }
+        }
+        if constexpr(std::is_signed_v<T>) {
+            /* zigzag */
+            return T(U(uv >> 1) ^ U(U(0) - U(uv & 1)));
+        } else {
+            return uv;
+        }
+    }
+
+    /** @brief Reads raw bytes.
+     *
+     * @throws ostd::serialize_error if fewer than `n` bytes are left.
+     * @throws ostd::stream_error on stream read errors.
+     */
+    binary_reader &read_bytes(void *buf, std::size_t n) {
+        auto *p = static_cast<unsigned char *>(buf);
+        if constexpr(detail::ser_is_stream<S>) {
+            while (n) {
+                if (p_cur == p_end) {
+                    if (n >= block_size) {
+                        /* large reads bypass the buffer */
+                        while (n) {
+                            std::size_t r = p_src->read_bytes(p, n);
+                            if (!r) {
+                                throw_eof();
+                            }
+                            p += r;
+                            n -= r;
+                        }
+                        break;
+                    }
+                    if (!fill()) {
+                        throw_eof();
+                    }
+                }
+                std::size_t c = std::min(n, std::size_t(p_end - p_cur));
+                std::memcpy(p, p_cur, c);
+                p_cur += c;
+                p += c;
+                n -= c;
+            }
+        } else if constexpr(detail::ser_is_char_range<S>::value) {
+            if (n > p_src->size()) {
+                throw_eof();
+            }
+            if (n) {
+                std::memcpy(p, p_src->data(), n);
+                *p_src = p_src->slice(n);
+            }
+        } else {
+            for (; n; --n) {
+                *p++ = read_byte();
+            }
+        }
+        return *this;
+    }
+
+    /** @brief Checks if there is no more data to read.
+     *
+     * For streams, this may need to read from the stream.
+     *
+     * @throws ostd::stream_error on stream read errors.
+     */
+    bool empty() {
+        if constexpr(detail::ser_is_stream<S>) {
+            return (p_cur == p_end) && !fill();
+        } else {
+            return p_src->empty();
+        }
+    }
+
+    /** @brief Gives the buffered data back to the stream.
+     *
+     * Seeks the stream back by the number of buffered bytes that were not
+     * consumed yet, so that the stream's position is right after the last
+     * decoded value. Has no effect for sources other than streams.
+     *
+     * @throws ostd::stream_error if the stream is not seekable.
+     */
+    void sync() {
+        if constexpr(detail::ser_is_stream<S>) {
+            if (p_cur != p_end) {
+                p_src->seek(-stream_off_t(p_end - p_cur), stream_seek::CUR);
+            }
+            p_cur = p_end = p_buf;
+        }
+    }
+
+    /** @brief Gets the source. */
+    S &source() const noexcept {
+        return *p_src;
+    }
+
+private:
+    [[noreturn]] static void throw_eof() {
+        throw serialize_error{"unexpected end of data"};
+    }
+
+    bool fill() {
+        std::size_t r = p_src->read_bytes(p_buf, block_size);
+        p_cur = p_buf;
+        p_end = p_buf + r;
+        return r != 0;
+    }
+
+    unsigned char read_byte() {
+        if constexpr(detail::ser_is_stream<S>) {
+            if ((p_cur == p_end) && !fill()) {
+                throw_eof();
+            }
+            return *p_cur++;
+        } else {
+            if (p_src->empty()) {
+                throw_eof();
+            }
+            auto c = static_cast<unsigned char>(p_src->front());
+            p_src->pop_front();
+            return c;
+        }
+    }
+
+    template<typename T, typename M>
+    void read_member(T &v, M const &mem) {
+        if constexpr(detail::ser_is_varint_member<M>::value) {
+            using MT = std::remove_reference_t<decltype(v.*(mem.ptr))>;
+            v.*(mem.ptr) = read_varint<MT>();
+        } else {
+            read(v.*mem);
+        }
+    }
+
+    template<typename T>
+    void read_elems(T *elems, std::size_t n) {
+        if constexpr(detail::ser_is_block<T>) {
+            read_bytes(elems, n * sizeof(T));
+        } else {
+            for (std::size_t i = 0; i < n; ++i) {
+                read(elems[i]);
+            }
+        }
+    }
+
+    template<typename T>
+    void read_seq(T &v, std::size_t n) {
+        using E = typename T::value_type;
+        v.clear();
+        if constexpr(detail::ser_is_block<E>) {
+            /* grow in chunks, so that a corrupt length does not make us
+             * allocate a huge buffer before we find out it's truncated
+             */
+            constexpr std::size_t chunk = std::max(
+                std::size_t(1), std::size_t(65536 / sizeof(E))
+            );
+            while (n) {
+                std::size_t c = std::min(n, chunk);
+                std::size_t old = v.size();
+                v.resize(old + c);
+                read_bytes(&v[old], c * sizeof(E));
+                n -= c;
+            }
+        } else {
+            v.reserve(std::min(n, std::size_t(1024)));
+            for (; n; --n) {
+                v.push_back(read<E>());
+            }
+        }
+    }
+
+    S *p_src;
+    unsigned char *p_cur = p_buf;
+    unsigned char *p_end = p_buf;
+    unsigned char p_buf[detail::ser_is_stream<S> ? block_size : 1];
+};
+
+/** @brief Serializes values into a sink.
+ *
+ * Creates an ostd::binary_writer over `sink`, writes all the values in
+ * order and flushes it.
+ *
+ * @returns The sink, forwarded; this allows things like
+ *          `ostd::serialize(ostd::appender<std::string>(), x).get()`.
+ *
+ * @throws Anything the sink throws.
+ */
+template<typename S, typename ...A>
+inline S &&serialize(S &&sink, A const &...args) {
+    binary_writer<std::remove_reference_t<S>> w{sink};
+    (w.write(args), ...);
+    w.flush();
+    return std::forward<S>(sink);
+}
+
+/** @brief Deserializes a single value from a source.
+ *
+ * Creates an ostd::binary_reader over `src` and reads a value of type `T`.
+ * Ranges are copied first, so the given range is never advanced. Streams
+ * are read in blocks, so more data than needed may be consumed from them;
+ * use ostd::binary_reader directly to read several values from a stream.
+ *
+ * @throws ostd::serialize_error on invalid or truncated data.
+ * @throws ostd::stream_error on stream read errors.
+ */
+template<typename T, typename S>
+inline T deserialize(S &&src) {
+    using ST = std::remove_cv_t<std::remove_reference_t<S>>;
+    if constexpr(detail::ser_is_stream<ST>) {
+        binary_reader<ST> r{src};
+        return r.template read<T>();
+    } else {
+        ST range = src;
+        binary_reader<ST> r{range};
+        return r.template read<T>();
+    }
+}
+
+#ifdef OSTD_BUILD_TESTS
+namespace detail {
+    struct ser_test_rec {
+        std::string name;
+        std::uint32_t id = 0;
+        std::vector<std::int16_t> vals;
+        std::optional<std::pair<bool, double>> extra;
+    };
+}
+
+template<>
+struct serialize_traits<detail::ser_test_rec> {
+    static constexpr auto members = std::make_tuple(
+        &detail::ser_test_rec::name,
+        as_varint(&detail::ser_test_rec::id),
+        &detail::ser_test_rec::vals,
+        &detail::ser_test_rec::extra
+    );
+};
+
+OSTD_UNIT_TEST {
+    using ostd::test::fail_if;
+    auto enc = [](auto const &v) {
+        return serialize(appender<std::string>(), v).get();
+    };
+    fail_if(enc(std::uint32_t(0x01020304)) != "\x04\x03\x02\x01");
+    fail_if(enc(varint<unsigned>{300}) != "\xAC\x02");
+    fail_if(enc(varint<int>{-1}) != "\x01");
+    fail_if(enc(varint<int>{1}) != "\x02");
+    fail_if(enc(std::string{"ab"}) != "\x02" "ab");
+
+    detail::ser_test_rec rec;
+    rec.name = "hello";
+    rec.id = 1000000;
+    for (int i = -5000; i < 5000; ++i) {
+        rec.vals.push_back(std::int16_t(i));
+    }
+    rec.extra = std::make_pair(true, 0.5);
+    auto data = enc(rec);
+    fail_if(data.size() != (6 + 3 + 2 + 20000 + 1 + 9));
+
+    auto rec2 = deserialize<detail::ser_test_rec>(string_range{data});
+    fail_if(rec2.name != rec.name || rec2.id != rec.id);
+    fail_if(rec2.vals != rec.vals || rec2.extra != rec.extra);
+
+    string_range sr{data};
+    binary_reader<string_range> r{sr};
+    fail_if(r.read<std::string>() != "hello");
+    fail_if(r.read_varint<std::uint32_t>() != 1000000);
+    fail_if(r.read<std::vector<std::int16_t>>().size() != 10000);
+    bool thrown = false;
+    try {
+        deserialize<varint<std::uint8_t>>(string_range{"\xAC\x02"});
+    } catch (serialize_error const &) {
+        thrown = true;
+    }
+    fail_if(!thrown);
+    thrown = false;
+    try {
+        deserialize<detail::ser_test_rec>(string_range{data}.slice(0, 100));
+    } catch (serialize_error const &) {
+        thrown = true;
+    }
+    fail_if(!thrown);
+}
+#endif
+
+/** @} */
+
+} /* namespace ostd */
+
+#undef OSTD_TEST_MODULE
+
+#endif
+
+/** @} */
@@ -34,6 +34,7 @@
 #define OSTD_STREAM_HH
 
 #include <cstddef>
+#include <cstring>
 #include <cerrno>
 #include <cstdlib>
 #include <type_traits>
@@ -83,6 +84,26 @@ enum class stream_seek {
     SET = SEEK_SET  ///< Beginning of the stream.
 };
 
+/** @brief The mode to open streams with.
+ *
+ * This is used by ostd::file_stream, as well as other streams that can be
+ * opened in different modes, such as ostd::compressed_stream.
+ *
+ * Libostd file streams are always opened in binary mode. Text mode is not
+ * directly supported (the only way to get it is to encapsulate a C `FILE *`
+ * that is already opened in text mode).
+ *
+ * See the C fopen() function documentation for more info on modes.
+ */
+enum class stream_mode {
+    READ = 0, ///< Reading, equivalent to the C `rb` mode.
+    WRITE,    ///< Writing, equivalent to the C `wb` mode.
+    APPEND,   ///< Appending, equivalent to the C `ab` mode.
+    READ_U,   ///< Read/update, equivalent to the C `rb+` mode.
+    WRITE_U,  ///< Write/update, equivalent to the C `wb+` mode.
+    APPEND_U  ///< Append/update, equivalent to the C `ab+` mode.
+};
+
 
 template<typename T = char, bool = std::is_trivial_v<T>>
 struct stream_range;
@@ -315,9 +336,9 @@ struct OSTD_EXPORT stream {
             }
             if (c == '\r') {
                 cr = true;
-                continue;
+            } else {
+                writer.put(c);
             }
-            writer.put(c);
             gotc = safe_get<T>(c);
         } while (gotc && (c != '\n'));
         if (cr && (!gotc || keep_nl)) {
@@ -338,6 +359,10 @@ struct OSTD_EXPORT stream {
      * that can be formatted using ostd::format_spec with the default `%s`
      * format specifier. The stream's locale is passed into the formatter.
      *
+     * The output is collected in an ostd::buffered_stream_range, so unless
+     * it is larger than the buffer, it is written with a single call to
+     * write_bytes(). The same applies to the other writing methods.
+     *
      * @throws ostd::stream_error on write error.
      * @throws ostd::format_error if a value cannot be formatted.
      *
@@ -356,10 +381,7 @@ struct OSTD_EXPORT stream {
      * @see write(), writef(), writefln()
      */
     template<typename ...A>
-    void writeln(A const &...args) {
-        write(args...);
-        put_char('\n');
-    }
+    void writeln(A const &...args);
 
     /** @brief Writes a formatted string into the stream.
      *
@@ -385,10 +407,25 @@ struct OSTD_EXPORT stream {
      * @see writef(), write(), writeln()
      */
     template<typename ...A>
-    void writefln(string_range fmt, A const &...args) {
-        writef(fmt, args...);
-        put_char('\n');
-    }
+    void writefln(string_range fmt, A const &...args);
+
+    /** @brief Writes a compile-time format string into the stream.
+     *
+     * Like writef(string_range, A const &...), see ostd::static_format.
+     *
+     * @throws ostd::stream_error on write error.
+     */
+    template<typename S, typename ...A>
+    void writef(static_format<S> fmt, A const &...args);
+
+    /** @brief Writes a compile-time format string and a newline.
+     *
+     * Like writefln(string_range, A const &...), see ostd::static_format.
+     *
+     * @throws ostd::stream_error on write error.
+     */
+    template<typename S, typename ...A>
+    void writefln(static_format<S> fmt, A const &...args);
 
     /** @brief Creates a range around the stream.
      *
@@ -434,6 +471,8 @@ struct OSTD_EXPORT stream {
     /** @brief Writes a single value into the stream.
      *
      * Uses write_bytes() to write the value. The type must be trivial.
+     * The bytes are written as they are in memory; for a portable encoding
+     * use ostd::binary_writer instead.
      *
      * @throws ostd::stream_error on write failure.
      */
@@ -628,6 +667,11 @@ struct stream_range<T, true>: input_range<stream_range<T>> {
         p_stream->put(val);
     }
 
+    /** @brief Writes `n` values into the stream with a single write. */
+    void put_n(value_type const *p, std::size_t n) {
+        p_stream->put(p, n);
+    }
+
 private:
     stream *p_stream;
     mutable std::optional<T> p_item;
@@ -638,6 +682,101 @@ inline stream_range<T> stream::iter() {
     return stream_range<T>{*this};
 }
 
+/** @brief A buffered output range writing into a stream.
+ *
+ * Unlike ostd::stream_range, which writes every value with a separate
+ * ostd::stream::put() call, this collects the written characters in a
+ * fixed internal buffer of `N` bytes and passes them to the stream with
+ * ostd::stream::write_bytes() once the buffer is full or on flush(). It is
+ * what ostd::stream::write() and ostd::stream::writef() format into, so
+ * an entire formatted record usually reaches the stream in a single call.
+ *
+ * Contiguous character ranges given to ostd::range_put_all() are copied
+ * into the buffer in bulk; ranges larger than the buffer bypass it.
+ *
+ * The range does not own the stream. It's not copyable, as copies would
+ * each hold a part of the output. Any buffered data is written when the
+ * range is destroyed, but errors are ignored then; call flush() first to
+ * handle them.
+ *
+ * @tparam N The buffer size.
+ */
+template<std::size_t N = 4096>
+struct buffered_stream_range: output_range<buffered_stream_range<N>> {
+    static_assert(N > 0, "the buffer cannot be empty");
+
+    using value_type = char;
+    using reference  = char &;
+    using size_type  = std::size_t;
+
+    buffered_stream_range() = delete;
+
+    /** @brief Creates a buffered range over a stream. */
+    buffered_stream_range(stream &s) noexcept: p_stream(&s) {}
+
+    buffered_stream_range(buffered_stream_range const &) = delete;
+    buffered_stream_range &operator=(buffered_stream_range const &) = delete;
+
+    /** @brief Writes out the buffered data, ignoring errors. */
+    ~buffered_stream_range() {
+        try {
+            flush();
+        } catch (...) {}
+    }
+
+    /** @brief Buffers a character, flushing first if the buffer is full.
+     *
+     * @throws ostd::stream_error on write failure during the flush.
+     */
+    void put(char c) {
+        if (p_len == N) {
+            flush();
+        }
+        p_buf[p_len++] = c;
+    }
+
+    /** @brief Buffers `n` characters at once.
+     *
+     * If they don't fit, the buffer is flushed first; if they don't fit
+     * into an empty buffer either, they are written into the stream
+     * directly.
+     *
+     * @throws ostd::stream_error on write failure.
+     */
+    void put_n(char const *p, std::size_t n) {
+        if (n > (N - p_len)) {
+            flush();
+            if (n >= N) {
+                p_stream->write_bytes(p, n);
+                return;
+            }
+        }
+        std::memcpy(&p_buf[p_len], p, n);
+        p_len += n;
+    }
+
+    /** @brief Writes the buffered data into the stream.
+     *
+     * This is a single ostd::stream::write_bytes() call. The stream itself
+     * is not flushed.
+     *
+     * @throws ostd::stream_error on write failure.
+     */
+    void flush() {
+        if (p_len) {
+            /* reset first so a failed write is not repeated on destruction */
+            std::size_t n = p_len;
+            p_len = 0;
+            p_stream->write_bytes(p_buf, n);
+        }
+    }
+
+private:
+    stream *p_stream;
+    std::size_t p_len = 0;
+    char p_buf[N];
+};
+
 /** @brief A range type for streams to read by line.
  *
  * This is an input range (ostd::input_range_tag) which is not mutable,
@@ -774,13 +913,49 @@ inline stream_line_range<T, TC> stream::iter_lines(bool keep_nl) {
 
 template<typename ...A>
 inline void stream::write(A const &...args) {
+    buffered_stream_range<> out{*this};
     format_spec sp{'s', p_loc};
-    (sp.format_value(iter(), args), ...);
+    (sp.format_value(out, args), ...);
+    out.flush();
+}
+
+template<typename ...A>
+inline void stream::writeln(A const &...args) {
+    buffered_stream_range<> out{*this};
+    format_spec sp{'s', p_loc};
+    (sp.format_value(out, args), ...);
+    out.put('\n');
+    out.flush();
 }
 
 template<typename ...A>
 inline void stream::writef(string_range fmt, A const &...args) {
-    format_spec{fmt, p_loc}.format(iter(), args...);
+    buffered_stream_range<> out{*this};
+    format_spec{fmt, p_loc}.format(out, args...);
+    out.flush();
+}
+
+template<typename ...A>
+inline void stream::writefln(string_range fmt, A const &...args) {
+    buffered_stream_range<> out{*this};
+    format_spec{fmt, p_loc}.format(out, args...);
+    out.put('\n');
+    out.flush();
+}
+
+template<typename S, typename ...A>
+inline void stream::writef(static_format<S> fmt, A const &...args) {
+    buffered_stream_range<> out{*this};
+    fmt.format(out, p_loc, args...);
+    out.flush();
+}
+
+template<typename S, typename ...A>
+inline void stream::writefln(static_format<S> fmt, A const &...args) {
+    buffered_stream_range<> out{*this};
+    fmt.format(out, p_loc, args...);
+    out.put('\n');
+    out.flush();
 }
 
 /** @} */
@@ -50,6 +50,8 @@
 #ifndef OSTD_STRING_HH
 #define OSTD_STRING_HH
 
+#include <ostd/unit_test.hh>
+
 #include <cstdint>
 #include <cstddef>
 #include <cstring>
@@ -65,6 +67,8 @@
 #include <ostd/range.hh>
 #include <ostd/algorithm.hh>
 
+#define OSTD_TEST_MODULE libostd_string
+
 namespace ostd {
 
 static_assert(
@@ -306,6 +310,24 @@ public:
         *(p_beg++) = v;
     }
 
+    /** @brief Writes `n` characters at the beginning and pops them out.
+     *
+     * The characters are copied with a single `memmove`. If fewer than
+     * `n` of them fit, the ones that do are written.
+     *
+     * @throws std::out_of_range when not all of the characters fit.
+     */
+    template<typename U = T>
+    auto put_n(value_type const *p, size_type n) -> std::enable_if_t<
+        !std::is_const_v<U>
+    > {
+        size_type m = detail::put_n_copy(p_beg, size(), p, n);
+        p_beg += m;
+        if (m < n) {
+            throw std::out_of_range{"put into an empty range"};
+        }
+    }
+
     /** @brief Gets the pointer to the beginning. */
     value_type *data() noexcept { return p_beg; }
 
@@ -967,6 +989,11 @@ namespace utf {
      *
      * If you're sure the string is valid or you don't need to handle the
      * error, you can use the more convenient overload below.
+     *
+     * Where the CPU supports it (SSE4.2 or AVX2 on x86, picked at runtime),
+     * the string is validated and counted 16 or 32 bytes at a time, with
+     * runs of ASCII skipped as a whole; the result is always the same as
+     * with utf::decode() in a loop.
      */
     OSTD_EXPORT std::size_t length(string_range r, string_range &cont)
         noexcept;
@@ -1063,6 +1090,127 @@ namespace utf {
      */
     OSTD_EXPORT std::size_t length(wstring_range r) noexcept;
 
+    /** @brief Check whether a string is entirely valid UTF-8.
+     *
+     * This is the same as checking that utf::length() leaves no
+     * continuation string, and is vectorized the same way. Overlong
+     * sequences, surrogate code points and values above utf::max_unicode
+     * are invalid, exactly as with utf::decode(); unlike utf::isvalid(),
+     * non-characters are accepted, as they are valid in UTF-8.
+     */
+    OSTD_EXPORT bool validate(string_range r) noexcept;
+
+    namespace detail {
+        OSTD_EXPORT void transcode(
+            char *&obeg, char *oend, char const *&ibeg, char const *iend
+        ) noexcept;
+        OSTD_EXPORT void transcode(
+            char *&obeg, char *oend, char16_t const *&ibeg, char16_t const *iend
+        ) noexcept;
+        OSTD_EXPORT void transcode(
+            char *&obeg, char *oend, char32_t const *&ibeg, char32_t const *iend
+        ) noexcept;
+        OSTD_EXPORT void transcode(
+            char16_t *&obeg, char16_t *oend, char const *&ibeg, char const *iend
+        ) noexcept;
+        OSTD_EXPORT void transcode(
+            char16_t *&obeg, char16_t *oend,
+            char16_t const *&ibeg, char16_t const *iend
+        ) noexcept;
+        OSTD_EXPORT void transcode(
+            char16_t *&obeg, char16_t *oend,
+            char32_t const *&ibeg, char32_t const *iend
+        ) noexcept;
+        OSTD_EXPORT void transcode(
+            char32_t *&obeg, char32_t *oend, char const *&ibeg, char const *iend
+        ) noexcept;
+        OSTD_EXPORT void transcode(
+            char32_t *&obeg, char32_t *oend,
+            char16_t const *&ibeg, char16_t const *iend
+        ) noexcept;
+        OSTD_EXPORT void transcode(
+            char32_t *&obeg, char32_t *oend,
+            char32_t const *&ibeg, char32_t const *iend
+        ) noexcept;
+        OSTD_EXPORT std::size_t transcoded_size(
+            string_range r, std::size_t bits
+        ) noexcept;
+        OSTD_EXPORT std::size_t transcoded_size(
+            u16string_range r, std::size_t bits
+        ) noexcept;
+        OSTD_EXPORT std::size_t transcoded_size(
+            u32string_range r, std::size_t bits
+        ) noexcept;
+    } /* namespace detail */
+
+    /** @brief Get the number of code units a string transcodes into.
+     *
+     * The input is a contiguous character range in any UTF encoding and
+     * the output encoding is given by `C`, which can be any character type
+     * (utf::is_character). The result is the exact number of `C` values
+     * utf::transcode() writes for the input, i.e. for its valid part, so
+     * it can be used to size the output in advance.
+     */
+    template<typename C, typename R>
+    inline std::size_t transcoded_size(R const &r) noexcept {
+        using IC = unicode_base_t<std::remove_const_t<range_value_t<R>>>;
+        auto *p = reinterpret_cast<IC const *>(r.data());
+        return detail::transcoded_size(
+            basic_char_range<IC const>{p, p + r.size()}, unit_bits<C>
+        );
+    }
+
+    /** @brief Convert a whole string into a different UTF encoding.
+     *
+     * The input `r` is a contiguous character range in any encoding and
+     * the output encoding is picked by the value type of `sink`, which can
+     * be any of the character types (utf::is_character). Unlike iterating
+     * with utf::iter_u(), this converts runs of the input at once, using
+     * SIMD instructions where available, and writes the output in bulk.
+     *
+     * Conversion stops at the first invalid sequence in the input, which
+     * is left in `r`, so the whole input was converted if `r` is empty
+     * afterwards. If `sink` is a writable character range, the output is
+     * written directly into it and the conversion also stops when it is
+     * full, before a code point that does not fit; `sink` is advanced
+     * past the written part.
+     *
+     * The return value is the number of values written into `sink`.
+     * Use utf::transcoded_size() to find out how many there will be.
+     */
+    template<typename OR, typename IR>
+    inline std::size_t transcode(OR &sink, IR &r) {
+        using IC = unicode_base_t<std::remove_const_t<range_value_t<IR>>>;
+        using OC = std::remove_const_t<range_value_t<OR>>;
+        using OB = unicode_base_t<OC>;
+        auto *ib = reinterpret_cast<IC const *>(r.data());
+        auto *ip = ib, *ie = ib + r.size();
+        std::size_t ret = 0;
+        if constexpr(std::is_same_v<OR, basic_char_range<OC>>) {
+            auto *ob = reinterpret_cast<OB *>(sink.data());
+            auto *op = ob;
+            detail::transcode(op, ob + sink.size(), ip, ie);
+            ret = std::size_t(op - ob);
+            sink = sink.slice(ret, sink.size());
+        } else {
+            OB buf[256];
+            while (ip != ie) {
+                OB *op = buf;
+                detail::transcode(op, buf + 256, ip, ie);
+                if (op == buf) {
+                    break;
+                }
+                auto *cp = reinterpret_cast<OC const *>(buf);
+                range_put_all(
+                    sink, basic_char_range<OC const>{cp, cp + (op - buf)}
+                );
+                ret += std::size_t(op - buf);
+            }
+        }
+        r = r.slice(std::size_t(ip - ib), r.size());
+        return ret;
+    }
+
     namespace detail {
         template<typename IC, typename OC>
         struct unicode_range: input_range<unicode_range<IC, OC>> {
@@ -1335,6 +1483,9 @@ namespace utf {
      * before doing the comparison, with invalid code units being
      * compared as they are (so this function never fails).
      *
+     * Runs of ASCII in both strings are compared 16 bytes at a time
+     * where SIMD instructions are available.
+     *
      * @see basic_char_range::case_compare()
      */
     OSTD_EXPORT int case_compare(string_range s1, string_range s2) noexcept;
@@ -1376,6 +1527,74 @@ namespace utf {
      * @see basic_char_range::case_compare()
      */
     OSTD_EXPORT int case_compare(wstring_range s1, wstring_range s2) noexcept;
+
+    /** @brief Check if a UTF-8 string starts with another, ignoring case.
+     *
+     * The strings are compared the same way as with utf::case_compare(),
+     * i.e. by code points converted with utf::tolower(), with invalid code
+     * units compared as they are.
+     *
+     * @see ostd::starts_with()
+     */
+    OSTD_EXPORT bool case_starts_with(string_range a, string_range b)
+        noexcept;
+
+    /** @brief Check if a UTF-16 string starts with another, ignoring case.
+     *
+     * @see utf::case_starts_with(string_range, string_range)
+     */
+    OSTD_EXPORT bool case_starts_with(u16string_range a, u16string_range b)
+        noexcept;
+
+    /** @brief Check if a UTF-32 string starts with another, ignoring case.
+     *
+     * @see utf::case_starts_with(string_range, string_range)
+     */
+    OSTD_EXPORT bool case_starts_with(u32string_range a, u32string_range b)
+        noexcept;
+
+    /** @brief Check if a wide string starts with another, ignoring case.
+     *
+     * @see utf::case_starts_with(string_range, string_range)
+     */
+    OSTD_EXPORT bool case_starts_with(wstring_range a, wstring_range b)
+        noexcept;
+
+    /** @brief Find a UTF-8 string in another, ignoring case.
+     *
+     * Returns `a` starting at the first position where
+     * utf::case_starts_with() is true for `b`, or an empty slice at
+     * the end of `a` if there is no such position. An empty `b` is
+     * found at the beginning.
+     *
+     * If `b` begins with an ASCII character, the positions that cannot
+     * match are skipped 16 bytes at a time.
+     */
+    OSTD_EXPORT string_range case_find(string_range a, string_range b)
+        noexcept;
+
+    /** @brief Find a UTF-16 string in another, ignoring case.
+     *
+     * @see utf::case_find(string_range, string_range)
+     */
+    OSTD_EXPORT u16string_range case_find(
+        u16string_range a, u16string_range b
+    ) noexcept;
+
+    /** @brief Find a UTF-32 string in another, ignoring case.
+     *
+     * @see utf::case_find(string_range, string_range)
+     */
+    OSTD_EXPORT u32string_range case_find(
+        u32string_range a, u32string_range b
+    ) noexcept;
+
+    /** @brief Find a wide string in another, ignoring case.
+     *
+     * @see utf::case_find(string_range, string_range)
+     */
+    OSTD_EXPORT wstring_range case_find(wstring_range a, wstring_range b)
+        noexcept;
 /** @} */
 
 } /* namespace utf */
@@ -1411,6 +1630,616 @@ inline int basic_char_range<T>::case_compare(
     return utf::case_compare(*this, s);
 }
 
+/* substring search */
+
+/** @addtogroup Strings
+ * @{
+ */
+
+namespace detail {
+    OSTD_EXPORT std::size_t find_substr(
+        char const *h, std::size_t hn, char const *n, std::size_t nn
+    ) noexcept;
+    OSTD_EXPORT std::size_t find_substr(
+        char16_t const *h, std::size_t hn, char16_t const *n, std::size_t nn
+    ) noexcept;
+    OSTD_EXPORT std::size_t find_substr(
+        char32_t const *h, std::size_t hn, char32_t const *n, std::size_t nn
+    ) noexcept;
+    OSTD_EXPORT std::size_t rfind_substr(
+        char const *h, std::size_t hn, char const *n, std::size_t nn
+    ) noexcept;
+    OSTD_EXPORT std::size_t rfind_substr(
+        char16_t const *h, std::size_t hn, char16_t const *n, std::size_t nn
+    ) noexcept;
+    OSTD_EXPORT std::size_t rfind_substr(
+        char32_t const *h, std::size_t hn, char32_t const *n, std::size_t nn
+    ) noexcept;
+} /* namespace detail */
+
+/** @brief Finds the first occurrence of a substring.
+ *
+ * Returns `a` starting at the first occurrence of `b`, or an empty
+ * slice at the end of `a` if there is none. An empty `b` is found
+ * at the beginning.
+ *
+ * Candidate positions are found by comparing the first and the last
+ * unit of `b`, for 16 positions at once with SIMD instructions where
+ * available, and only those are compared in full. For searching the
+ * same `b` many times, ostd::basic_substr_searcher may be faster.
+ *
+ * @see ostd::rfind_substr(), ostd::contains()
+ */
+inline string_range find_substr(string_range a, string_range b) noexcept {
+    return a.slice(detail::find_substr(
+        a.data(), a.size(), b.data(), b.size()
+    ), a.size());
+}
+
+/** @brief Finds the first occurrence of a substring. */
+inline u16string_range find_substr(
+    u16string_range a, u16string_range b
+) noexcept {
+    return a.slice(detail::find_substr(
+        a.data(), a.size(), b.data(), b.size()
+    ), a.size());
+}
+
+/** @brief Finds the first occurrence of a substring. */
+inline u32string_range find_substr(
+    u32string_range a, u32string_range b
+) noexcept {
+    return a.slice(detail::find_substr(
+        a.data(), a.size(), b.data(), b.size()
+    ), a.size());
+}
+
+/** @brief Finds the first occurrence of a substring. */
+inline wstring_range find_substr(wstring_range a, wstring_range b) noexcept {
+    using C = utf::wchar_fixed_t;
+    return a.slice(detail::find_substr(
+        reinterpret_cast<C const *>(a.data()), a.size(),
+        reinterpret_cast<C const *>(b.data()), b.size()
+    ), a.size());
+}
+
+/** @brief Finds the last occurrence of a substring.
+ *
+ * Returns `a` starting at the last occurrence of `b`, or an empty
+ * slice at the end of `a` if there is none. An empty `b` is found
+ * at the end.
+ *
+ * @see ostd::find_substr()
+ */
+inline string_range rfind_substr(string_range a, string_range b) noexcept {
+    return a.slice(detail::rfind_substr(
+        a.data(), a.size(), b.data(), b.size()
+    ), a.size());
+}
+
+/** @brief Finds the last occurrence of a substring. */
+inline u16string_range rfind_substr(
+    u16string_range a, u16string_range b
+) noexcept {
+    return a.slice(detail::rfind_substr(
+        a.data(), a.size(), b.data(), b.size()
+    ), a.size());
+}
+
+/** @brief Finds the last occurrence of a substring. */
+inline u32string_range rfind_substr(
+    u32string_range a, u32string_range b
+) noexcept {
+    return a.slice(detail::rfind_substr(
+        a.data(), a.size(), b.data(), b.size()
+    ), a.size());
+}
+
+/** @brief Finds the last occurrence of a substring. */
+inline wstring_range rfind_substr(wstring_range a, wstring_range b) noexcept {
+    using C = utf::wchar_fixed_t;
+    return a.slice(detail::rfind_substr(
+        reinterpret_cast<C const *>(a.data()), a.size(),
+        reinterpret_cast<C const *>(b.data()), b.size()
+    ), a.size());
+}
+
+/** @brief Checks if a string slice contains another slice.
+ *
+ * @see ostd::find_substr()
+ */
+inline bool contains(string_range a, string_range b) noexcept {
+    return b.empty() || !find_substr(a, b).empty();
+}
+
+/** @brief Checks if a string slice contains another slice. */
+inline bool contains(u16string_range a, u16string_range b) noexcept {
+    return b.empty() || !find_substr(a, b).empty();
+}
+
+/** @brief Checks if a string slice contains another slice. */
+inline bool contains(u32string_range a, u32string_range b) noexcept {
+    return b.empty() || !find_substr(a, b).empty();
+}
+
+/** @brief Checks if a string slice contains another slice. */
+inline bool contains(wstring_range a, wstring_range b) noexcept {
+    return b.empty() || !find_substr(a, b).empty();
+}
+
+/** @brief A substring searcher for a string that is searched for often.
+ *
+ * The needle is preprocessed once into a table of shifts for the
+ * Boyer-Moore-Horspool algorithm, which lets the search skip ahead by
+ * up to the length of the needle after each mismatch. Short needles
+ * are searched for with ostd::find_substr() instead, which is faster
+ * for those. Units of wide strings share the table by their low 8 bits.
+ *
+ * The searcher only refers to the needle, so it must stay alive
+ * while the searcher is in use.
+ */
+template<typename T>
+struct basic_substr_searcher {
+    /** @brief The type of the needle and the searched strings. */
+    using range_type = basic_char_range<T const>;
+
+    /** @brief Prepares a searcher for `needle`. */
+    basic_substr_searcher(range_type needle) noexcept: p_needle(needle) {
+        std::size_t n = needle.size();
+        for (auto &s: p_skip) {
+            s = n;
+        }
+        for (std::size_t i = 0; (i + 1) < n; ++i) {
+            p_skip[bucket(needle[i])] = n - i - 1;
+        }
+    }
+
+    /** @brief Finds the first occurrence of the needle in `a`.
+     *
+     * The result is the same as with `ostd::find_substr(a, needle())`.
+     */
+    range_type find(range_type a) const noexcept {
+        std::size_t n = p_needle.size(), an = a.size();
+        if (n < MIN_SKIP) {
+            return find_substr(a, p_needle);
+        }
+        T const *ap = a.data(), *np = p_needle.data();
+        T last = np[n - 1];
+        for (std::size_t i = 0; (i + n) <= an;) {
+            T c = ap[i + n - 1];
+            if ((c == last) && !std::memcmp(ap + i, np, (n - 1) * sizeof(T))) {
+                return a.slice(i, an);
+            }
+            i += p_skip[bucket(c)];
+        }
+        return a.slice(an, an);
+    }
+
+    /** @brief Checks if `a` contains the needle. */
+    bool contains(range_type a) const noexcept {
+        return p_needle.empty() || !find(a).empty();
+    }
+
+    /** @brief Gets the needle. */
+    range_type needle() const noexcept {
+        return p_needle;
+    }
+
+private:
+    /* below this, skips are too short to pay off, more so against
+     * the vectorized search for UTF-8
+     */
+    static constexpr std::size_t MIN_SKIP = (sizeof(T) == 1) ? 16 : 4;
+
+    static std::size_t bucket(T c) noexcept {
+        return std::size_t(std::make_unsigned_t<T>(c)) & 0xFF;
+    }
+
+    range_type p_needle;
+    std::size_t p_skip[256];
+};
+
+/** @brief An ostd::basic_substr_searcher for UTF-8 strings. */
+using substr_searcher = basic_substr_searcher<char>;
+
+/** @brief An ostd::basic_substr_searcher for UTF-16 strings. */
+using u16substr_searcher = basic_substr_searcher<char16_t>;
+
+/** @brief An ostd::basic_substr_searcher for UTF-32 strings. */
+using u32substr_searcher = basic_substr_searcher<char32_t>;
+
+/** @brief An ostd::basic_substr_searcher for wide strings. */
+using wsubstr_searcher = basic_substr_searcher<wchar_t>;
+
+/* splitting */
+
+namespace detail {
+    OSTD_EXPORT std::size_t find_any(
+        char const *h, std::size_t hn, char const *set, std::size_t setn
+    ) noexcept;
+    OSTD_EXPORT std::size_t find_any(
+        char16_t const *h, std::size_t hn,
+        char16_t const *set, std::size_t setn
+    ) noexcept;
+    OSTD_EXPORT std::size_t find_any(
+        char32_t const *h, std::size_t hn,
+        char32_t const *set, std::size_t setn
+    ) noexcept;
+
+    /* wide strings are searched as their fixed size equivalents */
+    template<typename C>
+    using split_unit_t = std::conditional_t<
+        std::is_same_v<C, wchar_t>, utf::wchar_fixed_t, C
+    >;
+
+    template<typename C>
+    inline auto split_units(C const *p) noexcept {
+        return reinterpret_cast<split_unit_t<C> const *>(p);
+    }
+
+    template<typename C>
+    struct split_char_finder {
+        C sep;
+
+        std::size_t operator()(C const *h, std::size_t hn) const noexcept {
+            auto *p = std::char_traits<C>::find(h, hn, sep);
+            return p ? std::size_t(p - h) : hn;
+        }
+
+        std::size_t length() const noexcept {
+            return 1;
+        }
+    };
+
+    template<typename C>
+    struct split_str_finder {
+        basic_char_range<C const> sep;
+
+        std::size_t operator()(C const *h, std::size_t hn) const noexcept {
+            if (sep.empty()) {
+                return hn;
+            }
+            return find_substr(
+                split_units(h), hn, split_units(sep.data()), sep.size()
+            );
+        }
+
+        std::size_t length() const noexcept {
+            return sep.size();
+        }
+    };
+
+    template<typename C>
+    struct split_any_finder {
+        basic_char_range<C const> set;
+
+        std::size_t operator()(C const *h, std::size_t hn) const noexcept {
+            return find_any(
+                split_units(h), hn, split_units(set.data()), set.size()
+            );
+        }
+
+        std::size_t length() const noexcept {
+            return 1;
+        }
+    };
+
+    template<typename C, typename P>
+    struct split_pred_finder {
+        P pred;
+
+        std::size_t operator()(C const *h, std::size_t hn) const {
+            for (std::size_t i = 0; i < hn; ++i) {
+                if (pred(h[i])) {
+                    return i;
+                }
+            }
+            return hn;
+        }
+
+        std::size_t length() const noexcept {
+            return 1;
+        }
+    };
+
+    enum class split_mode {
+        FIELDS, LINES, TOKENS
+    };
+
+    template<typename T, typename F, split_mode M>
+    struct split_range: input_range<split_range<T, F, M>> {
+        using range_category = forward_range_tag;
+        using value_type = basic_char_range<T>;
+        using reference  = basic_char_range<T>;
+        using size_type  = std::size_t;
+
+    private:
+        basic_char_range<T> p_cur, p_rest;
+        F p_find;
+        bool p_last = false, p_end = false;
+
+    public:
+        split_range() = delete;
+
+        split_range(basic_char_range<T> const &range, F const &find):
+            p_rest(range), p_find(find)
+        {
+            pop_front();
+        }
+
+        bool empty() const noexcept { return p_end; }
+
+        void pop_front() {
+            for (;;) {
+                if (p_last || ((M != split_mode::FIELDS) && p_rest.empty())) {
+                    p_end = true;
+                    return;
+                }
+                std::size_t n = p_rest.size();
+                std::size_t pos = p_find(p_rest.data(), n);
+                if (pos == n) {
+                    p_cur = p_rest;
+                    p_last = true;
+                } else {
+                    p_cur = p_rest.slice(0, pos);
+                    p_rest = p_rest.slice(pos + p_find.length(), n);
+                }
+                if constexpr(M == split_mode::LINES) {
+                    if (!p_cur.empty() && (p_cur.back() == '\r')) {
+                        p_cur.pop_back();
+                    }
+                } else if constexpr(M == split_mode::TOKENS) {
+                    if (p_cur.empty()) {
+                        continue;
+                    }
+                }
+                return;
+            }
+        }
+
+        reference front() const noexcept { return p_cur; }
+    };
+}
+
+/** @brief Splits a string at each occurrence of a character.
+ *
+ * The result is a lazy forward range of slices of `range`, so nothing
+ * is copied. Every separator ends a field, so there is always one more
+ * field than there are separators and the fields can be empty, e.g.
+ * `"a,,b,"` gives `"a"`, `""`, `"b"` and `""`, and an empty string
+ * gives a single empty field.
+ *
+ * The separators are found with `std::char_traits::find`, which is
+ * `memchr` for UTF-8, typically using vector instructions.
+ *
+ * @see ostd::split_any(), ostd::tokenize()
+ */
+template<typename T>
+inline auto split(
+    basic_char_range<T> const &range, std::remove_const_t<T> sep
+) {
+    using C = std::remove_const_t<T>;
+    return detail::split_range<
+        T, detail::split_char_finder<C>, detail::split_mode::FIELDS
+    >{range, detail::split_char_finder<C>{sep}};
+}
+
+/** @brief Splits a string at each occurrence of a substring.
+ *
+ * This works like ostd::split() with a single character, with the
+ * separator found using ostd::find_substr(). An empty separator
+ * gives the whole string as a single field.
+ *
+ * The slice `sep` must stay alive while the result is used.
+ */
+template<typename T>
+inline auto split(
+    basic_char_range<T> const &range,
+    basic_char_range<std::remove_const_t<T> const> sep
+) {
+    using C = std::remove_const_t<T>;
+    return detail::split_range<
+        T, detail::split_str_finder<C>, detail::split_mode::FIELDS
+    >{range, detail::split_str_finder<C>{sep}};
+}
+
+/** @brief A pipeable version of ostd::split(). */
+template<typename S>
+inline auto split(S sep) {
+    return [sep](auto &obj) { return split(obj, sep); };
+}
+
+/** @brief Splits a string at any of the given characters.
+ *
+ * This works like ostd::split() with a single character, where each
+ * character in `chars` is a separator. The characters are compared
+ * as code units, so for UTF-8 they should be ASCII. Up to 16 of them
+ * are searched for 16 bytes at a time where SIMD instructions are
+ * available.
+ *
+ * The slice `chars` must stay alive while the result is used.
+ */
+template<typename T>
+inline auto split_any(
+    basic_char_range<T> const &range,
+    basic_char_range<std::remove_const_t<T> const> chars
+) {
+    using C = std::remove_const_t<T>;
+    return detail::split_range<
+        T, detail::split_any_finder<C>, detail::split_mode::FIELDS
+    >{range, detail::split_any_finder<C>{chars}};
+}
+
+/** @brief A pipeable version of ostd::split_any(). */
+template<typename S>
+inline auto split_any(S chars) {
+    return [chars](auto &obj) { return split_any(obj, chars); };
+}
+
+/** @brief Splits a string into lines.
+ *
+ * Lines are ended by `\n`, which is not included in them, and so is not
+ * a `\r` before it. A final line without a newline is a line too, while
+ * an empty remainder after the last newline is not, the same as with
+ * ostd::stream::iter_lines(). An empty string has no lines.
+ */
+template<typename T>
+inline auto split_lines(basic_char_range<T> const &range) {
+    using C = std::remove_const_t<T>;
+    return detail::split_range<
+        T, detail::split_char_finder<C>, detail::split_mode::LINES
+    >{range, detail::split_char_finder<C>{C('\n')}};
+}
+
+/** @brief A pipeable version of ostd::split_lines(). */
+inline auto split_lines() {
+    return [](auto &obj) { return split_lines(obj); };
+}
+
+/** @brief Splits a string into tokens delimited by characters matching
+ *         a predicate.
+ *
+ * The tokens are the non-empty runs of characters for which `pred`
+ * returns false, e.g. with `isspace` as the predicate, these are the
+ * words of the string. Unlike with ostd::split(), there are no empty
+ * results, so runs of delimiters count as one and the delimiters at
+ * the start and the end are ignored.
+ */
+template<typename T, typename P>
+inline auto tokenize(basic_char_range<T> const &range, P pred) {
+    using F = detail::split_pred_finder<std::remove_const_t<T>, P>;
+    return detail::split_range<T, F, detail::split_mode::TOKENS>{
+        range, F{std::move(pred)}
+    };
+}
+
+/** @brief A pipeable version of ostd::tokenize(). */
+template<typename P>
+inline auto tokenize(P &&pred) {
+    return [pred = std::forward<P>(pred)](auto &obj) {
+        return tokenize(obj, pred);
+    };
+}
+
+#ifdef OSTD_BUILD_TESTS
+OSTD_UNIT_TEST {
+    using ostd::test::fail_if;
+    /* UTF-8 validation and counting, which may go in blocks of 16 or
+     * 32 bytes, against decoding one code point at a time, with each
+     * sequence at every offset around the block boundaries
+     */
+    auto u8len = [](string_range s, string_range &cont) {
+        std::size_t n = 0;
+        for (char32_t c; !s.empty(); ++n) {
+            string_range t = s;
+            if (!utf::decode(t, c)) {
+                break;
+            }
+            s = t;
+        }
+        cont = s;
+        return n;
+    };
+    char const *seqs[] = {
+        /* valid, including the ends of the ranges */
+        "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\xEF\xBF\xBF",
+        "\xED\x9F\xBF", "\xEE\x80\x80", "\xF4\x8F\xBF\xBF",
+        /* truncated and stray continuations */
+        "\x80", "\xC3", "\xE2\x82", "\xF0\x9F\x98", "\xC3\xA9\xA9",
+        /* overlong */
+        "\xC0\xAF", "\xC1\xBF", "\xE0\x80\xAF", "\xE0\x9F\xBF",
+        "\xF0\x80\x80\xAF", "\xF0\x8F\xBF\xBF",
+        /* surrogates and above the maximum */
+        "\xED\xA0\x80", "\xED\xBF\xBF", "\xF4\x90\x80\x80", "\xFF"
+    };
+    for (std::size_t i = 0; i < 70; ++i) {
+        for (auto *sq: seqs) {
+            for (std::size_t j: {0, 1, 40}) {
+                for (bool ascii: {true, false}) {
+                    std::string s;
+                    for (std::size_t k = 0; k < i; ++k) {
+                        s += (ascii || (k % 3)) ? "a" : "\xC3\xA9";
+                    }
+                    s += sq;
+                    s.append(j, 'b');
+                    string_range c1, c2;
+                    fail_if(utf::length(s, c1) != u8len(s, c2));
+                    fail_if(c1.size() != c2.size());
+                    fail_if(utf::validate(s) != c2.empty());
+                }
+            }
+        }
+    }
+
+    /* transcoding, including an invalid sequence */
+    string_range in = "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80";
+    auto out = appender<std::u32string>();
+    fail_if(utf::transcode(out, in) != 4 || !in.empty());
+    fail_if(out.get() != U"aé€\U0001F600");
+    fail_if(utf::transcoded_size<char16_t>(u32string_range{out.get()}) != 5);
+    char buf[4];
+    char_range cr{buf, buf + 4};
+    u32string_range u32in = out.get();
+    fail_if(utf::transcode(cr, u32in) != 3 || u32in.size() != 2);
+    string_range bad = "ab\xFF" "cd";
+    auto bout = appender<std::string>();
+    fail_if(utf::transcode(bout, bad) != 2 || bad != "\xFF" "cd");
+
+    /* short haystacks and needles at the very end */
+    fail_if(find_substr("abc", "c") != "c" || find_substr("ab", "") != "ab");
+    fail_if(find_substr("abc", "abc") != "abc");
+    fail_if(!find_substr("abc", "abcd").empty());
+    fail_if(!find_substr("", "a").empty() || !find_substr("abc", "cb").empty());
+    std::string h(40, 'a');
+    h += "ab";
+    fail_if(find_substr(h, "ab") != "ab" || find_substr(h, "aab") != "aab");
+    fail_if(!find_substr(h, "ba").empty() || find_substr(h, h) != h);
+    fail_if(rfind_substr("abab", "ab") != "ab" || rfind_substr(h, "a") != "ab");
+    fail_if(!rfind_substr("abc", "x").empty());
+    fail_if(!rfind_substr("ab", "").empty());
+    fail_if(!contains(h, "") || contains("ab", "abc"));
+    fail_if(find_substr(U"xyz", U"z") != U"z" || !contains(L"wide", L"id"));
+
+    /* long needles take the skip table path */
+    std::string n = "0123456789abcdefghij";
+    substr_searcher ss{n};
+    fail_if(ss.find(h + n) != n || ss.find(n) != n || ss.find(n + h) != n + h);
+    fail_if(!ss.find(h).empty() || !ss.find("0123").empty() || ss.contains(h));
+    fail_if(substr_searcher{"ab"}.find(h) != "ab");
+    fail_if(!substr_searcher{""}.contains(""));
+
+    auto fields = [](auto &&r) {
+        std::vector<std::string> ret;
+        for (auto s: r) {
+            ret.emplace_back(s);
+        }
+        return ret;
+    };
+    using sv = std::vector<std::string>;
+
+    /* separators */
+    fail_if(fields(split(string_range{"a,,b,"}, ',')) != sv{"a", "", "b", ""});
+    fail_if(fields(split(string_range{}, ',')) != sv{""});
+    fail_if(fields(split(string_range{"a::b"}, "::")) != sv{"a", "b"});
+    fail_if(fields(split(string_range{"a,b"}, "")) != sv{"a,b"});
+    fail_if(fields(split_any(string_range{"a b\tc "}, " \t")) != sv{
+        "a", "b", "c", ""
+    });
+    fail_if(fields(split_lines(string_range{"a\r\nb\n\nc"})) != sv{
+        "a", "b", "", "c"
+    });
+    fail_if(fields(split_lines(string_range{"a\n"})) != sv{"a"});
+    fail_if(!fields(split_lines(string_range{})).empty());
+    auto ws = [](char c) { return c == ' '; };
+    fail_if(fields(tokenize(string_range{"  foo  bar "}, ws)) != sv{
+        "foo", "bar"
+    });
+    fail_if(!fields(tokenize(string_range{"   "}, ws)).empty());
+}
+#endif
+
+/** @} */
+
 /* string literals */
 
 inline namespace literals {
@@ -1465,6 +2294,8 @@ struct hash<ostd::basic_char_range<T>> {
 
 }
 
+#undef OSTD_TEST_MODULE
+
 #endif
 
 /** @} */
@@ -0,0 +1,409 @@
+/** @addtogroup Strings
+ * @{
+ */
+
+/** @file string_builder.hh
+ *
+ * @brief Building many short-lived strings without allocations.
+ *
+ * Formatting into an ostd::appender() over an std::string allocates
+ * memory for every string, which adds up when thousands of small strings
+ * are made and thrown away again, such as while handling a request. This
+ * file provides a string builder with inline storage for short strings,
+ * and a monotonic arena, from which the builder takes memory for longer
+ * strings and into which finished strings are stored. Resetting the
+ * arena releases all of its strings at once, while keeping its memory
+ * for reuse, so after a warm-up nothing is allocated anymore.
+ *
+ * ~~~{.cc}
+ * ostd::string_arena arena;
+ * for (auto &req: requests) {
+ *     ostd::string_builder b{arena};
+ *     std::vector<ostd::string_range> parts;
+ *     for (auto &v: req.values) {
+ *         ostd::format(b, "%s=%d", v.name, v.value);
+ *         parts.push_back(b.finish());
+ *     }
+ *     handle(req, parts);
+ *     arena.reset();
+ * }
+ * ~~~
+ *
+ * @copyright See COPYING.md in the project tree for further information.
+ */
+
+#ifndef OSTD_STRING_BUILDER_HH
+#define OSTD_STRING_BUILDER_HH
+
+#include <ostd/unit_test.hh>
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#include <ostd/platform.hh>
+#include <ostd/range.hh>
+#include <ostd/string.hh>
+
+#ifdef OSTD_BUILD_TESTS
+#include <ostd/format.hh>
+#endif
+
+#define OSTD_TEST_MODULE libostd_string_builder
+
+namespace ostd {
+
+/** @addtogroup Strings
+ * @{
+ */
+
+/** @brief A monotonic memory arena for strings.
+ *
+ * Memory is taken from large blocks by moving a pointer forward, and is
+ * never freed individually; instead, reset() makes all of it available
+ * again at once. The blocks themselves are kept until the arena is
+ * destroyed, so an arena that is reset and reused for similar work stops
+ * allocating after the first round.
+ *
+ * Requests bigger than the block size get a block of their own. The arena
+ * is not thread safe; use one arena per thread.
+ */
+struct OSTD_EXPORT string_arena {
+    /** @brief The default size of a block. */
+    static constexpr std::size_t DEFAULT_BLOCK_SIZE = 1 << 14;
+
+    /** @brief Creates an arena, allocating nothing until needed. */
+    string_arena(std::size_t block_size = DEFAULT_BLOCK_SIZE) noexcept:
+        p_bsize(block_size)
+    {}
+
+    string_arena(string_arena const &) = delete;
+    string_arena &operator=(string_arena const &) = delete;
+
+    /** @brief Allocates `n` bytes aligned to `align`.
+     *
+     * The alignment must be a power of two. The memory stays valid until
+     * the arena is reset or destroyed.
+     *
+     * @throws std::bad_alloc if a new block cannot be allocated.
+     */
+    void *allocate(std::size_t n, std::size_t align = 1);
+
+    /** @brief Tries to grow the last allocation in place.
+     *
+     * This only succeeds when `p` with size `oldn` is the most recent
+     * allocation and there's room for `newn` bytes in its block.
+     */
+    bool extend(void *p, std::size_t oldn, std::size_t newn) noexcept {
+        auto *cp = static_cast<char *>(p);
+        if (
+            ((cp + oldn) != p_cur) ||
+            ((newn - oldn) > std::size_t(p_end - p_cur))
+        ) {
+            return false;
+        }
+        p_cur = cp + newn;
+        return true;
+    }
+
+    /** @brief Gives back the end of the last allocation.
+     *
+     * When `p` with size `oldn` is the most recent allocation, everything
+     * past its first `newn` bytes becomes available again; otherwise this
+     * has no effect.
+     */
+    void shrink(void *p, std::size_t oldn, std::size_t newn) noexcept {
+        auto *cp = static_cast<char *>(p);
+        if ((cp + oldn) == p_cur) {
+            p_cur = cp + newn;
+        }
+    }
+
+    /** @brief Copies a string into the arena.
+     *
+     * The copy is not zero terminated.
+     *
+     * @throws std::bad_alloc if a new block cannot be allocated.
+     */
+    template<typename T>
+    basic_char_range<T const> copy(basic_char_range<T const> s) {
+        std::size_t n = s.size() * sizeof(T);
+        auto *p = static_cast<T *>(allocate(n, alignof(T)));
+        std::memcpy(p, s.data(), n);
+        return basic_char_range<T const>{p, p + s.size()};
+    }
+
+    /** @brief Makes all of the memory available again.
+     *
+     * Everything allocated from the arena so far becomes invalid; the
+     * blocks are kept and reused by later allocations.
+     */
+    void reset() noexcept;
+
+    /** @brief Gets the total size of the blocks. */
+    std::size_t memory_size() const noexcept;
+
+private:
+    struct block {
+        std::unique_ptr<char[]> data;
+        std::size_t size;
+    };
+
+    std::vector<block> p_blocks;
+    std::size_t p_bsize;
+    std::size_t p_block = 0;
+    char *p_cur = nullptr, *p_end = nullptr;
+};
+
+/** @brief An output range building a string in inline or arena storage.
+ *
+ * The first `N` characters are stored within the builder itself, so
+ * building short strings needs no memory from anywhere else. When more
+ * space is needed, it's taken from the ostd::string_arena the builder was
+ * created with, growing the string in place where possible; a builder
+ * without an arena uses the heap instead.
+ *
+ * Besides the output range interface, with `put_n()` for adding many
+ * characters at once, the builder can return its contents as a slice,
+ * either one that is valid until the builder changes (view()), or one
+ * that is stored in the arena (finish()). After finish(), the builder is
+ * empty and can be used for the next string.
+ */
+template<typename T, std::size_t N = 128>
+struct basic_string_builder: output_range<basic_string_builder<T, N>> {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    /** @brief The character type. */
+    using value_type = T;
+    /** @brief The type of the slices given out. */
+    using range_type = basic_char_range<T const>;
+
+    /** @brief Creates a builder that grows on the heap. */
+    basic_string_builder() noexcept {}
+
+    /** @brief Creates a builder that grows in the given arena.
+     *
+     * The arena must stay alive while the builder is used.
+     */
+    explicit basic_string_builder(string_arena &arena) noexcept:
+        p_arena(&arena)
+    {}
+
+    basic_string_builder(basic_string_builder const &) = delete;
+    basic_string_builder &operator=(basic_string_builder const &) = delete;
+
+    ~basic_string_builder() {
+        release();
+    }
+
+    /** @brief Appends a character. */
+    void put(T c) {
+        if (p_size == p_cap) {
+            grow(1);
+        }
+        p_data[p_size++] = c;
+    }
+
+    /** @brief Appends `n` characters. */
+    void put_n(T const *p, std::size_t n) {
+        if (!n) {
+            return;
+        }
+        if ((p_cap - p_size) < n) {
+            grow(n);
+        }
+        std::memcpy(p_data + p_size, p, n * sizeof(T));
+        p_size += n;
+    }
+
+    /** @brief Appends a string. */
+    void append(range_type s) {
+        put_n(s.data(), s.size());
+    }
+
+    /** @brief Makes sure there's room for `n` characters in total. */
+    void reserve(std::size_t n) {
+        if (n > p_cap) {
+            grow(n - p_size);
+        }
+    }
+
+    /** @brief Gets the number of characters. */
+    std::size_t size() const noexcept {
+        return p_size;
+    }
+
+    /** @brief Gets the number of characters that fit without growing. */
+    std::size_t capacity() const noexcept {
+        return p_cap;
+    }
+
+    /** @brief Checks if the string is empty. */
+    bool empty() const noexcept {
+        return !p_size;
+    }
+
+    /** @brief Gets a pointer to the characters. */
+    T const *data() const noexcept {
+        return p_data;
+    }
+
+    /** @brief Removes all characters, keeping the storage. */
+    void clear() noexcept {
+        p_size = 0;
+    }
+
+    /** @brief Gets the contents.
+     *
+     * The slice is valid until the builder is changed or destroyed.
+     */
+    range_type view() const noexcept {
+        return range_type{p_data, p_data + p_size};
+    }
+
+    /** @brief Gets the contents as a standard string. */
+    std::basic_string<T> str() const {
+        return std::basic_string<T>{p_data, p_size};
+    }
+
+    /** @brief Moves the contents into the arena and starts over.
+     *
+     * The returned slice is valid until the arena is reset or destroyed.
+     * Contents that are already in the arena are not copied; the rest of
+     * their space is given back to the arena.
+     *
+     * @throws std::logic_error if the builder has no arena.
+     * @throws std::bad_alloc if the arena cannot allocate a new block.
+     */
+    range_type finish() {
+        if (!p_arena) {
+            throw std::logic_error{"string builder without an arena"};
+        }
+        range_type ret;
+        if (p_data == p_buf) {
+            /* inline contents never exceed the buffer; saying so
+             * explicitly keeps compilers from warning about bounds
+             */
+            std::size_t n = std::min(p_size, N);
+            ret = p_arena->copy(range_type{p_buf, p_buf + n});
+        } else {
+            p_arena->shrink(p_data, p_cap * sizeof(T), p_size * sizeof(T));
+            ret = view();
+        }
+        p_data = p_buf;
+        p_cap = N;
+        p_size = 0;
+        return ret;
+    }
+
+private:
+    void release() noexcept {
+        if (!p_arena && (p_data != p_buf)) {
+            delete[] p_data;
+        }
+    }
+
+    void grow(std::size_t n) {
+        std::size_t ncap = std::max(p_cap * 2, p_size + n);
+        if (p_arena && (p_data != p_buf) && p_arena->extend(
+            p_data, p_cap * sizeof(T), ncap * sizeof(T)
+        )) {
+            p_cap = ncap;
+            return;
+        }
+        T *ndata;
+        if (p_arena) {
+            ndata = static_cast<T *>(
+                p_arena->allocate(ncap * sizeof(T), alignof(T))
+            );
+        } else {
+            ndata = new T[ncap];
+        }
+        std::memcpy(ndata, p_data, p_size * sizeof(T));
+        release();
+        p_data = ndata;
+        p_cap = ncap;
+    }
+
+    string_arena *p_arena = nullptr;
+    T *p_data = p_buf;
+    std::size_t p_size = 0, p_cap = N;
+    T p_buf[N];
+};
+
+/** @brief An ostd::basic_string_builder for UTF-8 strings. */
+using string_builder = basic_string_builder<char>;
+
+/** @brief An ostd::basic_string_builder for UTF-16 strings. */
+using u16string_builder = basic_string_builder<char16_t>;
+
+/** @brief An ostd::basic_string_builder for UTF-32 strings. */
+using u32string_builder = basic_string_builder<char32_t>;
+
+/** @brief An ostd::basic_string_builder for wide strings. */
+using wstring_builder = basic_string_builder<wchar_t>;
+
+#ifdef OSTD_BUILD_TESTS
+OSTD_UNIT_TEST {
+    using ostd::test::fail_if;
+    string_arena arena{256};
+
+    basic_string_builder<char, 8> b{arena};
+    format(b, "%s=%d", "key", 42);
+    fail_if(b.view() != "key=42" || b.capacity() != 8);
+    auto s1 = b.finish();
+    fail_if(s1 != "key=42" || !b.empty());
+
+    /* grows into the arena and in place there */
+    for (int i = 0; i < 20; ++i) {
+        format(b, "%d,", i);
+    }
+    fail_if(b.capacity() <= 8 || b.size() != 50);
+    auto s2 = b.finish();
+    b.append("next");
+    auto s3 = b.finish();
+    fail_if(s1 != "key=42" || s2.size() != 50 || s3 != "next");
+    fail_if(s2.slice(0, 6) != "0,1,2," || s2.slice(47, 50) != "19,");
+
+    /* reuse after a reset, without new blocks */
+    auto msize = arena.memory_size();
+    arena.reset();
+    for (int i = 0; i < 20; ++i) {
+        format(b, "%d,", i);
+    }
+    fail_if(b.finish().size() != 50 || arena.memory_size() != msize);
+
+    /* large allocations get their own block */
+    std::string big(1000, 'x');
+    b.append(big);
+    fail_if(b.finish() != big);
+
+    basic_string_builder<char, 4> hb;
+    hb.append("hello world");
+    hb.put('!');
+    fail_if(hb.view() != "hello world!" || hb.str() != "hello world!");
+    bool thrown = false;
+    try {
+        hb.finish();
+    } catch (std::logic_error const &) {
+        thrown = true;
+    }
+    fail_if(!thrown);
+}
+#endif
+
+/** @} */
+
+} /* namespace ostd */
+
+#undef OSTD_TEST_MODULE
+
+#endif
+
+/** @} */
@@ -0,0 +1,328 @@
+/** @addtogroup Strings
+ * @{
+ */
+
+/** @file string_interner.hh
+ *
+ * @brief Storing each distinct string only once.
+ *
+ * Programs that hold many copies of the same strings, such as names and
+ * identifiers, can use an interner to keep a single copy of each one. The
+ * interner gives out small handles instead of strings; handles of equal
+ * strings are always equal, so comparing and hashing them doesn't need
+ * to look at the characters at all.
+ *
+ * ~~~{.cc}
+ * ostd::string_interner names;
+ * auto a = names.intern("foo");
+ * auto b = names.intern(std::string{"fo"} + "o");
+ * assert(a == b && a.data() == b.data());
+ * assert(names[a.id()] == a);
+ * ~~~
+ *
+ * @copyright See COPYING.md in the project tree for further information.
+ */
+
+#ifndef OSTD_STRING_INTERNER_HH
+#define OSTD_STRING_INTERNER_HH
+
+#include <ostd/unit_test.hh>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <optional>
+#include <functional>
+
+#include <ostd/platform.hh>
+#include <ostd/string.hh>
+
+#ifdef OSTD_BUILD_TESTS
+#include <string>
+#include <thread>
+#include <unordered_set>
+#endif
+
+#define OSTD_TEST_MODULE libostd_string_interner
+
+namespace ostd {
+
+/** @addtogroup Strings
+ * @{
+ */
+
+namespace detail {
+    /* every stored string is preceded by this and followed by a zero */
+    struct intern_header {
+        std::uint32_t id;
+        std::uint32_t size;
+    };
+
+    /* the empty string, shared by all interners */
+    OSTD_EXPORT extern intern_header const intern_empty[2];
+
+    inline intern_header intern_get_header(char const *str) noexcept {
+        intern_header ret;
+        std::memcpy(&ret, str - sizeof(intern_header), sizeof(ret));
+        return ret;
+    }
+
+    struct intern_entry {
+        std::size_t hash;
+        char const *str;
+    };
+
+    struct alignas(64) intern_shard {
+        std::mutex lock;
+        /* open addressing, the size is zero or a power of two */
+        std::vector<intern_entry> table;
+        std::size_t used = 0;
+        std::vector<std::unique_ptr<char[]>> blocks;
+        char *cur = nullptr;
+        std::size_t left = 0;
+        std::size_t allocated = 0;
+    };
+}
+
+/** @brief A handle to a string stored in an ostd::string_interner.
+ *
+ * The handle is just a pointer to the stored characters, which are kept
+ * in place for as long as the interner exists, so it can be freely copied
+ * and the views it gives out stay valid. Since every distinct string is
+ * stored once, two handles from the same interner are equal exactly when
+ * their strings are equal, which is checked by comparing the pointers.
+ * Handles from different interners must not be compared.
+ *
+ * The stored strings are zero terminated. A default constructed handle
+ * represents the empty string, which is the same for all interners and
+ * always has the ID zero.
+ */
+struct interned_string {
+    /** @brief Creates a handle to the empty string. */
+    interned_string() noexcept:
+        p_str(reinterpret_cast<char const *>(&detail::intern_empty[1]))
+    {}
+
+    /** @brief Gets a pointer to the zero terminated characters. */
+    char const *data() const noexcept {
+        return p_str;
+    }
+
+    /** @brief Gets the number of characters. */
+    std::size_t size() const noexcept {
+        return detail::intern_get_header(p_str).size;
+    }
+
+    /** @brief Checks if the string is empty. */
+    bool empty() const noexcept {
+        return !size();
+    }
+
+    /** @brief Gets the ID of the string within its interner.
+     *
+     * The IDs are assigned consecutively from one in the order the strings
+     * were first interned, and can be turned back into handles using
+     * ostd::string_interner::operator[]().
+     */
+    std::uint32_t id() const noexcept {
+        return detail::intern_get_header(p_str).id;
+    }
+
+    /** @brief Gets a view of the string. */
+    string_range view() const noexcept {
+        return string_range{p_str, p_str + size()};
+    }
+
+    /** @brief Gets a view of the string. */
+    operator string_range() const noexcept {
+        return view();
+    }
+
+    /** @brief Checks if two handles refer to the same string. */
+    bool operator==(interned_string const &o) const noexcept {
+        return p_str == o.p_str;
+    }
+
+    /** @brief Checks if two handles refer to different strings. */
+    bool operator!=(interned_string const &o) const noexcept {
+        return p_str != o.p_str;
+    }
+
+private:
+    friend struct string_interner;
+
+    explicit interned_string(char const *str) noexcept: p_str(str) {}
+
+    char const *p_str;
+};
+
+/** @brief A thread safe pool of unique strings.
+ *
+ * Interning a string looks it up in a hash table and, if it's not there
+ * yet, copies it into memory owned by the interner. The memory is taken
+ * from large blocks, so the strings don't need an allocation each and
+ * are packed closely together; nothing is freed before the interner is
+ * destroyed, so all handles stay valid until then.
+ *
+ * All methods can be called from any number of threads at once. The
+ * strings are spread over a number of shards by their hash, and each
+ * shard has its own table, memory and lock, so threads interning
+ * different strings rarely wait for each other. Looking up a string by
+ * its ID takes no lock.
+ *
+ * The IDs and sizes are 32-bit, so the interner can hold at most
+ * 2^32 - 1 strings and each can be at most 4 GiB long; going over either
+ * limit throws std::length_error.
+ */
+struct OSTD_EXPORT string_interner {
+    /** @brief Creates an empty interner. */
+    string_interner();
+
+    string_interner(string_interner const &) = delete;
+    string_interner &operator=(string_interner const &) = delete;
+
+    ~string_interner();
+
+    /** @brief Gets the handle of a string, storing it if it's new.
+     *
+     * @throws std::length_error if the limits are exceeded.
+     */
+    interned_string intern(string_range str);
+
+    /** @brief Gets the handle of a string if it's already stored. */
+    std::optional<interned_string> find(string_range str) const;
+
+    /** @brief Gets the handle of the string with the given ID.
+     *
+     * The ID must be zero or come from a handle given out by this
+     * interner. Other IDs up to ostd::string_interner::size() are only
+     * valid once no other thread is interning strings, see there.
+     */
+    interned_string operator[](std::uint32_t id) const noexcept {
+        auto idx = (id / ID_BLOCK) + 1;
+        std::size_t seg = 0;
+        while (idx >>= 1) {
+            ++seg;
+        }
+        auto *ids = p_ids[seg].load(std::memory_order_acquire);
+        return interned_string{ids[id - ID_BLOCK * ((1u << seg) - 1)]};
+    }
+
+    /** @brief Gets the number of stored strings.
+     *
+     * The empty string is not stored, so the valid IDs are zero up to
+     * and including the returned number. The count is taken before the
+     * new string's ID is published though, so while other threads are
+     * interning, it may include IDs that can't be looked up yet; only
+     * the IDs of handles returned by the interner are safe to look up
+     * then. Once the interning is done, e.g. the threads are joined,
+     * all of them are.
+     */
+    std::size_t size() const noexcept {
+        return p_count.load(std::memory_order_relaxed);
+    }
+
+    /** @brief Gets the number of bytes allocated for the strings. */
+    std::size_t memory_size() const;
+
+private:
+    static constexpr std::size_t SHARDS = 16;
+    static constexpr std::size_t BLOCK_SIZE = 1 << 16;
+
+    /* the ID table grows by segments of doubling size, which are never
+     * moved, so that lookups don't need to lock anything
+     */
+    static constexpr std::uint32_t ID_BLOCK = 1024;
+    static constexpr std::size_t ID_SEGMENTS = 23;
+
+    static std::size_t shard_index(std::size_t hash) noexcept {
+        return (hash >> (sizeof(std::size_t) * 8 - 4)) & (SHARDS - 1);
+    }
+
+    char const *store(detail::intern_shard &sh, string_range str);
+
+    mutable detail::intern_shard p_shards[SHARDS];
+    std::atomic<char const **> p_ids[ID_SEGMENTS];
+    std::atomic<std::uint32_t> p_count{0};
+};
+
+#ifdef OSTD_BUILD_TESTS
+OSTD_UNIT_TEST {
+    using ostd::test::fail_if;
+    string_interner si;
+    fail_if(si.size() != 0);
+    auto e = si.intern("");
+    fail_if(e != interned_string{} || e.id() != 0 || !e.empty());
+    fail_if(si[0] != e || *e.data() != '\0');
+
+    auto a = si.intern("foo");
+    auto b = si.intern(std::string{"fo"} + "o");
+    auto c = si.intern("bar");
+    fail_if(a != b || a == c || a.data() != b.data());
+    fail_if(a.view() != "foo" || a.size() != 3 || a.data()[3] != '\0');
+    fail_if(a.id() != 1 || c.id() != 2 || si.size() != 2);
+    fail_if(si[1] != a || si[2] != c);
+    fail_if(!si.find("bar") || (*si.find("bar") != c) || si.find("baz"));
+    fail_if(si.size() != 2 || si.memory_size() == 0);
+
+    /* enough strings to grow the tables, from several threads */
+    std::vector<std::thread> thrs;
+    std::vector<std::vector<interned_string>> res(4);
+    for (std::size_t t = 0; t < res.size(); ++t) {
+        thrs.emplace_back([&si, &res, t]() {
+            for (int i = 0; i < 5000; ++i) {
+                res[t].push_back(si.intern(std::to_string(i * 7)));
+            }
+        });
+    }
+    for (auto &t: thrs) {
+        t.join();
+    }
+    fail_if(si.size() != 5002);
+    std::unordered_set<std::uint32_t> ids;
+    for (std::size_t i = 0; i < 5000; ++i) {
+        fail_if(res[0][i] != res[3][i] || res[1][i] != res[2][i]);
+        fail_if(res[0][i] != res[1][i]);
+        fail_if(res[0][i].view() != std::to_string(i * 7));
+        fail_if(si[res[0][i].id()] != res[0][i]);
+        ids.insert(res[0][i].id());
+    }
+    fail_if(ids.size() != 5000);
+}
+#endif
+
+/** @} */
+
+} /* namespace ostd */
+
+namespace std {
+
+/** @addtogroup Strings
+ * @{
+ */
+
+/** @brief Standard std::hash integration for interned strings.
+ *
+ * This hashes the pointer, so it's fast but will not match the hash
+ * of the same string in other types.
+ */
+template<>
+struct hash<ostd::interned_string> {
+    std::size_t operator()(ostd::interned_string const &v) const noexcept {
+        return hash<char const *>{}(v.data());
+    }
+};
+
+/** @} */
+
+}
+
+#undef OSTD_TEST_MODULE
+
+#endif
+
+/** @} */
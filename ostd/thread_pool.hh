@@ -27,6 +27,8 @@
 #include <mutex>
 #include <condition_variable>
 
+#include <ostd/platform.hh>
+
 namespace ostd {
 
 /** @addtogroup Concurrency
@@ -34,7 +36,7 @@ namespace ostd {
  */
 
 namespace detail {
-    struct tpool_func_base {
+    struct OSTD_EXPORT tpool_func_base {
         tpool_func_base() {}
         virtual ~tpool_func_base();
         virtual void clone(tpool_func_base *func) = 0;
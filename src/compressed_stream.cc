@@ -0,0 +1,430 @@
+/* Compressed stream adapters implementation.
+ *
+ * This file is part of libostd. See COPYING.md for futher information.
+ */
+
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <new>
+#include <vector>
+#include <algorithm>
+
+#include "ostd/compressed_stream.hh"
+
+#ifdef OSTD_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef OSTD_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace ostd {
+
+namespace detail {
+    static constexpr std::size_t const cstream_bufsize = 64 * 1024;
+
+    struct cstream_state {
+        stream *base;
+        compression_format fmt;
+        bool writing;
+        /* end indicator as seen by the user */
+        bool eof = false;
+        /* the wrapped stream has no more data */
+        bool in_eof = false;
+        /* the codec is in the middle of a member or frame */
+        bool in_frame = false;
+        stream_off_t total = 0;
+        /* compressed data; when reading, ipos..ilen is not consumed yet */
+        std::vector<unsigned char> ibuf;
+        std::size_t ipos = 0, ilen = 0;
+        /* uncompressed data; when reading, opos..olen is not returned yet */
+        std::vector<unsigned char> obuf;
+        std::size_t opos = 0, olen = 0;
+#ifdef OSTD_HAVE_ZLIB
+        z_stream zs;
+#endif
+#ifdef OSTD_HAVE_ZSTD
+        ZSTD_DStream *zds = nullptr;
+        ZSTD_CStream *zcs = nullptr;
+#endif
+
+        cstream_state(stream &s, compression_format f, bool w):
+            base(&s), fmt(f), writing(w),
+            ibuf(cstream_bufsize), obuf(cstream_bufsize)
+        {}
+
+        ~cstream_state() {
+            switch (fmt) {
+#ifdef OSTD_HAVE_ZLIB
+                case compression_format::GZIP:
+                case compression_format::ZLIB:
+                case compression_format::DEFLATE:
+                    if (writing) {
+                        deflateEnd(&zs);
+                    } else {
+                        inflateEnd(&zs);
+                    }
+                    break;
+#endif
+#ifdef OSTD_HAVE_ZSTD
+                case compression_format::ZSTD:
+                    ZSTD_freeDStream(zds);
+                    ZSTD_freeCStream(zcs);
+                    break;
+#endif
+                default:
+                    break;
+            }
+        }
+
+        [[noreturn]] static void fail(int err = EIO) {
+            throw stream_error{err, std::generic_category()};
+        }
+
+        void init(int level) {
+            switch (fmt) {
+#ifdef OSTD_HAVE_ZLIB
+                case compression_format::GZIP:
+                case compression_format::ZLIB:
+                case compression_format::DEFLATE: {
+                    std::memset(&zs, 0, sizeof(zs));
+                    int wbits = 15;
+                    if (fmt == compression_format::DEFLATE) {
+                        wbits = -15;
+                    } else if (fmt == compression_format::GZIP) {
+                        /* when reading, detect gzip or zlib header */
+                        wbits += writing ? 16 : 32;
+                    }
+                    int ret;
+                    if (writing) {
+                        ret = deflateInit2(
+                            &zs, (level < 0) ? Z_DEFAULT_COMPRESSION : level,
+                            Z_DEFLATED, wbits, 8, Z_DEFAULT_STRATEGY
+                        );
+                    } else {
+                        ret = inflateInit2(&zs, wbits);
+                    }
+                    if (ret != Z_OK) {
+                        fail(ENOMEM);
+                    }
+                    return;
+                }
+#endif
+#ifdef OSTD_HAVE_ZSTD
+                case compression_format::ZSTD:
+                    if (writing) {
+                        zcs = ZSTD_createCStream();
+                        if (!zcs || ZSTD_isError(ZSTD_initCStream(
+                            zcs, (level < 0) ? ZSTD_CLEVEL_DEFAULT : level
+                        ))) {
+                            fail(ENOMEM);
+                        }
+                    } else {
+                        zds = ZSTD_createDStream();
+                        if (!zds || ZSTD_isError(ZSTD_initDStream(zds))) {
+                            fail(ENOMEM);
+                        }
+                    }
+                    return;
+#endif
+                default:
+                    break;
+            }
+            (void)level;
+            fail(ENOTSUP);
+        }
+
+        /* run the decompressor over ibuf into obuf; true at end of frame */
+        bool run_inflate() {
+            switch (fmt) {
+#ifdef OSTD_HAVE_ZLIB
+                case compression_format::GZIP:
+                case compression_format::ZLIB:
+                case compression_format::DEFLATE: {
+                    zs.next_in = &ibuf[ipos];
+                    zs.avail_in = uInt(ilen - ipos);
+                    zs.next_out = &obuf[olen];
+                    zs.avail_out = uInt(obuf.size() - olen);
+                    int ret = inflate(&zs, Z_NO_FLUSH);
+                    ipos = ilen - zs.avail_in;
+                    olen = obuf.size() - zs.avail_out;
+                    if (ret == Z_STREAM_END) {
+                        if (inflateReset(&zs) != Z_OK) {
+                            fail();
+                        }
+                        return true;
+                    }
+                    /* Z_BUF_ERROR only means no progress was possible */
+                    if ((ret != Z_OK) && (ret != Z_BUF_ERROR)) {
+                        fail();
+                    }
+                    return false;
+                }
+#endif
+#ifdef OSTD_HAVE_ZSTD
+                case compression_format::ZSTD: {
+                    ZSTD_inBuffer in{&ibuf[0], ilen, ipos};
+                    ZSTD_outBuffer out{&obuf[0], obuf.size(), olen};
+                    auto ret = ZSTD_decompressStream(zds, &out, &in);
+                    if (ZSTD_isError(ret)) {
+                        fail();
+                    }
+                    ipos = in.pos;
+                    olen = out.pos;
+                    return (ret == 0);
+                }
+#endif
+                default:
+                    break;
+            }
+            fail(ENOTSUP);
+        }
+
+        /* refill obuf with decompressed data, false at the end */
+        bool fill() {
+            opos = olen = 0;
+            for (;;) {
+                if ((ipos == ilen) && !in_eof) {
+                    ipos = 0;
+                    ilen = base->read_bytes(&ibuf[0], ibuf.size());
+                    in_eof = !ilen;
+                }
+                if ((ipos == ilen) && in_eof && !in_frame) {
+                    return false;
+                }
+                std::size_t pi = ipos;
+                in_frame = !run_inflate();
+                if (olen) {
+                    return true;
+                }
+                if ((ipos == pi) && (ipos == ilen) && in_eof && in_frame) {
+                    /* truncated data, nothing can be decoded anymore */
+                    fail();
+                }
+            }
+        }
+
+        void write_out() {
+            if (olen) {
+                base->write_bytes(&obuf[0], olen);
+                olen = 0;
+            }
+        }
+
+        /* 0 means no flush, 1 means sync flush, 2 means finish */
+        void run_deflate(unsigned char const *buf, std::size_t count, int mode) {
+            switch (fmt) {
+#ifdef OSTD_HAVE_ZLIB
+                case compression_format::GZIP:
+                case compression_format::ZLIB:
+                case compression_format::DEFLATE: {
+                    static int const zmodes[] = {
+                        Z_NO_FLUSH, Z_SYNC_FLUSH, Z_FINISH
+                    };
+                    zs.next_in = const_cast<unsigned char *>(buf);
+                    zs.avail_in = uInt(count);
+                    for (;;) {
+                        zs.next_out = &obuf[olen];
+                        zs.avail_out = uInt(obuf.size() - olen);
+                        int ret = deflate(&zs, zmodes[mode]);
+                        olen = obuf.size() - zs.avail_out;
+                        if ((ret != Z_OK) && (ret != Z_BUF_ERROR) && (
+                            ret != Z_STREAM_END
+                        )) {
+                            fail();
+                        }
+                        if (olen == obuf.size()) {
+                            write_out();
+                            continue;
+                        }
+                        /* output space left, so all input was consumed */
+                        if ((mode == 2) && (ret != Z_STREAM_END)) {
+                            continue;
+                        }
+                        break;
+                    }
+                    return;
+                }
+#endif
+#ifdef OSTD_HAVE_ZSTD
+                case compression_format::ZSTD: {
+                    static ZSTD_EndDirective const zmodes[] = {
+                        ZSTD_e_continue, ZSTD_e_flush, ZSTD_e_end
+                    };
+                    ZSTD_inBuffer in{buf, count, 0};
+                    for (;;) {
+                        ZSTD_outBuffer out{&obuf[0], obuf.size(), olen};
+                        auto ret = ZSTD_compressStream2(
+                            zcs, &out, &in, zmodes[mode]
+                        );
+                        if (ZSTD_isError(ret)) {
+                            fail();
+                        }
+                        olen = out.pos;
+                        if (olen == obuf.size()) {
+                            write_out();
+                            continue;
+                        }
+                        if ((in.pos < in.size) || (mode && ret)) {
+                            continue;
+                        }
+                        break;
+                    }
+                    return;
+                }
+#endif
+                default:
+                    break;
+            }
+            (void)buf;
+            (void)count;
+            (void)mode;
+            fail(ENOTSUP);
+        }
+    };
+}
+
+OSTD_EXPORT compressed_stream::~compressed_stream() {
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
+OSTD_EXPORT bool compressed_stream::is_supported(compression_format fmt)
+    noexcept
+{
+    switch (fmt) {
+#ifdef OSTD_HAVE_ZLIB
+        case compression_format::GZIP:
+        case compression_format::ZLIB:
+        case compression_format::DEFLATE:
+            return true;
+#endif
+#ifdef OSTD_HAVE_ZSTD
+        case compression_format::ZSTD:
+            return true;
+#endif
+        default:
+            break;
+    }
+    return false;
+}
+
+OSTD_EXPORT void compressed_stream::open(
+    stream &base, compression_format fmt, stream_mode mode, int level
+) {
+    if (p_state) {
+        throw stream_error{EINVAL, std::generic_category()};
+    }
+    if ((mode != stream_mode::READ) && (mode != stream_mode::WRITE)) {
+        throw stream_error{EINVAL, std::generic_category()};
+    }
+    if (!is_supported(fmt)) {
+        throw stream_error{ENOTSUP, std::generic_category()};
+    }
+    auto *st = new detail::cstream_state{
+        base, fmt, (mode == stream_mode::WRITE)
+    };
+    try {
+        st->init(level);
+    } catch (...) {
+        delete st;
+        throw;
+    }
+    p_state = st;
+}
+
+OSTD_EXPORT void compressed_stream::close() {
+    auto *st = static_cast<detail::cstream_state *>(p_state);
+    if (!st) {
+        return;
+    }
+    /* make sure the state is freed even if finishing fails */
+    p_state = nullptr;
+    try {
+        if (st->writing) {
+            st->run_deflate(nullptr, 0, 2);
+            st->write_out();
+            st->base->flush();
+        }
+    } catch (...) {
+        delete st;
+        throw;
+    }
+    delete st;
+}
+
+OSTD_EXPORT bool compressed_stream::end() const {
+    auto *st = static_cast<detail::cstream_state const *>(p_state);
+    return !st || st->eof;
+}
+
+OSTD_EXPORT stream_off_t compressed_stream::tell() const {
+    auto *st = static_cast<detail::cstream_state const *>(p_state);
+    if (!st) {
+        throw stream_error{EINVAL, std::generic_category()};
+    }
+    return st->total;
+}
+
+OSTD_EXPORT void compressed_stream::flush() {
+    auto *st = static_cast<detail::cstream_state *>(p_state);
+    if (!st || !st->writing) {
+        return;
+    }
+    st->run_deflate(nullptr, 0, 1);
+    st->write_out();
+    st->base->flush();
+}
+
+OSTD_EXPORT std::size_t compressed_stream::read_bytes(
+    void *buf, std::size_t count
+) {
+    auto *st = static_cast<detail::cstream_state *>(p_state);
+    if (!st || st->writing) {
+        throw stream_error{EINVAL, std::generic_category()};
+    }
+    auto *out = static_cast<unsigned char *>(buf);
+    std::size_t readn = 0;
+    while (readn < count) {
+        if ((st->opos == st->olen) && !st->fill()) {
+            st->eof = true;
+            break;
+        }
+        std::size_t n = std::min(count - readn, st->olen - st->opos);
+        std::memcpy(out + readn, &st->obuf[st->opos], n);
+        st->opos += n;
+        readn += n;
+    }
+    st->total += stream_off_t(readn);
+    return readn;
+}
+
+OSTD_EXPORT void compressed_stream::write_bytes(
+    void const *buf, std::size_t count
+) {
+    auto *st = static_cast<detail::cstream_state *>(p_state);
+    if (!st || !st->writing) {
+        throw stream_error{EINVAL, std::generic_category()};
+    }
+    st->run_deflate(static_cast<unsigned char const *>(buf), count, 0);
+    st->total += stream_off_t(count);
+}
+
+OSTD_EXPORT int compressed_stream::get_char() {
+    auto *st = static_cast<detail::cstream_state *>(p_state);
+    if (!st || st->writing) {
+        throw stream_error{EINVAL, std::generic_category()};
+    }
+    if ((st->opos == st->olen) && !st->fill()) {
+        st->eof = true;
+        throw stream_error{EIO, std::generic_category()};
+    }
+    ++st->total;
+    return st->obuf[st->opos++];
+}
+
+} /* namespace ostd */
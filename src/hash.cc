@@ -0,0 +1,33 @@
+/* Hashing implementation.
+ *
+ * This file is part of libostd. See COPYING.md for futher information.
+ */
+
+#include <cstdint>
+#include <chrono>
+#include <random>
+
+#include "ostd/hash.hh"
+
+namespace ostd {
+
+OSTD_EXPORT std::uint64_t hash_seed() noexcept {
+    static std::uint64_t const seed = []() {
+        /* the random device may be deterministic on some platforms,
+         * so mix in the time and the address space layout as well
+         */
+        std::uint64_t ret = 0;
+        try {
+            std::random_device rd;
+            ret = (std::uint64_t(rd()) << 32) | rd();
+        } catch (...) {}
+        ret ^= std::uint64_t(
+            std::chrono::high_resolution_clock::now().time_since_epoch().count()
+        );
+        ret ^= std::uint64_t(reinterpret_cast<std::uintptr_t>(&ret));
+        return hash_bytes(&ret, sizeof(ret), ret);
+    }();
+    return seed;
+}
+
+} /* namespace ostd */
@@ -10,12 +10,14 @@
 
 #include "ostd/stream.hh"
 #include "ostd/io.hh"
+#include "ostd/serialize.hh"
 
 namespace ostd {
 
 /* place the vtable in here */
 stream_error::~stream_error() {}
 stream::~stream() {}
+serialize_error::~serialize_error() {}
 
 static char const *filemodes[] = {
     "rb", "wb", "ab", "rb+", "wb+", "ab+"
@@ -0,0 +1,254 @@
+/* Line index implementation.
+ *
+ * This file is part of libostd. See COPYING.md for futher information.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <future>
+#include <thread>
+#include <algorithm>
+
+#include "ostd/line_index.hh"
+#include "ostd/serialize.hh"
+#include "ostd/thread_pool.hh"
+#include "ostd/io.hh"
+
+namespace ostd {
+
+namespace detail {
+    static constexpr std::size_t lidx_block_size = 1 << 16;
+
+    /* files smaller than this are not worth splitting between threads */
+    static constexpr std::uint64_t lidx_par_min = 1 << 24;
+
+    static constexpr char lidx_magic[8] = {
+        'O', 'S', 'T', 'D', 'L', 'I', 'D', 'X'
+    };
+    static constexpr unsigned lidx_version = 1;
+
+    /* records the offset after every newline in the buffer */
+    static void lidx_scan(
+        char const *buf, std::size_t n, std::uint64_t base,
+        std::vector<std::uint64_t> &out
+    ) {
+        char const *p = buf, *e = buf + n;
+        while (p != e) {
+            auto *nl = static_cast<char const *>(
+                std::memchr(p, '\n', std::size_t(e - p))
+            );
+            if (!nl) {
+                break;
+            }
+            out.push_back(base + std::uint64_t(nl - buf) + 1);
+            p = nl + 1;
+        }
+    }
+
+    /* scans [beg, end) of the stream, returns the data read up to end */
+    static std::uint64_t lidx_scan_stream(
+        stream &s, std::uint64_t beg, std::uint64_t end,
+        std::vector<std::uint64_t> &out
+    ) {
+        std::vector<char> buf(lidx_block_size);
+        std::uint64_t pos = beg;
+        s.seek(stream_off_t(beg));
+        while (pos < end) {
+            std::size_t want = std::size_t(
+                std::min(std::uint64_t(buf.size()), end - pos)
+            );
+            std::size_t n = s.read_bytes(buf.data(), want);
+            if (!n) {
+                break;
+            }
+            lidx_scan(buf.data(), n, pos, out);
+            pos += n;
+        }
+        return pos;
+    }
+
+    /* newline offsets plus the size make the line starts: the first line
+     * starts at zero unless the data is empty, and the offset after a
+     * final newline does not start another line
+     */
+    static void lidx_finish(
+        std::vector<std::uint64_t> &offs, std::uint64_t size
+    ) {
+        if (!offs.empty() && (offs.back() == size)) {
+            offs.pop_back();
+        }
+        if (size) {
+            offs.insert(offs.begin(), 0);
+        }
+    }
+}
+
+OSTD_EXPORT line_index line_index::build(stream &s) {
+    line_index ret;
+    ret.p_size = detail::lidx_scan_stream(
+        s, 0, ~std::uint64_t(0), ret.p_offsets
+    );
+    detail::lidx_finish(ret.p_offsets, ret.p_size);
+    return ret;
+}
+
+OSTD_EXPORT line_index line_index::build(
+    string_range path, std::size_t threads
+) {
+    file_stream f{path};
+    if (!f.is_open()) {
+        throw stream_error{errno, std::generic_category()};
+    }
+    if (!threads) {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    std::uint64_t size = std::uint64_t(f.size());
+    if ((threads < 2) || (size < detail::lidx_par_min)) {
+        return build(f);
+    }
+    f.close();
+
+    std::uint64_t chunk = (size + threads - 1) / threads;
+    std::vector<std::future<std::vector<std::uint64_t>>> parts;
+    thread_pool tp;
+    tp.start(threads);
+    for (std::uint64_t beg = 0; beg < size; beg += chunk) {
+        std::uint64_t end = std::min(size, beg + chunk);
+        parts.push_back(tp.push([path, beg, end]() {
+            std::vector<std::uint64_t> ret;
+            file_stream cf{path};
+            if (!cf.is_open()) {
+                throw stream_error{errno, std::generic_category()};
+            }
+            if (detail::lidx_scan_stream(cf, beg, end, ret) != end) {
+                /* the file got shorter under our hands */
+                throw stream_error{EIO, std::generic_category()};
+            }
+            return ret;
+        }));
+    }
+
+    line_index ret;
+    ret.p_size = size;
+    /* get() rethrows the first error from the tasks */
+    std::vector<std::vector<std::uint64_t>> got;
+    for (auto &p: parts) {
+        got.push_back(p.get());
+    }
+    std::size_t total = 1;
+    for (auto &g: got) {
+        total += g.size();
+    }
+    ret.p_offsets.reserve(total);
+    for (auto &g: got) {
+        ret.p_offsets.insert(ret.p_offsets.end(), g.begin(), g.end());
+    }
+    detail::lidx_finish(ret.p_offsets, ret.p_size);
+    return ret;
+}
+
+OSTD_EXPORT void line_index::save(stream &s) const {
+    binary_writer<stream> w{s};
+    w.write_bytes(detail::lidx_magic, sizeof(detail::lidx_magic));
+    w.write_varint(detail::lidx_version);
+    w.write_varint(p_size);
+    w.write_varint(p_offsets.size());
+    std::uint64_t prev = 0;
+    for (auto off: p_offsets) {
+        w.write_varint(off - prev);
+        prev = off;
+    }
+    w.flush();
+}
+
+OSTD_EXPORT line_index line_index::load(stream &s) {
+    binary_reader<stream> r{s};
+    char magic[sizeof(detail::lidx_magic)];
+    r.read_bytes(magic, sizeof(magic));
+    if (std::memcmp(magic, detail::lidx_magic, sizeof(magic))) {
+        throw serialize_error{"not a line index"};
+    }
+    if (r.read_varint<unsigned>() != detail::lidx_version) {
+        throw serialize_error{"unsupported line index version"};
+    }
+    line_index ret;
+    ret.p_size = r.read_varint<std::uint64_t>();
+    auto n = r.read_varint<std::uint64_t>();
+    /* every line takes at least a byte, so this also bounds the memory
+     * we allocate for a corrupt header
+     */
+    if (n > ret.p_size) {
+        throw serialize_error{"invalid line index"};
+    }
+    ret.p_offsets.reserve(std::size_t(n));
+    std::uint64_t prev = 0;
+    for (std::uint64_t i = 0; i < n; ++i) {
+        auto d = r.read_varint<std::uint64_t>();
+        if ((i ? !d : d) || (d >= (ret.p_size - prev))) {
+            throw serialize_error{"invalid line index"};
+        }
+        prev += d;
+        ret.p_offsets.push_back(prev);
+    }
+    return ret;
+}
+
+OSTD_EXPORT line_index line_index::open(
+    string_range path, std::size_t threads
+) {
+    std::string ipath{path};
+    ipath += suffix;
+    stream_off_t size;
+    {
+        file_stream f{path};
+        if (!f.is_open()) {
+            throw stream_error{errno, std::generic_category()};
+        }
+        size = f.size();
+    }
+    {
+        file_stream f{ipath};
+        if (f.is_open()) {
+            try {
+                auto ret = load(f);
+                if (ret.data_size() == size) {
+                    return ret;
+                }
+            } catch (serialize_error const &) {
+            } catch (stream_error const &) {
+            }
+        }
+    }
+    auto ret = build(path, threads);
+    try {
+        file_stream f{ipath, stream_mode::WRITE};
+        if (f.is_open()) {
+            ret.save(f);
+        }
+    } catch (stream_error const &) {
+    }
+    return ret;
+}
+
+OSTD_EXPORT std::string line_index_range::read_line(size_type i) const {
+    auto beg = p_index->line_begin(i);
+    std::string ret;
+    ret.resize(std::size_t(p_index->line_end(i) - beg));
+    p_stream->seek(beg);
+    if (p_stream->read_bytes(ret.data(), ret.size()) != ret.size()) {
+        throw stream_error{EIO, std::generic_category()};
+    }
+    if (!ret.empty() && (ret.back() == '\n')) {
+        ret.pop_back();
+        if (!ret.empty() && (ret.back() == '\r')) {
+            ret.pop_back();
+        }
+    }
+    return ret;
+}
+
+} /* namespace ostd */
@@ -0,0 +1,155 @@
+/* Multi-pattern matcher implementation.
+ *
+ * This file is part of libostd. See COPYING.md for futher information.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+#include "ostd/multi_match.hh"
+
+namespace ostd {
+
+namespace detail {
+    struct mm_edge {
+        unsigned char byte;
+        std::uint32_t state;
+
+        bool operator<(mm_edge const &o) const noexcept {
+            return byte < o.byte;
+        }
+    };
+
+    static std::uint32_t mm_goto(
+        std::vector<std::vector<mm_edge>> const &trie,
+        std::uint32_t st, unsigned char c
+    ) noexcept {
+        auto &edges = trie[st];
+        auto it = std::lower_bound(
+            edges.begin(), edges.end(), mm_edge{c, 0}
+        );
+        if ((it == edges.end()) || (it->byte != c)) {
+            return 0;
+        }
+        return it->state;
+    }
+} /* namespace detail */
+
+OSTD_EXPORT void multi_matcher::compile() {
+    /* the trie, with the edges of each state sorted by byte */
+    std::vector<std::vector<detail::mm_edge>> trie(1);
+    std::vector<std::vector<std::uint32_t>> outs(1);
+    bool used[256] = {};
+    for (std::size_t i = 0; i < p_patterns.size(); ++i) {
+        auto &pat = p_patterns[i];
+        if (pat.empty()) {
+            continue;
+        }
+        std::uint32_t st = 0;
+        for (unsigned char c: pat) {
+            used[c] = true;
+            auto &edges = trie[st];
+            auto it = std::lower_bound(
+                edges.begin(), edges.end(), detail::mm_edge{c, 0}
+            );
+            if ((it != edges.end()) && (it->byte == c)) {
+                st = it->state;
+                continue;
+            }
+            auto nst = std::uint32_t(trie.size());
+            edges.insert(it, detail::mm_edge{c, nst});
+            trie.emplace_back();
+            outs.emplace_back();
+            st = nst;
+        }
+        outs[st].push_back(std::uint32_t(i));
+    }
+    std::size_t nstates = trie.size();
+
+    p_nclasses = 1;
+    for (std::size_t c = 0; c < 256; ++c) {
+        p_classes[c] = used[c] ? std::uint16_t(p_nclasses++) : 0;
+    }
+
+    /* failure links in breadth first order, so that the failure state
+     * of a state (always shallower) is resolved before the state itself
+     */
+    std::vector<std::uint32_t> order;
+    order.reserve(nstates);
+    order.push_back(0);
+    p_fail.assign(nstates, 0);
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        std::uint32_t st = order[i];
+        for (auto &e: trie[st]) {
+            order.push_back(e.state);
+            if (!st) {
+                continue;
+            }
+            std::uint32_t f = p_fail[st];
+            for (;;) {
+                std::uint32_t nf = detail::mm_goto(trie, f, e.byte);
+                if (nf || !f) {
+                    p_fail[e.state] = nf;
+                    break;
+                }
+                f = p_fail[f];
+            }
+        }
+    }
+
+    p_report.assign(nstates, 0);
+    p_dict.assign(nstates, 0);
+    for (auto st: order) {
+        if (!st) {
+            continue;
+        }
+        auto f = p_fail[st];
+        p_dict[st] = p_report[f];
+        p_report[st] = outs[st].empty() ? p_dict[st] : st;
+    }
+
+    p_outs.clear();
+    p_out_pats.clear();
+    p_outs.reserve(nstates + 1);
+    for (auto &o: outs) {
+        p_outs.push_back(std::uint32_t(p_out_pats.size()));
+        p_out_pats.insert(p_out_pats.end(), o.begin(), o.end());
+    }
+    p_outs.push_back(std::uint32_t(p_out_pats.size()));
+
+    p_delta.clear();
+    p_edges.clear();
+    p_edge_bytes.clear();
+    p_edge_states.clear();
+    if ((nstates * p_nclasses) <= DENSE_MAX) {
+        /* every missing edge goes where the failure state's edge goes,
+         * which is already filled in as the failure state is shallower
+         */
+        p_delta.assign(nstates * p_nclasses, 0);
+        for (auto st: order) {
+            auto *row = &p_delta[st * p_nclasses];
+            if (st) {
+                auto *frow = &p_delta[p_fail[st] * p_nclasses];
+                std::copy(frow, frow + p_nclasses, row);
+            }
+            for (auto &e: trie[st]) {
+                row[p_classes[e.byte]] = e.state;
+            }
+        }
+        p_fail.clear();
+    } else {
+        p_edges.reserve(nstates + 1);
+        for (auto &edges: trie) {
+            p_edges.push_back(std::uint32_t(p_edge_bytes.size()));
+            for (auto &e: edges) {
+                p_edge_bytes.push_back(e.byte);
+                p_edge_states.push_back(e.state);
+            }
+        }
+        p_edges.push_back(std::uint32_t(p_edge_bytes.size()));
+    }
+}
+
+} /* namespace ostd */
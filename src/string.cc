@@ -12,6 +12,12 @@
 #include "ostd/platform.hh"
 #include "ostd/string.hh"
 #include "ostd/format.hh"
+#include "ostd/scan.hh"
+
+#if defined(OSTD_TOOLCHAIN_GNU) && (defined(__x86_64__) || defined(__i386__))
+#  define OSTD_UTF8_SIMD 1
+#  include <immintrin.h>
+#endif
 
 namespace ostd {
 namespace detail {
@@ -156,6 +162,349 @@ namespace detail {
         return 1;
     }
 
+    /* UTF-8 validation and counting in bulk
+     *
+     * The vectorized scanners check a whole block of input at once using
+     * the lookup method by Keiser and Lemire: for every byte, the high
+     * nibble of the previous byte, the low nibble of the previous byte and
+     * its own high nibble each index a table of possible errors, and the
+     * three results AND'd together give the errors within every 2-byte
+     * window; a lead of a 3 or 4 byte sequence 2 or 3 bytes back must also
+     * be followed by continuation bytes. Code points are counted as all
+     * bytes that are not continuation bytes. Blocks of pure ASCII are
+     * skipped without any further checks.
+     *
+     * A scanner stops at the first block it cannot accept (an invalid
+     * block or the tail shorter than a block) and returns the beginning
+     * of the last sequence started before it; the scalar decoder finishes
+     * from there, so the results are always the same as with the scalar
+     * decoder alone, which accepts exactly what the lookup tables do.
+     */
+
+    static inline unsigned char const *u8_skip_ascii(
+        unsigned char const *beg, unsigned char const *end
+    ) noexcept {
+        /* high bits of each byte in a size_t */
+        constexpr std::size_t Hbits =
+            std::numeric_limits<std::size_t>::max() / 0xFF * 0x80;
+        while (std::size_t(end - beg) >= sizeof(std::size_t)) {
+            std::size_t w;
+            std::memcpy(&w, beg, sizeof(w));
+            if (w & Hbits) {
+                break;
+            }
+            beg += sizeof(w);
+        }
+        for (; (beg != end) && (*beg <= 0x7F); ++beg) {}
+        return beg;
+    }
+
+    static inline std::size_t u8_length_scalar(
+        unsigned char const *&beg, unsigned char const *end
+    ) noexcept {
+        std::size_t ret = 0;
+        for (;;) {
+            auto *abeg = u8_skip_ascii(beg, end);
+            ret += std::size_t(abeg - beg);
+            beg = abeg;
+            char32_t ch;
+            std::size_t n = u8_decode(beg, end, ch);
+            if (!n) {
+                break;
+            }
+            beg += n;
+            ++ret;
+        }
+        return ret;
+    }
+
+    /* the beginning of a sequence crossing into the block at p, if any;
+     * its lead byte was already counted, so take it back
+     */
+    static inline unsigned char const *u8_seq_start(
+        unsigned char const *beg, unsigned char const *p, std::size_t &count
+    ) noexcept {
+        for (std::ptrdiff_t k = 1; (k <= 3) && ((p - beg) >= k); ++k) {
+            unsigned char c = p[-k];
+            if (c <= 0x7F) {
+                break;
+            }
+            if (c >= 0xC0) {
+                std::ptrdiff_t need = (c >= 0xF0) ? 4 : ((c >= 0xE0) ? 3 : 2);
+                if (need > k) {
+                    --count;
+                    return p - k;
+                }
+                break;
+            }
+        }
+        return p;
+    }
+
+    using u8_scan_t = unsigned char const *(*)(
+        unsigned char const *, unsigned char const *, std::size_t &
+    ) noexcept;
+
+    static unsigned char const *u8_scan_none(
+        unsigned char const *beg, unsigned char const *, std::size_t &
+    ) noexcept {
+        return beg;
+    }
+
+#ifdef OSTD_UTF8_SIMD
+#define OSTD_UTF8_SSE42 __attribute__((target("sse4.2,popcnt")))
+#define OSTD_UTF8_AVX2 __attribute__((target("avx2,popcnt")))
+
+    enum: unsigned char {
+        U8_TOO_SHORT  = 1 << 0, /* lead followed by a lead or ASCII */
+        U8_TOO_LONG   = 1 << 1, /* ASCII followed by continuation */
+        U8_OVERLONG_3 = 1 << 2, /* 11100000 100xxxxx */
+        U8_TOO_LARGE  = 1 << 3, /* above U+10FFFF */
+        U8_SURROGATE  = 1 << 4, /* 11101101 101xxxxx */
+        U8_OVERLONG_2 = 1 << 5, /* 1100000x 10xxxxxx */
+        U8_TOO_LARGE_1000 = 1 << 6, /* above U+10FFFF, 1000xxxx second */
+        U8_OVERLONG_4 = 1 << 6, /* 11110000 1000xxxx */
+        U8_TWO_CONTS  = 1 << 7, /* continuation followed by continuation */
+        U8_CARRY = U8_TOO_SHORT | U8_TOO_LONG | U8_TWO_CONTS
+    };
+
+    /* indexed by the high nibble of the previous byte */
+    alignas(16) static unsigned char const u8_tab_prev_high[16] = {
+        /* 0xxxxxxx: ASCII */
+        U8_TOO_LONG, U8_TOO_LONG, U8_TOO_LONG, U8_TOO_LONG,
+        U8_TOO_LONG, U8_TOO_LONG, U8_TOO_LONG, U8_TOO_LONG,
+        /* 10xxxxxx: continuation */
+        U8_TWO_CONTS, U8_TWO_CONTS, U8_TWO_CONTS, U8_TWO_CONTS,
+        /* 1100xxxx, 1101xxxx: 2 byte lead */
+        U8_TOO_SHORT | U8_OVERLONG_2,
+        U8_TOO_SHORT,
+        /* 1110xxxx: 3 byte lead */
+        U8_TOO_SHORT | U8_OVERLONG_3 | U8_SURROGATE,
+        /* 1111xxxx: 4 byte lead */
+        U8_TOO_SHORT | U8_TOO_LARGE | U8_TOO_LARGE_1000 | U8_OVERLONG_4
+    };
+
+    /* indexed by the low nibble of the previous byte */
+    alignas(16) static unsigned char const u8_tab_prev_low[16] = {
+        U8_CARRY | U8_OVERLONG_2 | U8_OVERLONG_3 | U8_OVERLONG_4,
+        U8_CARRY | U8_OVERLONG_2,
+        U8_CARRY,
+        U8_CARRY,
+        U8_CARRY | U8_TOO_LARGE,
+        U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+        U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+        U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+        U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+        U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+        U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+        U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+        U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+        U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000 | U8_SURROGATE,
+        U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+        U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000
+    };
+
+    /* indexed by the high nibble of the current byte */
+    alignas(16) static unsigned char const u8_tab_cur_high[16] = {
+        /* 0xxxxxxx: ASCII */
+        U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT,
+        U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT,
+        /* 1000xxxx */
+        U8_TOO_LONG | U8_OVERLONG_2 | U8_TWO_CONTS |
+        U8_OVERLONG_3 | U8_TOO_LARGE_1000 | U8_OVERLONG_4,
+        /* 1001xxxx */
+        U8_TOO_LONG | U8_OVERLONG_2 | U8_TWO_CONTS |
+        U8_OVERLONG_3 | U8_TOO_LARGE,
+        /* 101xxxxx */
+        U8_TOO_LONG | U8_OVERLONG_2 | U8_TWO_CONTS |
+        U8_SURROGATE | U8_TOO_LARGE,
+        U8_TOO_LONG | U8_OVERLONG_2 | U8_TWO_CONTS |
+        U8_SURROGATE | U8_TOO_LARGE,
+        /* 11xxxxxx: lead */
+        U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT
+    };
+
+    /* bytes above these at the end of a block start an unfinished sequence;
+     * the scanners use the last 16 or all 32 of them
+     */
+    alignas(32) static unsigned char const u8_tab_incomplete[32] = {
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xEF, 0xDF, 0xBF
+    };
+
+    OSTD_UTF8_SSE42 static inline __m128i u8_load_sse42(
+        unsigned char const *p
+    ) noexcept {
+        return _mm_loadu_si128(reinterpret_cast<__m128i const *>(p));
+    }
+
+    OSTD_UTF8_SSE42 static inline __m128i u8_check_sse42(
+        __m128i in, __m128i prev
+    ) noexcept {
+        __m128i lo4 = _mm_set1_epi8(0x0F);
+        __m128i prev1 = _mm_alignr_epi8(in, prev, 15);
+        __m128i err = _mm_and_si128(_mm_and_si128(
+            _mm_shuffle_epi8(
+                u8_load_sse42(u8_tab_prev_high),
+                _mm_and_si128(_mm_srli_epi16(prev1, 4), lo4)
+            ),
+            _mm_shuffle_epi8(
+                u8_load_sse42(u8_tab_prev_low), _mm_and_si128(prev1, lo4)
+            )
+        ), _mm_shuffle_epi8(
+            u8_load_sse42(u8_tab_cur_high),
+            _mm_and_si128(_mm_srli_epi16(in, 4), lo4)
+        ));
+        /* only 111xxxxx 2 back and 1111xxxx 3 back get the high bit */
+        __m128i must23 = _mm_or_si128(
+            _mm_subs_epu8(_mm_alignr_epi8(in, prev, 14), _mm_set1_epi8(0x60)),
+            _mm_subs_epu8(_mm_alignr_epi8(in, prev, 13), _mm_set1_epi8(0x70))
+        );
+        return _mm_xor_si128(
+            _mm_and_si128(must23, _mm_set1_epi8(char(0x80))), err
+        );
+    }
+
+    OSTD_UTF8_SSE42 static unsigned char const *u8_scan_sse42(
+        unsigned char const *beg, unsigned char const *end, std::size_t &count
+    ) noexcept {
+        __m128i prev = _mm_setzero_si128();
+        __m128i imax = u8_load_sse42(u8_tab_incomplete + 16);
+        __m128i cmax = _mm_set1_epi8(char(0xBF));
+        bool incomplete = false;
+        std::size_t n = 0;
+        auto *p = beg;
+        for (; (end - p) >= 16; p += 16) {
+            __m128i in = u8_load_sse42(p);
+            if (!_mm_movemask_epi8(in) && !incomplete) {
+                n += 16;
+                prev = in;
+                continue;
+            }
+            __m128i err = u8_check_sse42(in, prev);
+            if (!_mm_testz_si128(err, err)) {
+                break;
+            }
+            n += std::size_t(__builtin_popcount(unsigned(
+                _mm_movemask_epi8(_mm_cmpgt_epi8(in, cmax))
+            )));
+            __m128i inc = _mm_subs_epu8(in, imax);
+            incomplete = !_mm_testz_si128(inc, inc);
+            prev = in;
+        }
+        count += n;
+        return u8_seq_start(beg, p, count);
+    }
+
+    OSTD_UTF8_AVX2 static inline __m256i u8_load_avx2(
+        unsigned char const *p
+    ) noexcept {
+        return _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p));
+    }
+
+    OSTD_UTF8_AVX2 static inline __m256i u8_table_avx2(
+        unsigned char const *p
+    ) noexcept {
+        return _mm256_broadcastsi128_si256(
+            _mm_load_si128(reinterpret_cast<__m128i const *>(p))
+        );
+    }
+
+    OSTD_UTF8_AVX2 static inline __m256i u8_check_avx2(
+        __m256i in, __m256i prev
+    ) noexcept {
+        /* the lanes are shifted separately, so bring in the ones before */
+        __m256i cross = _mm256_permute2x128_si256(prev, in, 0x21);
+        __m256i lo4 = _mm256_set1_epi8(0x0F);
+        __m256i prev1 = _mm256_alignr_epi8(in, cross, 15);
+        __m256i err = _mm256_and_si256(_mm256_and_si256(
+            _mm256_shuffle_epi8(
+                u8_table_avx2(u8_tab_prev_high),
+                _mm256_and_si256(_mm256_srli_epi16(prev1, 4), lo4)
+            ),
+            _mm256_shuffle_epi8(
+                u8_table_avx2(u8_tab_prev_low), _mm256_and_si256(prev1, lo4)
+            )
+        ), _mm256_shuffle_epi8(
+            u8_table_avx2(u8_tab_cur_high),
+            _mm256_and_si256(_mm256_srli_epi16(in, 4), lo4)
+        ));
+        __m256i must23 = _mm256_or_si256(
+            _mm256_subs_epu8(
+                _mm256_alignr_epi8(in, cross, 14), _mm256_set1_epi8(0x60)
+            ),
+            _mm256_subs_epu8(
+                _mm256_alignr_epi8(in, cross, 13), _mm256_set1_epi8(0x70)
+            )
+        );
+        return _mm256_xor_si256(
+            _mm256_and_si256(must23, _mm256_set1_epi8(char(0x80))), err
+        );
+    }
+
+    OSTD_UTF8_AVX2 static unsigned char const *u8_scan_avx2(
+        unsigned char const *beg, unsigned char const *end, std::size_t &count
+    ) noexcept {
+        __m256i prev = _mm256_setzero_si256();
+        __m256i imax = u8_load_avx2(u8_tab_incomplete);
+        __m256i cmax = _mm256_set1_epi8(char(0xBF));
+        bool incomplete = false;
+        std::size_t n = 0;
+        auto *p = beg;
+        for (; (end - p) >= 32; p += 32) {
+            __m256i in = u8_load_avx2(p);
+            if (!_mm256_movemask_epi8(in) && !incomplete) {
+                n += 32;
+                prev = in;
+                continue;
+            }
+            __m256i err = u8_check_avx2(in, prev);
+            if (!_mm256_testz_si256(err, err)) {
+                break;
+            }
+            n += std::size_t(__builtin_popcount(unsigned(
+                _mm256_movemask_epi8(_mm256_cmpgt_epi8(in, cmax))
+            )));
+            __m256i inc = _mm256_subs_epu8(in, imax);
+            incomplete = !_mm256_testz_si256(inc, inc);
+            prev = in;
+        }
+        count += n;
+        /* the rest may still fit a smaller block */
+        return u8_scan_sse42(u8_seq_start(beg, p, count), end, count);
+    }
+
+#undef OSTD_UTF8_AVX2
+#undef OSTD_UTF8_SSE42
+#endif /* OSTD_UTF8_SIMD */
+
+    static u8_scan_t u8_scan_get() noexcept {
+#ifdef OSTD_UTF8_SIMD
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("popcnt")) {
+            if (__builtin_cpu_supports("avx2")) {
+                return u8_scan_avx2;
+            }
+            if (__builtin_cpu_supports("sse4.2")) {
+                return u8_scan_sse42;
+            }
+        }
+#endif
+        return u8_scan_none;
+    }
+
+    /* the number of valid code points, with beg advanced past them */
+    static inline std::size_t u8_length(
+        unsigned char const *&beg, unsigned char const *end
+    ) noexcept {
+        static u8_scan_t const scan = u8_scan_get();
+        std::size_t ret = 0;
+        beg = scan(beg, end, ret);
+        return ret + u8_length_scalar(beg, end);
+    }
+
     OSTD_EXPORT std::size_t encode(
         char (&ret)[4], char32_t ch
     ) noexcept {
@@ -208,6 +557,262 @@ namespace detail {
         return 2;
     }
 
+    /* bulk transcoding
+     *
+     * Runs of code units that stay a single unit in both encodings (ASCII
+     * when UTF-8 is involved, non-surrogate BMP code points otherwise) are
+     * widened or narrowed directly, 16 bytes at a time with SSE2; anything
+     * else goes through decoding and encoding of a single code point.
+     */
+
+    static inline std::size_t tc_decode(
+        char const *beg, char const *end, char32_t &ch
+    ) noexcept {
+        return u8_decode(
+            reinterpret_cast<unsigned char const *>(beg),
+            reinterpret_cast<unsigned char const *>(end), ch
+        );
+    }
+
+    static inline std::size_t tc_decode(
+        char16_t const *beg, char16_t const *end, char32_t &ch
+    ) noexcept {
+        std::size_t n = u16_decode(beg, end, ch);
+        /* unpaired trail surrogates cannot be encoded */
+        if ((n == 1) && (ch >= 0xDC00) && (ch <= 0xDFFF)) {
+            return 0;
+        }
+        return n;
+    }
+
+    static inline std::size_t tc_decode(
+        char32_t const *beg, char32_t const *end, char32_t &ch
+    ) noexcept {
+        if ((beg == end) || is_invalid_u32(*beg)) {
+            return 0;
+        }
+        ch = *beg;
+        return 1;
+    }
+
+    static inline std::size_t tc_encode(char32_t (&ret)[1], char32_t ch) {
+        ret[0] = ch;
+        return 1;
+    }
+
+    template<typename C>
+    inline char32_t tc_unit(C c) noexcept {
+        return char32_t(std::make_unsigned_t<C>(c));
+    }
+
+    /* whether a unit is the same single unit in both encodings */
+    template<typename OC, typename IC>
+    inline bool tc_simple(char32_t c) noexcept {
+        if constexpr(std::is_same_v<IC, char> || std::is_same_v<OC, char>) {
+            return (c <= 0x7F);
+        } else if constexpr(
+            std::is_same_v<IC, char16_t> || std::is_same_v<OC, char16_t>
+        ) {
+            return ((c < 0xD800) || ((c >= 0xE000) && (c <= 0xFFFF)));
+        } else {
+            return !is_invalid_u32(c);
+        }
+    }
+
+#if defined(OSTD_UTF8_SIMD) && defined(__SSE2__)
+    static inline __m128i tc_load(void const *p) noexcept {
+        return _mm_loadu_si128(static_cast<__m128i const *>(p));
+    }
+
+    static inline void tc_store(void *p, __m128i v) noexcept {
+        _mm_storeu_si128(static_cast<__m128i *>(p), v);
+    }
+
+    /* 16 input bytes at a time, while all of them are simple */
+    template<typename OC, typename IC>
+    inline void tc_run_sse2(
+        OC *&op, IC const *&ip, IC const *iend
+    ) noexcept {
+        constexpr std::size_t N = 16 / sizeof(IC);
+        __m128i z = _mm_setzero_si128();
+        for (; std::size_t(iend - ip) >= N; ip += N) {
+            __m128i v = tc_load(ip);
+            if constexpr(std::is_same_v<IC, char>) {
+                if (_mm_movemask_epi8(v)) {
+                    return;
+                }
+                __m128i lo = _mm_unpacklo_epi8(v, z);
+                __m128i hi = _mm_unpackhi_epi8(v, z);
+                if constexpr(std::is_same_v<OC, char16_t>) {
+                    tc_store(op, lo);
+                    tc_store(op + 8, hi);
+                } else {
+                    tc_store(op,      _mm_unpacklo_epi16(lo, z));
+                    tc_store(op + 4,  _mm_unpackhi_epi16(lo, z));
+                    tc_store(op + 8,  _mm_unpacklo_epi16(hi, z));
+                    tc_store(op + 12, _mm_unpackhi_epi16(hi, z));
+                }
+            } else if constexpr(std::is_same_v<OC, char>) {
+                /* ASCII if nothing above the low 7 bits */
+                __m128i mask = std::is_same_v<IC, char16_t>
+                    ? _mm_set1_epi16(short(0xFF80))
+                    : _mm_set1_epi32(int(0xFFFFFF80));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(
+                    v, mask
+                ), z)) != 0xFFFF) {
+                    return;
+                }
+                if constexpr(std::is_same_v<IC, char16_t>) {
+                    _mm_storel_epi64(
+                        reinterpret_cast<__m128i *>(op), _mm_packus_epi16(v, z)
+                    );
+                } else {
+                    std::int32_t w = _mm_cvtsi128_si32(
+                        _mm_packus_epi16(_mm_packs_epi32(v, z), z)
+                    );
+                    std::memcpy(op, &w, sizeof(w));
+                }
+            } else {
+                /* UTF-16 to UTF-32: no surrogates */
+                __m128i sur = _mm_cmpeq_epi16(
+                    _mm_and_si128(v, _mm_set1_epi16(short(0xF800))),
+                    _mm_set1_epi16(short(0xD800))
+                );
+                if (_mm_movemask_epi8(sur)) {
+                    return;
+                }
+                tc_store(op, _mm_unpacklo_epi16(v, z));
+                tc_store(op + 4, _mm_unpackhi_epi16(v, z));
+            }
+            op += N;
+        }
+    }
+#endif
+
+    template<typename OC, typename IC>
+    inline void tc_run(
+        OC *&op, OC *oend, IC const *&ip, IC const *iend
+    ) noexcept {
+        auto *rend = ip + std::min(
+            std::size_t(iend - ip), std::size_t(oend - op)
+        );
+#if defined(OSTD_UTF8_SIMD) && defined(__SSE2__)
+        if constexpr(
+            !std::is_same_v<OC, IC> && !std::is_same_v<OC, char16_t>
+        ) {
+            tc_run_sse2(op, ip, rend);
+        } else if constexpr(
+            std::is_same_v<OC, char16_t> && std::is_same_v<IC, char>
+        ) {
+            tc_run_sse2(op, ip, rend);
+        }
+#endif
+        for (; ip != rend; ++ip, ++op) {
+            auto c = tc_unit(*ip);
+            if (!tc_simple<OC, IC>(c)) {
+                break;
+            }
+            *op = OC(c);
+        }
+    }
+
+    template<typename OC, typename IC>
+    inline void tc_transcode(
+        OC *&obeg, OC *oend, IC const *&ibeg, IC const *iend
+    ) noexcept {
+        if constexpr(std::is_same_v<OC, char> && std::is_same_v<IC, char>) {
+            /* validate what fits in bulk, then copy */
+            auto *ub = reinterpret_cast<unsigned char const *>(ibeg);
+            auto *ue = ub + std::min(
+                std::size_t(iend - ibeg), std::size_t(oend - obeg)
+            );
+            auto *up = ub;
+            u8_length(up, ue);
+            std::size_t n = std::size_t(up - ub);
+            std::memcpy(obeg, ibeg, n);
+            obeg += n;
+            ibeg += n;
+            return;
+        }
+        for (;;) {
+            tc_run(obeg, oend, ibeg, iend);
+            char32_t ch;
+            std::size_t n = tc_decode(ibeg, iend, ch);
+            if (!n) {
+                return;
+            }
+            OC buf[4 / sizeof(OC)];
+            std::size_t m;
+            if constexpr(std::is_same_v<OC, char32_t>) {
+                m = tc_encode(buf, ch);
+            } else {
+                m = encode(buf, ch);
+            }
+            if (std::size_t(oend - obeg) < m) {
+                return;
+            }
+            for (std::size_t i = 0; i < m; ++i) {
+                *obeg++ = buf[i];
+            }
+            ibeg += n;
+        }
+    }
+
+    template<typename IC>
+    inline std::size_t tc_size(
+        IC const *beg, IC const *end, std::size_t bits
+    ) noexcept {
+        std::size_t ret = 0;
+        if constexpr(std::is_same_v<IC, char>) {
+            auto *ub = reinterpret_cast<unsigned char const *>(beg);
+            auto *ue = ub + (end - beg);
+            auto *up = ub;
+            ret = u8_length(up, ue);
+            if (bits == 8) {
+                return std::size_t(up - ub);
+            } else if (bits == 16) {
+                /* 4-byte sequences become surrogate pairs, so count their
+                 * leads, a word at a time (the high bit of every byte ends
+                 * up set if the high 4 bits of that byte were all set)
+                 */
+                constexpr std::size_t Hbits =
+                    std::numeric_limits<std::size_t>::max() / 0xFF * 0x80;
+                while (std::size_t(up - ub) >= sizeof(std::size_t)) {
+                    std::size_t w;
+                    std::memcpy(&w, ub, sizeof(w));
+                    w &= (w << 1) & (w << 2) & (w << 3) & Hbits;
+                    for (; w; w &= w - 1) {
+                        ++ret;
+                    }
+                    ub += sizeof(w);
+                }
+                for (; ub != up; ++ub) {
+                    ret += (*ub >= 0xF0);
+                }
+            }
+            return ret;
+        } else {
+            for (char32_t ch;;) {
+                for (; (beg != end) && (tc_unit(*beg) <= 0x7F); ++beg) {
+                    ++ret;
+                }
+                std::size_t n = tc_decode(beg, end, ch);
+                if (!n) {
+                    break;
+                }
+                beg += n;
+                if (bits == 32) {
+                    ++ret;
+                } else if (bits == 16) {
+                    ret += 1 + (ch > 0xFFFF);
+                } else {
+                    ret += 1 + (ch > 0x7F) + (ch > 0x7FF) + (ch > 0xFFFF);
+                }
+            }
+        }
+        return ret;
+    }
+
     template<typename C>
     inline std::size_t length(
         basic_char_range<C const> &r, basic_char_range<C const> &cont
@@ -300,7 +905,11 @@ OSTD_EXPORT bool decode(wstring_range &r, char32_t &ret) noexcept {
 }
 
 OSTD_EXPORT std::size_t length(string_range r, string_range &cont) noexcept {
-    return detail::length(r, cont);
+    auto *beg = reinterpret_cast<unsigned char const *>(r.data());
+    auto *p = beg;
+    std::size_t ret = detail::u8_length(p, beg + r.size());
+    cont = r.slice(std::size_t(p - beg), r.size());
+    return ret;
 }
 
 OSTD_EXPORT std::size_t length(u16string_range r, u16string_range &cont)
@@ -320,7 +929,19 @@ OSTD_EXPORT std::size_t length(wstring_range r, wstring_range &cont) noexcept {
 }
 
 OSTD_EXPORT std::size_t length(string_range r) noexcept {
-    return detail::length(r);
+    auto *p = reinterpret_cast<unsigned char const *>(r.data());
+    auto *end = p + r.size();
+    std::size_t ret = 0;
+    for (;;) {
+        ret += detail::u8_length(p, end);
+        if (p == end) {
+            break;
+        }
+        /* an invalid code unit counts as one */
+        ++p;
+        ++ret;
+    }
+    return ret;
 }
 
 OSTD_EXPORT std::size_t length(u16string_range r) noexcept {
@@ -335,6 +956,91 @@ OSTD_EXPORT std::size_t length(wstring_range r) noexcept {
     return detail::length(r);
 }
 
+OSTD_EXPORT bool validate(string_range r) noexcept {
+    auto *p = reinterpret_cast<unsigned char const *>(r.data());
+    auto *end = p + r.size();
+    detail::u8_length(p, end);
+    return (p == end);
+}
+
+namespace detail {
+    OSTD_EXPORT void transcode(
+        char *&obeg, char *oend, char const *&ibeg, char const *iend
+    ) noexcept {
+        tc_transcode(obeg, oend, ibeg, iend);
+    }
+
+    OSTD_EXPORT void transcode(
+        char *&obeg, char *oend, char16_t const *&ibeg, char16_t const *iend
+    ) noexcept {
+        tc_transcode(obeg, oend, ibeg, iend);
+    }
+
+    OSTD_EXPORT void transcode(
+        char *&obeg, char *oend, char32_t const *&ibeg, char32_t const *iend
+    ) noexcept {
+        tc_transcode(obeg, oend, ibeg, iend);
+    }
+
+    OSTD_EXPORT void transcode(
+        char16_t *&obeg, char16_t *oend, char const *&ibeg, char const *iend
+    ) noexcept {
+        tc_transcode(obeg, oend, ibeg, iend);
+    }
+
+    OSTD_EXPORT void transcode(
+        char16_t *&obeg, char16_t *oend,
+        char16_t const *&ibeg, char16_t const *iend
+    ) noexcept {
+        tc_transcode(obeg, oend, ibeg, iend);
+    }
+
+    OSTD_EXPORT void transcode(
+        char16_t *&obeg, char16_t *oend,
+        char32_t const *&ibeg, char32_t const *iend
+    ) noexcept {
+        tc_transcode(obeg, oend, ibeg, iend);
+    }
+
+    OSTD_EXPORT void transcode(
+        char32_t *&obeg, char32_t *oend, char const *&ibeg, char const *iend
+    ) noexcept {
+        tc_transcode(obeg, oend, ibeg, iend);
+    }
+
+    OSTD_EXPORT void transcode(
+        char32_t *&obeg, char32_t *oend,
+        char16_t const *&ibeg, char16_t const *iend
+    ) noexcept {
+        tc_transcode(obeg, oend, ibeg, iend);
+    }
+
+    OSTD_EXPORT void transcode(
+        char32_t *&obeg, char32_t *oend,
+        char32_t const *&ibeg, char32_t const *iend
+    ) noexcept {
+        tc_transcode(obeg, oend, ibeg, iend);
+    }
+
+    OSTD_EXPORT std::size_t transcoded_size(
+        string_range r, std::size_t bits
+    ) noexcept {
+        return tc_size(r.data(), r.data() + r.size(), bits);
+    }
+
+    OSTD_EXPORT std::size_t transcoded_size(
+        u16string_range r, std::size_t bits
+    ) noexcept {
+        return tc_size(r.data(), r.data() + r.size(), bits);
+    }
+
+    OSTD_EXPORT std::size_t transcoded_size(
+        u32string_range r, std::size_t bits
+    ) noexcept {
+        return tc_size(r.data(), r.data() + r.size(), bits);
+    }
+} /* namespace detail */
+
 /* unicode-aware ctype
  * the other ones use custom tables for lookups
  */
@@ -393,110 +1099,6 @@ OSTD_EXPORT bool isxdigit(char32_t c) noexcept {
     return ((uc >= 'a') && (uc <= 'f'));
 }
 
-inline int codepoint_cmp1(void const *a, void const *b) noexcept {
-    char32_t c1 = *static_cast<char32_t const *>(a);
-    char32_t c2 = *static_cast<char32_t const *>(b);
-    return (int(c1) - int(c2));
-}
-
-inline int codepoint_cmp2(void const *a, void const *b) noexcept {
-    char32_t        c = *static_cast<char32_t const *>(a);
-    char32_t const *p =  static_cast<char32_t const *>(b);
-    if ((c >= p[0]) && (c <= p[1])) {
-        return 0;
-    }
-    return (int(c) - int(p[0]));
-}
-
-template<
-    std::size_t RN, std::size_t RS,
-    std::size_t L1N, std::size_t L1S,
-    std::size_t L2N, std::size_t L2S,
-    std::size_t SN, std::size_t SS
->
-struct uctype_func {
-    template<std::size_t N, std::size_t S>
-    static char32_t *search(
-        char32_t c, void const *arr, int (*cmp)(void const *, void const *)
-    ) noexcept {
-        return static_cast<char32_t *>(std::bsearch(&c, arr, N / S, S, cmp));
-    }
-
-    static bool do_is(
-        char32_t c,
-        void const *ranges  [[maybe_unused]],
-        void const *laces1  [[maybe_unused]],
-        void const *laces2  [[maybe_unused]],
-        void const *singles [[maybe_unused]]
-    ) noexcept {
-        if constexpr(RN != 0) {
-            char32_t *found = search<RN, RS>(c, ranges, codepoint_cmp2);
-            if (found) {
-                return true;
-            }
-        }
-        if constexpr(L1N != 0) {
-            char32_t *found = search<L1N, L1S>(c, laces1, codepoint_cmp2);
-            if (found) {
-                return !((c - found[0]) % 2);
-            }
-        }
-        if constexpr(L2N != 0) {
-            char32_t *found = search<L2N, L2S>(c, laces2, codepoint_cmp2);
-            if (found) {
-                return !((c - found[0]) % 2);
-            }
-        }
-        if constexpr(SN != 0) {
-            char32_t *found = search<SN, SS>(c, singles, codepoint_cmp1);
-            if (found) {
-                return true;
-            }
-        }
-        return false;
-    }
-
-    static char32_t do_to(
-        char32_t c,
-        void const *ranges  [[maybe_unused]],
-        void const *laces1  [[maybe_unused]],
-        void const *laces2  [[maybe_unused]],
-        void const *singles [[maybe_unused]]
-    ) noexcept {
-        if constexpr(RN != 0) {
-            char32_t *found = search<RN, RS>(c, ranges, codepoint_cmp2);
-            if (found) {
-                return (found[2] + (c - found[0]));
-            }
-        }
-        if constexpr(L1N != 0) {
-            char32_t *found = search<L1N, L1S>(c, laces1, codepoint_cmp2);
-            if (found) {
-                if ((c - found[0]) % 2) {
-                    return c;
-                }
-                return c + 1;
-            }
-        }
-        if constexpr(L2N != 0) {
-            char32_t *found = search<L2N, L2S>(c, laces2, codepoint_cmp2);
-            if (found) {
-                if ((c - found[0]) % 2) {
-                    return c;
-                }
-                return c - 1;
-            }
-        }
-        if constexpr(SN != 0) {
-            char32_t *found = search<SN, SS>(c, singles, codepoint_cmp1);
-            if (found) {
-                return found[1];
-            }
-        }
-        return c;
-    }
-};
-
 /* these are geneated */
 OSTD_EXPORT bool isalpha(char32_t c) noexcept;
 OSTD_EXPORT bool iscntrl(char32_t c) noexcept;
@@ -561,11 +1163,123 @@ OSTD_EXPORT char32_t toupper(char32_t c) noexcept {
 #endif /* !OSTD_NO_UNICODE_TABLES */
 
 namespace detail {
+    inline char32_t ascii_tolower(char32_t c) noexcept {
+        return c | (char32_t((c - 'A') < 26) << 5);
+    }
+
+    inline std::size_t case_decode(
+        unsigned char const *beg, unsigned char const *end, char32_t &c
+    ) noexcept {
+        return u8_decode(beg, end, c);
+    }
+
+    inline std::size_t case_decode(
+        char16_t const *beg, char16_t const *end, char32_t &c
+    ) noexcept {
+        return u16_decode(beg, end, c);
+    }
+
+    inline std::size_t case_decode(
+        char32_t const *, char32_t const *, char32_t &
+    ) noexcept {
+        return 1;
+    }
+
+    /* the next code point lowercased, or the code unit if it's invalid */
+    template<typename C>
+    inline char32_t case_next(C const *&beg, C const *end) noexcept {
+        auto c = char32_t(*beg);
+        if (c <= 0x7F) {
+            ++beg;
+            return ascii_tolower(c);
+        }
+        std::size_t n = case_decode(beg, end, c);
+        beg += n ? n : 1;
+        return utf::tolower(c);
+    }
+
+#if defined(OSTD_UTF8_SIMD) && defined(__SSE2__)
+    inline __m128i case_tolower_sse2(__m128i v) noexcept {
+        /* 'A'..'Z' become the 26 lowest signed values */
+        __m128i t = _mm_add_epi8(v, _mm_set1_epi8(char(0x80 - 'A')));
+        __m128i up = _mm_cmpgt_epi8(_mm_set1_epi8(char(0x80 + 26)), t);
+        return _mm_or_si128(v, _mm_and_si128(up, _mm_set1_epi8(0x20)));
+    }
+#endif
+
+    /* skip the part of both strings that is ASCII and equal with any case,
+     * 16 bytes at a time
+     */
+    template<typename C>
+    inline void case_skip_ascii(
+        C const *&beg1, C const *end1, C const *&beg2, C const *end2
+    ) noexcept {
+#if defined(OSTD_UTF8_SIMD) && defined(__SSE2__)
+        if constexpr(sizeof(C) == 1) {
+            while (((end1 - beg1) >= 16) && ((end2 - beg2) >= 16)) {
+                __m128i a = _mm_loadu_si128(
+                    reinterpret_cast<__m128i const *>(beg1)
+                );
+                __m128i b = _mm_loadu_si128(
+                    reinterpret_cast<__m128i const *>(beg2)
+                );
+                if (_mm_movemask_epi8(_mm_or_si128(a, b))) {
+                    return;
+                }
+                unsigned m = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(
+                    case_tolower_sse2(a), case_tolower_sse2(b)
+                )));
+                if (m != 0xFFFF) {
+                    auto n = __builtin_ctz(~m);
+                    beg1 += n;
+                    beg2 += n;
+                    return;
+                }
+                beg1 += 16;
+                beg2 += 16;
+            }
+        }
+#endif
+        while ((beg1 != end1) && (beg2 != end2)) {
+            auto c1 = char32_t(*beg1), c2 = char32_t(*beg2);
+            if (
+                (c1 > 0x7F) || (c2 > 0x7F) ||
+                (ascii_tolower(c1) != ascii_tolower(c2))
+            ) {
+                return;
+            }
+            ++beg1;
+            ++beg2;
+        }
+    }
+
+    /* compare until a difference or the end of either string,
+     * leaving both strings past the equal part
+     */
+    template<typename C>
+    inline int case_compare_part(
+        C const *&beg1, C const *end1, C const *&beg2, C const *end2
+    ) noexcept {
+        for (;;) {
+            case_skip_ascii(beg1, end1, beg2, end2);
+            if ((beg1 == end1) || (beg2 == end2)) {
+                return 0;
+            }
+            auto *nbeg1 = beg1, *nbeg2 = beg2;
+            int d = int(case_next(nbeg1, end1)) - int(case_next(nbeg2, end2));
+            if (d) {
+                return d;
+            }
+            beg1 = nbeg1;
+            beg2 = nbeg2;
+        }
+    }
+
     template<typename C>
     inline int case_compare(
         C const *beg1, C const *end1,
         C const *beg2, C const *end2
-    ) {
+    ) noexcept {
         auto s1l = std::size_t(end1 - beg1);
         auto s2l = std::size_t(end2 - beg2);
 
@@ -573,43 +1287,71 @@ namespace detail {
         end1 = beg1 + ms;
         end2 = beg2 + ms;
 
+        if (int d = case_compare_part(beg1, end1, beg2, end2); d) {
+            return d;
+        }
+        return (s1l < s2l) ? -1 : ((s1l > s2l) ? 1 : 0);
+    }
+
+    template<typename C>
+    inline bool case_starts_with(
+        C const *beg1, C const *end1,
+        C const *beg2, C const *end2
+    ) noexcept {
+        return !case_compare_part(beg1, end1, beg2, end2) && (beg2 == end2);
+    }
+
+    template<typename C>
+    inline std::size_t case_find(
+        C const *beg1, C const *end1,
+        C const *beg2, C const *end2
+    ) noexcept {
+        auto *beg = beg1;
+        if (beg2 == end2) {
+            return 0;
+        }
+        /* an ASCII first character can be looked for quickly; other code
+         * points may still lowercase into it, so those are always tried
+         */
+        auto first = char32_t(*beg2);
+        bool ascii = (first <= 0x7F);
+        first = ascii_tolower(first);
         while (beg1 != end1) {
-            auto ldec = char32_t(*beg1);
-            auto rdec = char32_t(*beg2);
-            if constexpr(std::is_same_v<C, char32_t>) {
-                ++beg1;
-                ++beg2;
-            } else if constexpr(std::is_same_v<C, char16_t>) {
-                std::size_t ndec;
-                if ((ldec <= 0x7F) || !(ndec = u16_decode(beg1, end1, ldec))) {
-                    ++beg1;
-                } else {
-                    beg1 += ndec;
-                }
-                if ((rdec <= 0x7F) || !(ndec = u16_decode(beg2, end2, rdec))) {
-                    ++beg2;
-                } else {
-                    beg2 += ndec;
+            if (ascii) {
+#if defined(OSTD_UTF8_SIMD) && defined(__SSE2__)
+                if constexpr(sizeof(C) == 1) {
+                    __m128i f = _mm_set1_epi8(char(first));
+                    while ((end1 - beg1) >= 16) {
+                        __m128i v = _mm_loadu_si128(
+                            reinterpret_cast<__m128i const *>(beg1)
+                        );
+                        int m = _mm_movemask_epi8(_mm_or_si128(
+                            _mm_cmpeq_epi8(case_tolower_sse2(v), f), v
+                        ));
+                        if (m) {
+                            beg1 += __builtin_ctz(unsigned(m));
+                            break;
+                        }
+                        beg1 += 16;
+                    }
                 }
-            } else if constexpr(std::is_same_v<C, unsigned char>) {
-                std::size_t ndec;
-                if ((ldec <= 0x7F) || !(ndec = u8_decode(beg1, end1, ldec))) {
-                    ++beg1;
-                } else {
-                    beg1 += ndec;
+#endif
+                for (; beg1 != end1; ++beg1) {
+                    auto c = char32_t(*beg1);
+                    if ((c > 0x7F) || (ascii_tolower(c) == first)) {
+                        break;
+                    }
                 }
-                if ((rdec <= 0x7F) || !(ndec = u8_decode(beg2, end2, rdec))) {
-                    ++beg2;
-                } else {
-                    beg2 += ndec;
+                if (beg1 == end1) {
+                    break;
                 }
             }
-            int d = int(utf::tolower(ldec)) - int(utf::tolower(rdec));
-            if (d) {
-                return d;
+            if (case_starts_with(beg1, end1, beg2, end2)) {
+                return std::size_t(beg1 - beg);
             }
+            case_next(beg1, end1);
         }
-        return (s1l < s2l) ? -1 : ((s1l > s2l) ? 1 : 0);
+        return std::size_t(end1 - beg);
     }
 }
 
@@ -636,9 +1378,291 @@ OSTD_EXPORT int case_compare(wstring_range s1, wstring_range s2) noexcept {
     return detail::case_compare(beg1, beg1 + s1.size(), beg2, beg2 + s2.size());
 }
 
+OSTD_EXPORT bool case_starts_with(string_range a, string_range b) noexcept {
+    auto *beg1 = reinterpret_cast<unsigned char const *>(a.data());
+    auto *beg2 = reinterpret_cast<unsigned char const *>(b.data());
+    return detail::case_starts_with(
+        beg1, beg1 + a.size(), beg2, beg2 + b.size()
+    );
+}
+
+OSTD_EXPORT bool case_starts_with(u16string_range a, u16string_range b)
+    noexcept
+{
+    auto *beg1 = a.data(), *beg2 = b.data();
+    return detail::case_starts_with(
+        beg1, beg1 + a.size(), beg2, beg2 + b.size()
+    );
+}
+
+OSTD_EXPORT bool case_starts_with(u32string_range a, u32string_range b)
+    noexcept
+{
+    auto *beg1 = a.data(), *beg2 = b.data();
+    return detail::case_starts_with(
+        beg1, beg1 + a.size(), beg2, beg2 + b.size()
+    );
+}
+
+OSTD_EXPORT bool case_starts_with(wstring_range a, wstring_range b) noexcept {
+    using C = std::conditional_t<is_wchar_u8, unsigned char, wchar_fixed_t>;
+    auto *beg1 = reinterpret_cast<C const *>(a.data());
+    auto *beg2 = reinterpret_cast<C const *>(b.data());
+    return detail::case_starts_with(
+        beg1, beg1 + a.size(), beg2, beg2 + b.size()
+    );
+}
+
+OSTD_EXPORT string_range case_find(string_range a, string_range b) noexcept {
+    auto *beg1 = reinterpret_cast<unsigned char const *>(a.data());
+    auto *beg2 = reinterpret_cast<unsigned char const *>(b.data());
+    return a.slice(detail::case_find(
+        beg1, beg1 + a.size(), beg2, beg2 + b.size()
+    ), a.size());
+}
+
+OSTD_EXPORT u16string_range case_find(u16string_range a, u16string_range b)
+    noexcept
+{
+    auto *beg1 = a.data(), *beg2 = b.data();
+    return a.slice(detail::case_find(
+        beg1, beg1 + a.size(), beg2, beg2 + b.size()
+    ), a.size());
+}
+
+OSTD_EXPORT u32string_range case_find(u32string_range a, u32string_range b)
+    noexcept
+{
+    auto *beg1 = a.data(), *beg2 = b.data();
+    return a.slice(detail::case_find(
+        beg1, beg1 + a.size(), beg2, beg2 + b.size()
+    ), a.size());
+}
+
+OSTD_EXPORT wstring_range case_find(wstring_range a, wstring_range b)
+    noexcept
+{
+    using C = std::conditional_t<is_wchar_u8, unsigned char, wchar_fixed_t>;
+    auto *beg1 = reinterpret_cast<C const *>(a.data());
+    auto *beg2 = reinterpret_cast<C const *>(b.data());
+    return a.slice(detail::case_find(
+        beg1, beg1 + a.size(), beg2, beg2 + b.size()
+    ), a.size());
+}
+
 } /* namespace utf */
 
+namespace detail {
+    /* the first and the last unit are known to match already */
+    template<typename C>
+    inline bool substr_match(
+        C const *h, C const *n, std::size_t nn
+    ) noexcept {
+        return (nn <= 2) || !std::memcmp(h + 1, n + 1, (nn - 2) * sizeof(C));
+    }
+
+    template<typename C>
+    inline std::size_t substr_find(
+        C const *h, std::size_t hn, C const *n, std::size_t nn
+    ) noexcept {
+        if (!nn) {
+            return 0;
+        }
+        if (nn > hn) {
+            return hn;
+        }
+        C first = n[0], last = n[nn - 1];
+        /* the candidate positions */
+        std::size_t i = 0, e = hn - nn + 1;
+#if defined(OSTD_UTF8_SIMD) && defined(__SSE2__)
+        if constexpr(sizeof(C) == 1) {
+            __m128i vf = _mm_set1_epi8(first), vl = _mm_set1_epi8(last);
+            for (; (i + 16) <= e; i += 16) {
+                unsigned m = unsigned(_mm_movemask_epi8(_mm_and_si128(
+                    _mm_cmpeq_epi8(vf, _mm_loadu_si128(
+                        reinterpret_cast<__m128i const *>(h + i)
+                    )),
+                    _mm_cmpeq_epi8(vl, _mm_loadu_si128(
+                        reinterpret_cast<__m128i const *>(h + i + nn - 1)
+                    ))
+                )));
+                for (; m; m &= m - 1) {
+                    std::size_t j = i + std::size_t(__builtin_ctz(m));
+                    if (substr_match(h + j, n, nn)) {
+                        return j;
+                    }
+                }
+            }
+        }
+#endif
+        for (; i < e; ++i) {
+            if (
+                (h[i] == first) && (h[i + nn - 1] == last) &&
+                substr_match(h + i, n, nn)
+            ) {
+                return i;
+            }
+        }
+        return hn;
+    }
+
+    template<typename C>
+    inline std::size_t substr_rfind(
+        C const *h, std::size_t hn, C const *n, std::size_t nn
+    ) noexcept {
+        if (!nn || (nn > hn)) {
+            return hn;
+        }
+        C first = n[0], last = n[nn - 1];
+        /* the candidate positions, from the end */
+        std::size_t i = hn - nn + 1;
+#if defined(OSTD_UTF8_SIMD) && defined(__SSE2__)
+        if constexpr(sizeof(C) == 1) {
+            __m128i vf = _mm_set1_epi8(first), vl = _mm_set1_epi8(last);
+            for (; i >= 16; i -= 16) {
+                std::size_t b = i - 16;
+                unsigned m = unsigned(_mm_movemask_epi8(_mm_and_si128(
+                    _mm_cmpeq_epi8(vf, _mm_loadu_si128(
+                        reinterpret_cast<__m128i const *>(h + b)
+                    )),
+                    _mm_cmpeq_epi8(vl, _mm_loadu_si128(
+                        reinterpret_cast<__m128i const *>(h + b + nn - 1)
+                    ))
+                )));
+                while (m) {
+                    unsigned k = 31 - unsigned(__builtin_clz(m));
+                    if (substr_match(h + b + k, n, nn)) {
+                        return b + k;
+                    }
+                    m &= ~(1U << k);
+                }
+            }
+        }
+#endif
+        while (i--) {
+            if (
+                (h[i] == first) && (h[i + nn - 1] == last) &&
+                substr_match(h + i, n, nn)
+            ) {
+                return i;
+            }
+        }
+        return hn;
+    }
+
+    OSTD_EXPORT std::size_t find_substr(
+        char const *h, std::size_t hn, char const *n, std::size_t nn
+    ) noexcept {
+        return substr_find(h, hn, n, nn);
+    }
+    OSTD_EXPORT std::size_t find_substr(
+        char16_t const *h, std::size_t hn, char16_t const *n, std::size_t nn
+    ) noexcept {
+        return substr_find(h, hn, n, nn);
+    }
+    OSTD_EXPORT std::size_t find_substr(
+        char32_t const *h, std::size_t hn, char32_t const *n, std::size_t nn
+    ) noexcept {
+        return substr_find(h, hn, n, nn);
+    }
+    OSTD_EXPORT std::size_t rfind_substr(
+        char const *h, std::size_t hn, char const *n, std::size_t nn
+    ) noexcept {
+        return substr_rfind(h, hn, n, nn);
+    }
+    OSTD_EXPORT std::size_t rfind_substr(
+        char16_t const *h, std::size_t hn, char16_t const *n, std::size_t nn
+    ) noexcept {
+        return substr_rfind(h, hn, n, nn);
+    }
+    OSTD_EXPORT std::size_t rfind_substr(
+        char32_t const *h, std::size_t hn, char32_t const *n, std::size_t nn
+    ) noexcept {
+        return substr_rfind(h, hn, n, nn);
+    }
+
+    template<typename C>
+    inline bool any_has(C const *set, std::size_t setn, C c) noexcept {
+        for (std::size_t i = 0; i < setn; ++i) {
+            if (set[i] == c) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template<typename C>
+    inline std::size_t any_find(
+        C const *h, std::size_t hn, C const *set, std::size_t setn
+    ) noexcept {
+        std::size_t i = 0;
+        if constexpr(sizeof(C) == 1) {
+            if (setn == 1) {
+                auto *p = static_cast<C const *>(std::memchr(h, set[0], hn));
+                return p ? std::size_t(p - h) : hn;
+            }
+            if (setn > 16) {
+                bool tab[256] = {};
+                for (std::size_t j = 0; j < setn; ++j) {
+                    tab[static_cast<unsigned char>(set[j])] = true;
+                }
+                for (; i < hn; ++i) {
+                    if (tab[static_cast<unsigned char>(h[i])]) {
+                        return i;
+                    }
+                }
+                return hn;
+            }
+#if defined(OSTD_UTF8_SIMD) && defined(__SSE2__)
+            if (setn) {
+                __m128i vs[16];
+                for (std::size_t j = 0; j < setn; ++j) {
+                    vs[j] = _mm_set1_epi8(set[j]);
+                }
+                for (; (i + 16) <= hn; i += 16) {
+                    __m128i d = _mm_loadu_si128(
+                        reinterpret_cast<__m128i const *>(h + i)
+                    );
+                    __m128i m = _mm_cmpeq_epi8(d, vs[0]);
+                    for (std::size_t j = 1; j < setn; ++j) {
+                        m = _mm_or_si128(m, _mm_cmpeq_epi8(d, vs[j]));
+                    }
+                    if (unsigned mm = unsigned(_mm_movemask_epi8(m)); mm) {
+                        return i + std::size_t(__builtin_ctz(mm));
+                    }
+                }
+            }
+#endif
+        }
+        for (; i < hn; ++i) {
+            if (any_has(set, setn, h[i])) {
+                return i;
+            }
+        }
+        return hn;
+    }
+
+    OSTD_EXPORT std::size_t find_any(
+        char const *h, std::size_t hn, char const *set, std::size_t setn
+    ) noexcept {
+        return any_find(h, hn, set, setn);
+    }
+    OSTD_EXPORT std::size_t find_any(
+        char16_t const *h, std::size_t hn,
+        char16_t const *set, std::size_t setn
+    ) noexcept {
+        return any_find(h, hn, set, setn);
+    }
+    OSTD_EXPORT std::size_t find_any(
+        char32_t const *h, std::size_t hn,
+        char32_t const *set, std::size_t setn
+    ) noexcept {
+        return any_find(h, hn, set, setn);
+    }
+} /* namespace detail */
+
 /* place the vtable in here */
 format_error::~format_error() {}
+scan_error::~scan_error() {}
 
 } /* namespace ostd */
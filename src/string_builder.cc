@@ -0,0 +1,70 @@
+/* String arena implementation.
+ *
+ * This file is part of libostd. See COPYING.md for futher information.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <algorithm>
+
+#include "ostd/string_builder.hh"
+
+namespace ostd {
+
+OSTD_EXPORT void *string_arena::allocate(std::size_t n, std::size_t align) {
+    auto pad = [align](char *p) {
+        return std::size_t(-reinterpret_cast<std::uintptr_t>(p)) & (align - 1);
+    };
+    if (p_cur) {
+        std::size_t off = pad(p_cur);
+        if ((off + n) <= std::size_t(p_end - p_cur)) {
+            char *ret = p_cur + off;
+            p_cur = ret + n;
+            return ret;
+        }
+    }
+    /* blocks kept from before a reset are reused first, in order */
+    std::size_t need = n + align - 1;
+    for (std::size_t i = p_cur ? (p_block + 1) : 0; i < p_blocks.size(); ++i) {
+        if (p_blocks[i].size >= need) {
+            p_block = i;
+            p_cur = p_blocks[i].data.get();
+            p_end = p_cur + p_blocks[i].size;
+            char *ret = p_cur + pad(p_cur);
+            p_cur = ret + n;
+            return ret;
+        }
+    }
+    std::size_t bsize = std::max(need, p_bsize);
+    p_blocks.push_back(block{std::unique_ptr<char[]>{new char[bsize]}, bsize});
+    /* the new block is used from now on, while the ones between the
+     * current one and it are skipped until the next reset
+     */
+    p_block = p_blocks.size() - 1;
+    p_cur = p_blocks.back().data.get();
+    p_end = p_cur + bsize;
+    char *ret = p_cur + pad(p_cur);
+    p_cur = ret + n;
+    return ret;
+}
+
+OSTD_EXPORT void string_arena::reset() noexcept {
+    p_block = 0;
+    if (p_blocks.empty()) {
+        p_cur = p_end = nullptr;
+    } else {
+        p_cur = p_blocks[0].data.get();
+        p_end = p_cur + p_blocks[0].size;
+    }
+}
+
+OSTD_EXPORT std::size_t string_arena::memory_size() const noexcept {
+    std::size_t ret = 0;
+    for (auto &b: p_blocks) {
+        ret += b.size;
+    }
+    return ret;
+}
+
+} /* namespace ostd */
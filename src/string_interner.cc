@@ -0,0 +1,188 @@
+/* String interner implementation.
+ *
+ * This file is part of libostd. See COPYING.md for futher information.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <memory>
+#include <utility>
+#include <algorithm>
+#include <vector>
+#include <optional>
+#include <stdexcept>
+#include <functional>
+
+#include "ostd/string_interner.hh"
+
+namespace ostd {
+
+namespace detail {
+    intern_header const intern_empty[2] = {{0, 0}, {0, 0}};
+
+    static char const *intern_lookup(
+        intern_shard const &sh, std::size_t hash, string_range str
+    ) noexcept {
+        if (sh.table.empty()) {
+            return nullptr;
+        }
+        std::size_t mask = sh.table.size() - 1;
+        for (std::size_t i = hash & mask;; i = (i + 1) & mask) {
+            auto &e = sh.table[i];
+            if (!e.str) {
+                return nullptr;
+            }
+            if (
+                (e.hash == hash) &&
+                (intern_get_header(e.str).size == str.size()) &&
+                !std::memcmp(e.str, str.data(), str.size())
+            ) {
+                return e.str;
+            }
+        }
+    }
+
+    static void intern_insert(
+        std::vector<intern_entry> &table, intern_entry ent
+    ) noexcept {
+        std::size_t mask = table.size() - 1;
+        std::size_t i = ent.hash & mask;
+        while (table[i].str) {
+            i = (i + 1) & mask;
+        }
+        table[i] = ent;
+    }
+} /* namespace detail */
+
+OSTD_EXPORT string_interner::string_interner() {
+    for (auto &seg: p_ids) {
+        seg.store(nullptr, std::memory_order_relaxed);
+    }
+    auto *ids = new char const *[ID_BLOCK];
+    ids[0] = interned_string{}.data();
+    p_ids[0].store(ids, std::memory_order_release);
+}
+
+OSTD_EXPORT string_interner::~string_interner() {
+    for (auto &seg: p_ids) {
+        delete[] seg.load(std::memory_order_relaxed);
+    }
+}
+
+OSTD_EXPORT char const *string_interner::store(
+    detail::intern_shard &sh, string_range str
+) {
+    if (str.size() > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::length_error{"string too long to intern"};
+    }
+    /* the header and zero terminator included, keeping the alignment */
+    constexpr std::size_t hsize = sizeof(detail::intern_header);
+    std::size_t need = (hsize + str.size() + hsize) & ~(hsize - 1);
+    if (need > sh.left) {
+        std::size_t bsize = std::max(need, std::size_t(BLOCK_SIZE));
+        sh.blocks.emplace_back(new char[bsize]);
+        sh.cur = sh.blocks.back().get();
+        sh.left = bsize;
+        sh.allocated += bsize;
+    }
+
+    /* the count also hands out the IDs for all shards at once, so it's
+     * bumped before the ID is published, see string_interner::size()
+     */
+    auto id = p_count.load(std::memory_order_relaxed);
+    do {
+        if (id == std::numeric_limits<std::uint32_t>::max()) {
+            throw std::length_error{"too many interned strings"};
+        }
+    } while (!p_count.compare_exchange_weak(
+        id, id + 1, std::memory_order_relaxed
+    ));
+    ++id;
+
+    char *mem = sh.cur;
+    sh.cur += need;
+    sh.left -= need;
+    detail::intern_header hdr{id, std::uint32_t(str.size())};
+    std::memcpy(mem, &hdr, hsize);
+    std::memcpy(mem + hsize, str.data(), str.size());
+    mem[hsize + str.size()] = '\0';
+    char const *ret = mem + hsize;
+
+    /* publish the ID before the string can be found by other threads */
+    auto idx = (id / ID_BLOCK) + 1;
+    std::size_t seg = 0;
+    while (idx >>= 1) {
+        ++seg;
+    }
+    auto *ids = p_ids[seg].load(std::memory_order_acquire);
+    if (!ids) {
+        auto *nids = new char const *[std::size_t(ID_BLOCK) << seg];
+        if (p_ids[seg].compare_exchange_strong(
+            ids, nids, std::memory_order_acq_rel
+        )) {
+            ids = nids;
+        } else {
+            delete[] nids;
+        }
+    }
+    ids[id - ID_BLOCK * ((1u << seg) - 1)] = ret;
+    return ret;
+}
+
+OSTD_EXPORT interned_string string_interner::intern(string_range str) {
+    if (str.empty()) {
+        return interned_string{};
+    }
+    std::size_t hash = std::hash<string_range>{}(str);
+    auto &sh = p_shards[shard_index(hash)];
+    std::lock_guard<std::mutex> l{sh.lock};
+    if (auto *found = detail::intern_lookup(sh, hash, str); found) {
+        return interned_string{found};
+    }
+    /* keep the load at most a half */
+    if ((sh.used + 1) * 2 > sh.table.size()) {
+        std::vector<detail::intern_entry> ntable(
+            sh.table.empty() ? 64 : (sh.table.size() * 2),
+            detail::intern_entry{0, nullptr}
+        );
+        for (auto &e: sh.table) {
+            if (e.str) {
+                detail::intern_insert(ntable, e);
+            }
+        }
+        sh.table = std::move(ntable);
+    }
+    char const *ret = store(sh, str);
+    detail::intern_insert(sh.table, detail::intern_entry{hash, ret});
+    ++sh.used;
+    return interned_string{ret};
+}
+
+OSTD_EXPORT std::optional<interned_string> string_interner::find(
+    string_range str
+) const {
+    if (str.empty()) {
+        return interned_string{};
+    }
+    std::size_t hash = std::hash<string_range>{}(str);
+    auto &sh = p_shards[shard_index(hash)];
+    std::lock_guard<std::mutex> l{sh.lock};
+    if (auto *found = detail::intern_lookup(sh, hash, str); found) {
+        return interned_string{found};
+    }
+    return std::nullopt;
+}
+
+OSTD_EXPORT std::size_t string_interner::memory_size() const {
+    std::size_t ret = 0;
+    for (auto &sh: p_shards) {
+        std::lock_guard<std::mutex> l{sh.lock};
+        ret += sh.allocated;
+    }
+    return ret;
+}
+
+} /* namespace ostd */